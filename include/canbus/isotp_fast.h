@@ -5,6 +5,7 @@
  */
 
 #include <zephyr/canbus/isotp.h>
+#include <zephyr/sys/dlist.h>
 
 #ifndef ISOTP_FAST_H
 #define ISOTP_FAST_H
@@ -38,7 +39,9 @@ struct isotp_fast_ctx;
  *
  * @param buffer Pointer to a @ref net_buf. Call @ref net_buf_frags_len to
  *               obtain the length of the buffer, then @ref net_buf_linearize to copy the
- *               contents of the buffer into a local buffer.
+ *               contents of the buffer into a local buffer. With
+ *               CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER, the buffer has no fragments and
+ *               its data can be used in place until the callback returns.
  * @param rem_len At present, this should always be zero. In future, this
  *                callback may be called repeatedly as a message's packets arrive to reduce
  *                the need to buffer an entire message in memory before it is dispatched
@@ -114,19 +117,65 @@ struct isotp_fast_opts
     enum isotp_fast_addressing_mode addressing_mode;
 };
 
+#ifdef CONFIG_ISOTP_FAST_RX_STATS
+/**
+ * Reception statistics of a context.
+ */
+struct isotp_fast_rx_stats
+{
+    /** FC.WAIT frames sent because of low buffer memory */
+    uint32_t wait_frames;
+    /** FC frames advertising a smaller block size than configured because of low buffer memory */
+    uint32_t bs_reductions;
+    /** Frames dropped because no receive context was available */
+    uint32_t dropped_no_ctx;
+    /** Frames dropped because no buffer was available */
+    uint32_t dropped_no_buf;
+};
+#endif
+
+struct isotp_fast_timeout;
+
+/**
+ * Callback invoked from interrupt context when a timeout expires.
+ *
+ * @param timeout The expired timeout, use CONTAINER_OF() to get the enclosing object
+ */
+typedef void (*isotp_fast_timeout_handler_t)(struct isotp_fast_timeout *timeout);
+
+/**
+ * Timeout handled by the ISO-TP timer wheel, which drives all protocol timeouts with a single
+ * kernel timer instead of one per transfer.
+ */
+struct isotp_fast_timeout
+{
+    /** node in a slot of the timer wheel */
+    sys_dnode_t node;
+    /** tick of the timer wheel at which the timeout expires */
+    uint32_t expiry;
+    /** callback invoked on expiry */
+    isotp_fast_timeout_handler_t handler;
+};
+
 /**
  * General ISO-TP fast context object.
  */
 struct isotp_fast_ctx
 {
-    /** list of currently in-flight send contexts */
-    sys_slist_t isotp_send_ctx_list;
-    /** list of currently in-flight receive contexts */
-    sys_slist_t isotp_recv_ctx_list;
+    /** hash table of currently in-flight send contexts, keyed by target address */
+    sys_slist_t isotp_send_ctx_buckets[CONFIG_ISOTP_FAST_CTX_HASH_BUCKETS];
+    /** hash table of currently in-flight receive contexts, keyed by sender address */
+    sys_slist_t isotp_recv_ctx_buckets[CONFIG_ISOTP_FAST_CTX_HASH_BUCKETS];
     /** The CAN device to which the context is bound via @ref isotp_fast_bind */
     const struct device *can_dev;
     /** Identifies the CAN filter which filters incoming messages */
     int filter_id;
+#if CONFIG_ISOTP_FAST_RX_ADDR_COUNT > 0
+    /** CAN filters of the addresses added via @ref isotp_fast_add_rx_addr */
+    int rx_addr_filter_ids[CONFIG_ISOTP_FAST_RX_ADDR_COUNT];
+    /** Number of addresses added via @ref isotp_fast_add_rx_addr */
+    uint8_t rx_addr_count;
+#endif
     /** Pointer to context options described above */
     const struct isotp_fast_opts *opts;
     /** Callback that is invoked when a message is received */
@@ -154,6 +203,16 @@ struct isotp_fast_ctx
 #endif
 #ifdef CONFIG_ISOTP_FAST_CUSTOM_ADDRESSING
     isotp_fast_get_tx_addr_callback_t get_tx_addr_callback;
+#endif
+    /**
+     * Work queue running the state machines of this context. May be set before calling
+     * @ref isotp_fast_bind. If NULL, the ISO-TP work queue (with CONFIG_ISOTP_FAST_WORKQUEUE)
+     * or the system work queue is used.
+     */
+    struct k_work_q *work_q;
+#ifdef CONFIG_ISOTP_FAST_RX_STATS
+    /** Reception statistics, each counter is only written from a single context */
+    struct isotp_fast_rx_stats rx_stats;
 #endif
 };
 
@@ -191,15 +250,54 @@ int isotp_fast_bind(struct isotp_fast_ctx *ctx, const struct device *can_dev,
  */
 int isotp_fast_unbind(struct isotp_fast_ctx *ctx);
 
+#if CONFIG_ISOTP_FAST_RX_ADDR_COUNT > 0
+/**
+ * Registers an additional address (or range of addresses) on which the bound context receives
+ * messages, e.g. further logical addresses of the node or a broadcast address.
+ *
+ * Functional (1:N) addressing according to ISO 15765-2 is restricted to single frames, as
+ * flow control from several receivers is not possible. Other frames received on a functional
+ * address are ignored.
+ *
+ * All addresses are removed when the context is unbound.
+ *
+ * @param ctx The bound context
+ * @param rx_addr The address to listen on
+ * @param mask Mask applied to the CAN ID of incoming frames before comparing it to rx_addr
+ * @param functional Whether the address is a functional address
+ *
+ * @returns ISOTP_N_OK on success, or ISOTP_NO_FREE_FILTER if all
+ *          CONFIG_ISOTP_FAST_RX_ADDR_COUNT addresses are in use or no CAN filter is left
+ */
+int isotp_fast_add_rx_addr(struct isotp_fast_ctx *ctx, const struct isotp_fast_addr rx_addr,
+                           uint32_t mask, bool functional);
+#endif
+
 #ifdef CONFIG_ISOTP_FAST_BLOCKING_RECEIVE
 int isotp_fast_recv(struct isotp_fast_ctx *ctx, struct can_filter sender, uint8_t *buf, size_t size,
                     k_timeout_t timeout);
 #endif
 
+#ifdef CONFIG_ISOTP_FAST_RX_STATS
+/**
+ * Get the reception statistics of a context. The counters are reset when
+ * the context is bound.
+ *
+ * @param ctx A pointer to the bound context
+ * @param stats Pointer to the structure to be filled
+ */
+void isotp_fast_get_rx_stats(const struct isotp_fast_ctx *ctx, struct isotp_fast_rx_stats *stats);
+#endif
+
 /**
  * Send a message to a given recipient. If the message fits within a
  * CAN frame, it will be sent synchronously. If not, it will be sent
- * asynchronously.
+ * asynchronously. Messages longer than 4095 bytes are announced with the
+ * 32-bit escape sequence of ISO 15765-2:2016 in the first frame.
+ *
+ * If a transfer to the same recipient is ongoing, the message is queued
+ * (see CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH) and sent once all previous
+ * messages to this recipient were sent.
  *
  * @param ctx The bound context on which the message should be sent
  * @param data A pointer to the data containing the message to send
@@ -208,11 +306,116 @@ int isotp_fast_recv(struct isotp_fast_ctx *ctx, struct can_filter sender, uint8_
  * @param sent_cb_arg A pointer to data to be supplied to the callback
  *                    that will be invoked when the message is sent.
  *
- * @returns 0 on success.
+ * @returns 0 on success, -EBUSY if the queue of the recipient is full or
+ *          -ENOBUFS if no queue entries are left.
  */
 int isotp_fast_send(struct isotp_fast_ctx *ctx, const uint8_t *data, size_t len,
                     const struct isotp_fast_addr target_addr, void *sent_cb_arg);
 
+/**
+ * Send a message stored in a chain of buffer fragments to a given recipient,
+ * e.g. a protocol header followed by a payload located elsewhere, without
+ * copying it into a contiguous buffer first.
+ *
+ * The reference to the buffer is transferred to the ISO-TP layer, which
+ * releases it once the message was sent or the transmission failed. This also
+ * applies if an error is returned, so the caller must not access the buffer
+ * after calling this function.
+ *
+ * @param ctx The bound context on which the message should be sent
+ * @param buf Head of the buffer chain containing the message to send
+ * @param target_addr The CAN ID identifying the recipient.
+ * @param sent_cb_arg A pointer to data to be supplied to the callback
+ *                    that will be invoked when the message is sent.
+ *
+ * @returns 0 on success.
+ */
+int isotp_fast_send_buf(struct isotp_fast_ctx *ctx, struct net_buf *buf,
+                        const struct isotp_fast_addr target_addr, void *sent_cb_arg);
+
+/**
+ * Max. time in milliseconds a timeout can be started with, so that its expiry tick does not
+ * wrap around on the timer wheel
+ */
+#define ISOTP_FAST_TIMEOUT_MAX_MS (INT32_MAX / 2)
+
+/**
+ * Initializes a timeout. Must be called once before the timeout is started.
+ *
+ * @param timeout Pointer to the timeout
+ * @param handler Callback invoked from interrupt context when the timeout expires
+ */
+void isotp_fast_timeout_init(struct isotp_fast_timeout *timeout,
+                             isotp_fast_timeout_handler_t handler);
+
+/**
+ * Starts a timeout, or restarts it if it is already pending. The timeout expires no earlier
+ * than after the given time and no later than one tick of CONFIG_ISOTP_FAST_TIMER_WHEEL_TICK_MS
+ * after that.
+ *
+ * @param timeout Pointer to the timeout
+ * @param ms Time until the timeout expires in milliseconds, at most ISOTP_FAST_TIMEOUT_MAX_MS
+ */
+void isotp_fast_timeout_start(struct isotp_fast_timeout *timeout, uint32_t ms);
+
+/**
+ * Stops a pending timeout. Stopping a timeout which is not pending has no effect.
+ *
+ * @param timeout Pointer to the timeout
+ */
+void isotp_fast_timeout_stop(struct isotp_fast_timeout *timeout);
+
+/**
+ * Sends a message to a functional (1:N) address, e.g. a broadcast address. As flow control
+ * from several receivers is not possible, the message must fit into a single frame.
+ *
+ * The message is sent synchronously and sent_callback is invoked before returning.
+ *
+ * @param ctx A pointer to the bound context
+ * @param data A pointer to the data to be sent
+ * @param len The length of the data
+ * @param target_addr The functional address of the recipients
+ * @param cb_arg A pointer to data to be supplied to sent_callback
+ *
+ * @returns ISOTP_N_OK on success, ISOTP_N_BUFFER_OVERFLW if the message does not fit into a
+ *          single frame or a CAN error code
+ */
+int isotp_fast_send_functional(struct isotp_fast_ctx *ctx, const uint8_t *data, size_t len,
+                               const struct isotp_fast_addr target_addr, void *cb_arg);
+
+#ifdef CONFIG_ISOTP_FAST_STMIN_STATS
+
+/**
+ * Statistics of the separation time between consecutive frames sent by
+ * this node, measured from the TX confirmation of a frame until the next
+ * frame is queued.
+ */
+struct isotp_fast_stmin_stats
+{
+    /** Number of measured separation times */
+    uint32_t count;
+    /** Min. deviation from the requested STmin in ns (negative if too early) */
+    int32_t min_dev_ns;
+    /** Max. deviation from the requested STmin in ns */
+    int32_t max_dev_ns;
+    /** Mean absolute deviation from the requested STmin in ns */
+    uint32_t mean_abs_dev_ns;
+};
+
+/**
+ * Get the STmin statistics accumulated across all contexts.
+ *
+ * @param stats Pointer to the structure to be filled
+ */
+void isotp_fast_stmin_stats_get(struct isotp_fast_stmin_stats *stats);
+
+/**
+ * Reset the STmin statistics.
+ */
+void isotp_fast_stmin_stats_reset(void);
+
+#endif /* CONFIG_ISOTP_FAST_STMIN_STATS */
+
 #ifdef CONFIG_ISOTP_FAST_FIXED_ADDRESSING
 
 /**
@@ -10,6 +10,8 @@
 #include <zephyr/canbus/isotp.h>
 #include <zephyr/device.h>
 
+#include <thingset/sdk.h>
+
 #include "canbus/isotp_fast.h"
 
 #ifdef __cplusplus
@@ -235,13 +237,122 @@ typedef void (*thingset_can_item_rx_callback_t)(uint16_t data_id, const uint8_t
 typedef void (*thingset_can_reqresp_callback_t)(uint8_t *data, size_t len, int send_err,
                                                 int recv_err, uint8_t source_addr, void *arg);
 
+#ifdef CONFIG_THINGSET_CAN_CONTROL_REPORTING
+/**
+ * Data item of the control subset, precompiled for cyclic publication.
+ */
+struct thingset_can_control_item
+{
+    const struct thingset_data_object *obj;
+    /** CAN ID without the source address, which may change during runtime */
+    uint32_t can_id;
+#ifdef CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE
+    /** uptime in ms when the item was last sent */
+    uint32_t last_sent;
+    /** numeric value when the item was last sent */
+    float last_value;
+    /** min. change of a numeric value to be published */
+    float deadband;
+    uint16_t min_interval;
+    uint16_t max_interval;
+    /** encoded value when the item was last sent, compared for non-numeric items */
+    uint8_t last_data[CAN_MAX_DLEN];
+    uint8_t last_len;
+    bool sent;
+#endif
+};
+#endif /* CONFIG_THINGSET_CAN_CONTROL_REPORTING */
+
+#ifdef CONFIG_THINGSET_CAN_ITEM_RX
+/**
+ * Range of data items from one or all nodes to be received.
+ */
+struct thingset_can_item_subscription
+{
+    uint16_t data_id_min;
+    uint16_t data_id_max;
+    /** node address or THINGSET_CAN_ADDR_BROADCAST for all nodes */
+    uint8_t source_addr;
+};
+#endif /* CONFIG_THINGSET_CAN_ITEM_RX */
+
+#ifdef CONFIG_THINGSET_CAN_REPORT_RX
+/**
+ * Reception statistics of multi-frame reports.
+ */
+struct thingset_can_report_rx_stats
+{
+    /** Reports dropped because no chunks were available for reassembly */
+    uint32_t dropped_no_buf;
+    /** Reports dropped because they exceeded CONFIG_THINGSET_CAN_REPORT_RX_MAX_SIZE */
+    uint32_t dropped_too_large;
+    /** Reports dropped because of missing or out-of-sequence frames */
+    uint32_t dropped_seq;
+    /** Incomplete reports freed after CONFIG_THINGSET_CAN_REPORT_RX_TIMEOUT */
+    uint32_t evicted;
+};
+#endif /* CONFIG_THINGSET_CAN_REPORT_RX */
+
+#ifdef CONFIG_THINGSET_CAN_RX_DISPATCH
+/**
+ * Received report or data item waiting to be passed to the callback.
+ */
+struct thingset_can_rx_event
+{
+    /** reassembled multi-frame report or NULL for a single data item */
+    struct net_buf *report;
+    uint16_t data_id;
+    uint8_t source_addr;
+    uint8_t len;
+    uint8_t data[CAN_MAX_DLEN];
+};
+
+/**
+ * Statistics of the reception in the CAN RX callbacks and of the dispatch queue.
+ */
+struct thingset_can_rx_dispatch_stats
+{
+    /** Number of invocations of the CAN RX callbacks */
+    uint32_t isr_count;
+    /** Total cycles spent in the CAN RX callbacks */
+    uint64_t isr_cycles;
+    /** Max. cycles spent in a single invocation of the CAN RX callbacks */
+    uint32_t isr_cycles_max;
+    /** Max. number of events waiting in the queue */
+    uint32_t queue_high_water;
+    /** Events dropped because the queue was full */
+    uint32_t dropped;
+};
+#endif /* CONFIG_THINGSET_CAN_RX_DISPATCH */
+
+struct thingset_can;
+
+/**
+ * Request waiting for a response (transaction).
+ */
 struct thingset_can_request_response
 {
-    struct k_sem sem;
-    struct k_timer timer;
+    /** node in the bucket of the expected response CAN ID */
+    sys_snode_t node;
+    struct isotp_fast_timeout timeout;
+    struct thingset_can *ts_can;
+    /** CAN ID of the expected response */
     uint32_t can_id;
+    /** set while the slot is in use, including while the callback is invoked */
     thingset_can_reqresp_callback_t callback;
     void *cb_arg;
+    /** responses from all nodes are accepted until the timeout expires */
+    bool functional;
+    /** set while waiting for the response */
+    bool pending;
+    /** number of callbacks currently running for responses to a broadcast request */
+    uint8_t collecting;
+    /** set if the transaction was finished while response callbacks were running */
+    bool deferred;
+    /** whether the deferred completion invokes the callback with the errors below */
+    bool notify;
+    int send_err;
+    int recv_err;
 };
 
 /**
@@ -250,26 +361,82 @@ struct thingset_can_request_response
 struct thingset_can
 {
     const struct device *dev;
-    struct k_work_delayable live_reporting_work;
+#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
+    struct thingset_sdk_report_sink live_report_sink;
+#endif
 #ifdef CONFIG_THINGSET_CAN_CONTROL_REPORTING
     struct k_work_delayable control_reporting_work;
 #endif
     struct k_work_delayable addr_claim_work;
     thingset_can_addr_claim_rx_callback_t addr_claim_callback;
     struct isotp_fast_ctx ctx;
+#ifdef CONFIG_THINGSET_CAN_REPORT_TX_QUEUE
+    struct k_timer report_tx_timer;
+    struct k_spinlock report_tx_lock;
+    /** reports waiting for the current report to be sent */
+    sys_slist_t report_tx_queue;
+    /** report currently sent, or NULL */
+    struct net_buf *report_tx_buf;
+    uint16_t report_tx_pos;
+    uint8_t report_tx_seq;
+    uint8_t report_tx_retries;
+#else
     struct k_sem report_tx_sem;
+#endif
     struct k_event events;
-    struct thingset_can_request_response request_response;
+    struct thingset_can_request_response
+        request_response[CONFIG_THINGSET_CAN_REQRESP_MAX_TRANSACTIONS];
+    /** hash table of pending requests, keyed by the CAN ID of the expected response */
+    sys_slist_t reqresp_buckets[CONFIG_THINGSET_CAN_REQRESP_BUCKETS];
+    /** pending request to the broadcast address, or NULL */
+    struct thingset_can_request_response *reqresp_functional;
+    struct k_spinlock reqresp_lock;
+    /** given whenever a transaction was finished */
+    struct k_sem reqresp_sem;
+#ifndef CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER
     uint8_t rx_buffer[CONFIG_THINGSET_CAN_RX_BUF_SIZE];
+#endif
 #ifdef CONFIG_THINGSET_CAN_REPORT_RX
     thingset_can_report_rx_callback_t report_rx_cb;
+    /** reports being reassembled, indexed by source address */
+    struct net_buf *report_rx_bufs[THINGSET_CAN_ADDR_BROADCAST + 1];
+    /** reports spanning several chunks are linearized here before they are dispatched */
+    uint8_t report_rx_data[CONFIG_THINGSET_CAN_REPORT_RX_MAX_SIZE];
+    /** written from the CAN RX callback only */
+    struct thingset_can_report_rx_stats report_rx_stats;
 #endif
 #ifdef CONFIG_THINGSET_CAN_ITEM_RX
     thingset_can_item_rx_callback_t item_rx_cb;
+    struct thingset_can_item_subscription item_rx_subs[CONFIG_THINGSET_CAN_ITEM_RX_SUBSCRIPTIONS];
+    uint8_t item_rx_subs_count;
+    int item_rx_filter_ids[CONFIG_THINGSET_CAN_ITEM_RX_FILTERS];
+    uint8_t item_rx_filter_count;
+    /** set if the installed filters accept more items than subscribed */
+    bool item_rx_sw_filter;
+    /** serializes changes of the subscriptions and filters */
+    struct k_sem item_rx_lock;
+    /** protects the subscriptions and the software filter flag read by the RX callback */
+    struct k_spinlock item_rx_subs_lock;
+#endif
+#ifdef CONFIG_THINGSET_CAN_RX_DISPATCH
+    /** node in the list of instances served by the dispatch thread */
+    sys_snode_t rx_dispatch_node;
+    /**
+     * Single-producer/single-consumer ring of events, filled from the CAN RX callbacks and
+     * drained by the dispatch thread. The indices run freely and are masked on access.
+     */
+    atomic_t rx_dispatch_head;
+    atomic_t rx_dispatch_tail;
+    struct thingset_can_rx_event rx_dispatch_ring[CONFIG_THINGSET_CAN_RX_DISPATCH_QUEUE_SIZE];
+    /** written from the CAN RX callbacks only */
+    struct thingset_can_rx_dispatch_stats rx_dispatch_stats;
 #endif
-    int64_t next_live_report_time;
 #ifdef CONFIG_THINGSET_CAN_CONTROL_REPORTING
     int64_t next_control_report_time;
+    struct thingset_can_control_item control_plan[CONFIG_THINGSET_CAN_CONTROL_PLAN_SIZE];
+    uint8_t control_plan_len;
+    /** protects the plan against updates while it is processed */
+    struct k_sem control_plan_lock;
 #endif
     uint8_t node_addr;
     /** bus or bridge number */
@@ -282,6 +449,9 @@ struct thingset_can
 /**
  * Send ThingSet report to the CAN bus.
  *
+ * With CONFIG_THINGSET_CAN_REPORT_TX_QUEUE, the report is queued and the function returns before
+ * it was sent.
+ *
  * @param ts_can Pointer to the thingset_can context.
  * @param path Path of subset/group/record to be published
  * @param format Protocol data format to be used (text, binary with IDs or binary with names)
@@ -302,7 +472,10 @@ int thingset_can_send_report_inst(struct thingset_can *ts_can, const char *path,
  * @param callback This callback will be invoked when a response is received or an error during
  *                 sending or receiving occurred. Set to NULL if no response is expected.
  * @param callback_arg User data for the callback.
- * @param timeout Timeout to wait for a response.
+ * @param timeout Timeout to wait for a response. Requests to different nodes can be pending at
+ *                the same time. If a request to the same node is still pending or all
+ *                CONFIG_THINGSET_CAN_REQRESP_MAX_TRANSACTIONS slots are in use, the function
+ *                waits up to this timeout for it to finish before sending.
  *
  * @returns 0 for success or negative errno in case of error
  */
@@ -311,6 +484,64 @@ int thingset_can_send_inst(struct thingset_can *ts_can, uint8_t *tx_buf, size_t
                            thingset_can_reqresp_callback_t callback, void *callback_arg,
                            k_timeout_t timeout);
 
+#ifdef CONFIG_THINGSET_CAN_TX_BUF_POOL
+/**
+ * Send ThingSet message stored in a chain of buffers to other node
+ *
+ * The buffer reference is handed over to the ISO-TP layer and released after the message was
+ * sent, also in case of an error. The other parameters are the same as for
+ * thingset_can_send_inst().
+ *
+ * @param ts_can Pointer to the thingset_can context.
+ * @param buf Buffer chain containing the message.
+ *
+ * @returns 0 for success or negative errno in case of error
+ */
+int thingset_can_send_buf_inst(struct thingset_can *ts_can, struct net_buf *buf,
+                               uint8_t target_addr, uint8_t route,
+                               thingset_can_reqresp_callback_t callback, void *callback_arg,
+                               k_timeout_t timeout);
+#endif
+
+/**
+ * Send ThingSet request to all nodes
+ *
+ * The request is sent to THINGSET_CAN_ADDR_BROADCAST using functional addressing, so it must
+ * fit into a single CAN frame. The callback is invoked for every response received before the
+ * timeout expires and finally with data set to NULL and recv_err set to -ETIMEDOUT to signal the
+ * end of the collection. The other parameters are the same as for thingset_can_send_inst().
+ *
+ * Only nodes with CONFIG_THINGSET_CAN_BROADCAST_REQUESTS enabled respond.
+ *
+ * @param ts_can Pointer to the thingset_can context.
+ * @param tx_buf Buffer containing the request.
+ * @param tx_len Length of the request.
+ * @param route Target bus/bridge number to send the request to.
+ * @param callback Callback for the responses. Set to NULL if no response is expected.
+ * @param callback_arg User data for the callback.
+ * @param timeout Time to collect responses, must not be K_FOREVER if a callback is given.
+ *
+ * @returns 0 for success or negative errno in case of error
+ */
+int thingset_can_send_broadcast_inst(struct thingset_can *ts_can, uint8_t *tx_buf, size_t tx_len,
+                                     uint8_t route, thingset_can_reqresp_callback_t callback,
+                                     void *callback_arg, k_timeout_t timeout);
+
+/**
+ * Cancel pending request
+ *
+ * The callback of the request is not invoked anymore. Responses received afterwards are
+ * processed like requests from the other node.
+ *
+ * @param ts_can Pointer to the thingset_can context.
+ * @param target_addr Target node address the request was sent to.
+ * @param route Target bus/bridge number the request was sent to.
+ *
+ * @returns 0 for success or -ENOENT if no request to this node is pending
+ */
+int thingset_can_cancel_request_inst(struct thingset_can *ts_can, uint8_t target_addr,
+                                     uint8_t route);
+
 /**
  * Set callback for received address claim frames from other nodes
  *
@@ -335,6 +566,15 @@ void thingset_can_set_addr_claim_rx_callback_inst(struct thingset_can *ts_can,
  */
 int thingset_can_set_report_rx_callback_inst(struct thingset_can *ts_can,
                                              thingset_can_report_rx_callback_t rx_cb);
+
+/**
+ * Get reception statistics of multi-frame reports
+ *
+ * @param ts_can Pointer to the thingset_can context.
+ * @param stats Pointer to the structure to be filled.
+ */
+void thingset_can_get_report_rx_stats_inst(const struct thingset_can *ts_can,
+                                           struct thingset_can_report_rx_stats *stats);
 #endif /* CONFIG_THINGSET_CAN_REPORT_RX */
 
 #ifdef CONFIG_THINGSET_CAN_ITEM_RX
@@ -350,8 +590,84 @@ int thingset_can_set_report_rx_callback_inst(struct thingset_can *ts_can,
  */
 int thingset_can_set_item_rx_callback_inst(struct thingset_can *ts_can,
                                            thingset_can_report_rx_callback_t rx_cb);
+
+/**
+ * Subscribe to a range of data items
+ *
+ * Without any subscriptions, all data items on the bus are passed to the callback. As soon as
+ * subscriptions are added, only the subscribed items are received.
+ *
+ * The subscriptions are compiled into as few CAN filters as possible (at most
+ * CONFIG_THINGSET_CAN_ITEM_RX_FILTERS), so that frames of other items do not cause interrupts.
+ * If the ranges cannot be matched exactly with the available filters, the filters are widened
+ * and the remaining frames are filtered in software.
+ *
+ * @param ts_can Pointer to the thingset_can context.
+ * @param source_addr Address of the node or THINGSET_CAN_ADDR_BROADCAST for all nodes.
+ * @param data_id_min First data item ID of the range.
+ * @param data_id_max Last data item ID of the range.
+ *
+ * @returns 0 for success, -EINVAL for an empty range or -ENOMEM if all subscriptions are in use
+ */
+int thingset_can_subscribe_items_inst(struct thingset_can *ts_can, uint8_t source_addr,
+                                      uint16_t data_id_min, uint16_t data_id_max);
+
+/**
+ * Remove a subscription added with thingset_can_subscribe_items_inst()
+ *
+ * @param ts_can Pointer to the thingset_can context.
+ * @param source_addr Address of the node or THINGSET_CAN_ADDR_BROADCAST for all nodes.
+ * @param data_id_min First data item ID of the range.
+ * @param data_id_max Last data item ID of the range.
+ *
+ * @returns 0 for success or -ENOENT if there is no such subscription
+ */
+int thingset_can_unsubscribe_items_inst(struct thingset_can *ts_can, uint8_t source_addr,
+                                        uint16_t data_id_min, uint16_t data_id_max);
 #endif /* CONFIG_THINGSET_CAN_ITEM_RX */
 
+#ifdef CONFIG_THINGSET_CAN_RX_DISPATCH
+/**
+ * Get statistics of the reception of reports and data items
+ *
+ * @param ts_can Pointer to the thingset_can context.
+ * @param stats Pointer to the structure to be filled.
+ */
+void thingset_can_get_rx_dispatch_stats_inst(const struct thingset_can *ts_can,
+                                             struct thingset_can_rx_dispatch_stats *stats);
+#endif
+
+#ifdef CONFIG_THINGSET_CAN_CONTROL_REPORTING
+/**
+ * Update the data items published as control data
+ *
+ * The data items of the control subset are looked up when the instance is initialized. This
+ * function has to be called if items were added to or removed from the subset afterwards. The
+ * parameters set via thingset_can_set_control_params_inst() are reset to their defaults.
+ *
+ * @param ts_can Pointer to the thingset_can context.
+ */
+void thingset_can_update_control_plan_inst(struct thingset_can *ts_can);
+#endif
+
+#ifdef CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE
+/**
+ * Set publication parameters of a data item in the control subset
+ *
+ * @param ts_can Pointer to the thingset_can context.
+ * @param data_id ID of the data item.
+ * @param deadband Min. change of a numeric value since it was last sent to be published.
+ * @param min_interval Min. interval between two publications in milliseconds.
+ * @param max_interval Max. interval between two publications in milliseconds or 0 to publish
+ *                     only changes.
+ *
+ * @returns 0 for success or -ENOENT if the item is not in the control subset
+ */
+int thingset_can_set_control_params_inst(struct thingset_can *ts_can, uint16_t data_id,
+                                         float deadband, uint16_t min_interval,
+                                         uint16_t max_interval);
+#endif
+
 /**
  * Initialize a ThingSet CAN instance
  *
@@ -387,6 +703,39 @@ int thingset_can_send(uint8_t *tx_buf, size_t tx_len, uint8_t target_addr, uint8
                       thingset_can_reqresp_callback_t callback, void *callback_arg,
                       k_timeout_t timeout);
 
+#ifdef CONFIG_THINGSET_CAN_TX_BUF_POOL
+/**
+ * Send ThingSet message stored in a chain of buffers to other node
+ *
+ * See thingset_can_send_buf_inst() for function parameters.
+ *
+ * @returns 0 for success or negative errno in case of error
+ */
+int thingset_can_send_buf(struct net_buf *buf, uint8_t target_addr, uint8_t route,
+                          thingset_can_reqresp_callback_t callback, void *callback_arg,
+                          k_timeout_t timeout);
+#endif
+
+/**
+ * Send ThingSet request to all nodes
+ *
+ * See thingset_can_send_broadcast_inst() for function parameters.
+ *
+ * @returns 0 for success or negative errno in case of error
+ */
+int thingset_can_send_broadcast(uint8_t *tx_buf, size_t tx_len, uint8_t route,
+                                thingset_can_reqresp_callback_t callback, void *callback_arg,
+                                k_timeout_t timeout);
+
+/**
+ * Cancel pending request
+ *
+ * See thingset_can_cancel_request_inst() for function parameters.
+ *
+ * @returns 0 for success or -ENOENT if no request to this node is pending
+ */
+int thingset_can_cancel_request(uint8_t target_addr, uint8_t route);
+
 #ifdef CONFIG_THINGSET_CAN_REPORT_RX
 /**
  * Set callback for received reports from other nodes
@@ -400,6 +749,13 @@ int thingset_can_send(uint8_t *tx_buf, size_t tx_len, uint8_t target_addr, uint8
  * @param rx_cb Callback function.
  */
 int thingset_can_set_report_rx_callback(thingset_can_report_rx_callback_t rx_cb);
+
+/**
+ * Get reception statistics of multi-frame reports
+ *
+ * @param stats Pointer to the structure to be filled.
+ */
+void thingset_can_get_report_rx_stats(struct thingset_can_report_rx_stats *stats);
 #endif /* CONFIG_THINGSET_CAN_REPORT_RX */
 
 #ifdef CONFIG_THINGSET_CAN_ITEM_RX
@@ -413,8 +769,57 @@ int thingset_can_set_report_rx_callback(thingset_can_report_rx_callback_t rx_cb)
  * @param rx_cb Callback function.
  */
 int thingset_can_set_item_rx_callback(thingset_can_item_rx_callback_t rx_cb);
+
+/**
+ * Subscribe to a range of data items
+ *
+ * See thingset_can_subscribe_items_inst() for function parameters.
+ *
+ * @returns 0 for success, -EINVAL for an empty range or -ENOMEM if all subscriptions are in use
+ */
+int thingset_can_subscribe_items(uint8_t source_addr, uint16_t data_id_min, uint16_t data_id_max);
+
+/**
+ * Remove a subscription added with thingset_can_subscribe_items()
+ *
+ * See thingset_can_unsubscribe_items_inst() for function parameters.
+ *
+ * @returns 0 for success or -ENOENT if there is no such subscription
+ */
+int thingset_can_unsubscribe_items(uint8_t source_addr, uint16_t data_id_min,
+                                   uint16_t data_id_max);
 #endif /* CONFIG_THINGSET_CAN_ITEM_RX */
 
+#ifdef CONFIG_THINGSET_CAN_RX_DISPATCH
+/**
+ * Get statistics of the reception of reports and data items
+ *
+ * @param stats Pointer to the structure to be filled.
+ */
+void thingset_can_get_rx_dispatch_stats(struct thingset_can_rx_dispatch_stats *stats);
+#endif
+
+#ifdef CONFIG_THINGSET_CAN_CONTROL_REPORTING
+/**
+ * Update the data items published as control data
+ *
+ * See thingset_can_update_control_plan_inst().
+ */
+void thingset_can_update_control_plan(void);
+#endif
+
+#ifdef CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE
+/**
+ * Set publication parameters of a data item in the control subset
+ *
+ * See thingset_can_set_control_params_inst() for function parameters.
+ *
+ * @returns 0 for success or -ENOENT if the item is not in the control subset
+ */
+int thingset_can_set_control_params(uint16_t data_id, float deadband, uint16_t min_interval,
+                                    uint16_t max_interval);
+#endif
+
 /**
  * Get ThingSet CAN instance
  *
@@ -68,6 +68,25 @@ extern "C" {
 #define TS_ID_NET_WEBSOCKET_AUTH_TOKEN 0x287
 #define TS_ID_NET_CAN_NODE_ADDR        0x28C
 
+/* Request processing statistics group items */
+#define TS_ID_STATS                     0x2C
+#define TS_ID_STATS_SERIAL_REQS         0x2C0
+#define TS_ID_STATS_SERIAL_PROC_MAX     0x2C1
+#define TS_ID_STATS_SERIAL_TOTAL_MAX    0x2C2
+#define TS_ID_STATS_BLE_REQS            0x2C3
+#define TS_ID_STATS_BLE_PROC_MAX        0x2C4
+#define TS_ID_STATS_BLE_TOTAL_MAX       0x2C5
+#define TS_ID_STATS_CAN_REQS            0x2C6
+#define TS_ID_STATS_CAN_PROC_MAX        0x2C7
+#define TS_ID_STATS_CAN_TOTAL_MAX       0x2C8
+#define TS_ID_STATS_WEBSOCKET_REQS      0x2C9
+#define TS_ID_STATS_WEBSOCKET_PROC_MAX  0x2CA
+#define TS_ID_STATS_WEBSOCKET_TOTAL_MAX 0x2CB
+#define TS_ID_STATS_SHELL_REQS          0x2CC
+#define TS_ID_STATS_SHELL_PROC_MAX      0x2CD
+#define TS_ID_STATS_SHELL_TOTAL_MAX     0x2CE
+#define TS_ID_STATS_RESET               0x2CF
+
 /* Device Firmware Upgrade group items */
 #define TS_ID_DFU       0x2D
 #define TS_ID_DFU_INIT  0x2D0
@@ -134,24 +153,368 @@ struct shared_buffer
     size_t pos;
 };
 
+/**
+ * Buffer leased from the TX buffer pool
+ */
+struct thingset_sdk_buf
+{
+    size_t size;
+    /** word-aligned data, e.g. for hardware CRC calculations */
+    uint8_t data[] __aligned(sizeof(int));
+};
+
 /**
  * Callback typedef for received ThingSet messages in different interfaces
  */
 typedef void (*thingset_sdk_rx_callback_t)(const uint8_t *buf, size_t len);
 
+/**
+ * Callback typedef for transports publishing live reports or observed data
+ *
+ * The report is only valid while the callback is running and must not be modified, as it is
+ * passed to all transports using the same data format.
+ */
+typedef void (*thingset_sdk_report_callback_t)(const uint8_t *buf, size_t len, void *user_data);
+
+#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
+/**
+ * Transport subscribed to the live reports
+ */
+struct thingset_sdk_report_sink
+{
+    sys_snode_t node;
+    thingset_sdk_report_callback_t callback;
+    void *user_data;
+    /** data format the report is encoded in for this transport */
+    enum thingset_data_format format;
+};
+#endif /* CONFIG_THINGSET_SUBSET_LIVE_METRICS */
+
+#ifdef CONFIG_THINGSET_OBSERVE
+/**
+ * Observer of a path, registered by the application for one of its clients, e.g. a connected
+ * HMI or a cloud link
+ *
+ * The path is reported whenever its value changed and at least pmin elapsed since the previous
+ * report, and in any case after pmax. The callback has to forward the report to the client, as
+ * the transports do not register observers themselves.
+ */
+struct thingset_sdk_observer
+{
+    sys_snode_t node;
+    thingset_sdk_report_callback_t callback;
+    void *user_data;
+    enum thingset_data_format format;
+    /** path of the group, subset or item to be reported, must stay valid */
+    const char *path;
+    /** min. interval between two reports in ms */
+    uint32_t pmin;
+    /** max. interval between two reports in ms, 0 to report on change only */
+    uint32_t pmax;
+    /** min. change of a numeric item to be reported, only used if the path is a single item */
+    float deadband;
+    /* internal state */
+    const struct thingset_data_object *obj;
+    int64_t last_sent;
+    int64_t next_check;
+    uint32_t last_crc;
+    float last_value;
+    bool sent;
+};
+#endif /* CONFIG_THINGSET_OBSERVE */
+
+/**
+ * Process a ThingSet request received by one of the interfaces
+ *
+ * Same as thingset_process_message() with the global ThingSet context, but requests which may
+ * change data (e.g. updates or function calls) invalidate the report cache.
+ *
+ * @param req Pointer to the request.
+ * @param req_len Length of the request.
+ * @param rsp Pointer to the buffer for the response.
+ * @param rsp_size Size of the response buffer.
+ *
+ * @returns Length of the response or negative error code
+ */
+int thingset_sdk_process_message(const uint8_t *req, size_t req_len, uint8_t *rsp,
+                                 size_t rsp_size);
+
+/**
+ * Mark the value of a data object as changed
+ *
+ * With CONFIG_THINGSET_REPORT_CACHE, the application has to call this function after changing
+ * the value of an item in a reported subset, so that the next report is encoded again. It does
+ * nothing if the report cache is disabled.
+ *
+ * @param obj Pointer to the changed data object or NULL to invalidate all cached reports.
+ */
+void thingset_sdk_mark_dirty(const struct thingset_data_object *obj);
+
+/**
+ * Read the value of a numeric data item as float, e.g. to apply a deadband
+ *
+ * @param obj Pointer to the data object.
+ * @param value Pointer to store the value.
+ *
+ * @returns false if the item is not numeric
+ */
+bool thingset_sdk_item_value_float(const struct thingset_data_object *obj, float *value);
+
+#ifdef CONFIG_THINGSET_SHARED_TX_BUF
 /**
  * Get TX buffer that can be shared between different ThingSet interfaces
  *
+ * The SDK itself uses the TX buffer pool (see thingset_sdk_buf_alloc()) instead of this buffer.
+ * It is kept for applications, which have to take the lock while using it.
+ *
+ * @deprecated Use thingset_sdk_buf_alloc() instead. The shared buffer will be removed together
+ * with CONFIG_THINGSET_SHARED_TX_BUF in a future release.
+ *
  * @returns Pointer to shared_buffer instance
  */
 struct shared_buffer *thingset_sdk_shared_buffer(void);
+#endif
+
+/**
+ * Allocate a buffer from the TX buffer pool
+ *
+ * All buffers of the pool have the size CONFIG_THINGSET_SHARED_TX_BUF_SIZE.
+ *
+ * @param size Minimum size of the buffer.
+ * @param timeout Max. time to wait for a buffer to become available.
+ *
+ * @returns Pointer to the buffer or NULL if the size is too large or no buffer was available
+ */
+struct thingset_sdk_buf *thingset_sdk_buf_alloc(size_t size, k_timeout_t timeout);
+
+/**
+ * Return a buffer to the TX buffer pool
+ *
+ * @param buf Pointer to a buffer allocated with thingset_sdk_buf_alloc().
+ */
+void thingset_sdk_buf_free(struct thingset_sdk_buf *buf);
+
+/**
+ * Priority tiers of the ThingSet SDK work queues
+ */
+enum thingset_sdk_prio
+{
+    /** time-critical control tasks, e.g. CAN control reports */
+    THINGSET_SDK_PRIO_CONTROL,
+    /** processing of incoming requests and sending out reports */
+    THINGSET_SDK_PRIO_COMM,
+    /** slow background I/O, e.g. storage access or network connection management */
+    THINGSET_SDK_PRIO_BACKGROUND,
+    THINGSET_SDK_PRIO_COUNT,
+};
+
+/**
+ * Lateness statistics of a ThingSet SDK work queue
+ */
+struct thingset_sdk_work_stats
+{
+    /** number of recorded runs */
+    uint32_t runs;
+    /** number of runs started after their deadline */
+    uint32_t late;
+    /** max. lateness in ms */
+    uint32_t max_lateness;
+    /** sum of lateness of all runs in ms */
+    uint64_t total_lateness;
+};
 
 /**
  * Add delayable work to the common ThingSet SDK work queue. This should be used to offload
  * processing of incoming requests and sending out reports.
+ *
+ * Same as thingset_sdk_reschedule_work_prio() with THINGSET_SDK_PRIO_COMM.
  */
 int thingset_sdk_reschedule_work(struct k_work_delayable *dwork, k_timeout_t delay);
 
+/**
+ * Add delayable work to the ThingSet SDK work queue of the given priority tier.
+ *
+ * @param dwork Delayable work to be scheduled.
+ * @param delay Delay before the work is submitted to the queue.
+ * @param prio Priority tier of the work queue.
+ *
+ * @returns Same as k_work_reschedule_for_queue() or -EINVAL for an invalid priority
+ */
+int thingset_sdk_reschedule_work_prio(struct k_work_delayable *dwork, k_timeout_t delay,
+                                      enum thingset_sdk_prio prio);
+
+#ifdef CONFIG_THINGSET_SDK_WORKQ_STATS
+/**
+ * Record the lateness of a periodic work item at the beginning of its handler.
+ *
+ * @param prio Priority tier of the work queue running the handler.
+ * @param deadline Uptime in ms when the handler should have run. Deadlines <= 0 (i.e. not
+ *                 yet initialized) are ignored.
+ */
+void thingset_sdk_work_stats_record(enum thingset_sdk_prio prio, int64_t deadline);
+
+/**
+ * Get lateness statistics of a ThingSet SDK work queue.
+ *
+ * @param prio Priority tier of the work queue.
+ * @param stats Pointer to the struct the statistics are copied to.
+ *
+ * @returns 0 for success or -EINVAL for an invalid priority
+ */
+int thingset_sdk_get_work_stats(enum thingset_sdk_prio prio, struct thingset_sdk_work_stats *stats);
+#endif /* CONFIG_THINGSET_SDK_WORKQ_STATS */
+
+/**
+ * Transports covered by the request processing statistics
+ */
+enum thingset_sdk_stats_transport
+{
+    THINGSET_SDK_STATS_SERIAL,
+    THINGSET_SDK_STATS_BLE,
+    THINGSET_SDK_STATS_CAN,
+    THINGSET_SDK_STATS_WEBSOCKET,
+    THINGSET_SDK_STATS_SHELL,
+    THINGSET_SDK_STATS_TRANSPORT_COUNT,
+};
+
+/**
+ * Phases of request processing covered by the statistics
+ */
+enum thingset_sdk_stats_phase
+{
+    /** from RX complete until processing starts */
+    THINGSET_SDK_STATS_QUEUE,
+    /** waiting for a TX buffer or the lock of the response buffer */
+    THINGSET_SDK_STATS_BUF_WAIT,
+    /** processing of the request by the ThingSet library */
+    THINGSET_SDK_STATS_PROCESS,
+    /** from processing end until TX complete (or hand-over to the transport if sent async) */
+    THINGSET_SDK_STATS_TX,
+    /** from RX complete until TX complete */
+    THINGSET_SDK_STATS_TOTAL,
+    THINGSET_SDK_STATS_PHASE_COUNT,
+};
+
+#ifdef CONFIG_THINGSET_SDK_STATS
+/**
+ * Latency statistics of one phase of request processing
+ */
+struct thingset_sdk_latency_stats
+{
+    uint32_t count;
+    /** max. latency in us */
+    uint32_t max_us;
+    /** sum of all latencies in us */
+    uint64_t total_us;
+    /** number of latencies of [2^i, 2^(i+1)) us in bucket i, the first one includes 0 us */
+    uint32_t hist[CONFIG_THINGSET_SDK_STATS_BUCKETS];
+};
+
+/**
+ * Get the current time for request processing statistics
+ *
+ * @returns Cycle counter, or 0 if statistics are disabled
+ */
+static inline uint32_t thingset_sdk_stats_timestamp(void)
+{
+    return k_cycle_get_32();
+}
+
+/**
+ * Record the latency of a phase of request processing
+ *
+ * Can be called from interrupt context.
+ *
+ * @param transport Transport which received the request.
+ * @param phase Phase which ended now.
+ * @param start Timestamp when the phase started.
+ *
+ * @returns Current timestamp, which can be used as start of the next phase
+ */
+uint32_t thingset_sdk_stats_record(enum thingset_sdk_stats_transport transport,
+                                   enum thingset_sdk_stats_phase phase, uint32_t start);
+
+/**
+ * Get the latency statistics of a phase of request processing
+ *
+ * @param transport Transport which received the requests.
+ * @param phase Phase of request processing.
+ * @param stats Pointer to the struct the statistics are copied to.
+ *
+ * @returns 0 for success or -EINVAL for invalid arguments
+ */
+int thingset_sdk_get_latency_stats(enum thingset_sdk_stats_transport transport,
+                                   enum thingset_sdk_stats_phase phase,
+                                   struct thingset_sdk_latency_stats *stats);
+
+/**
+ * Reset the request processing statistics of all transports
+ */
+void thingset_sdk_reset_latency_stats(void);
+
+/**
+ * Get the name of a transport or phase for printing the statistics
+ */
+const char *thingset_sdk_stats_transport_name(enum thingset_sdk_stats_transport transport);
+const char *thingset_sdk_stats_phase_name(enum thingset_sdk_stats_phase phase);
+#else
+static inline uint32_t thingset_sdk_stats_timestamp(void)
+{
+    return 0;
+}
+
+static inline uint32_t thingset_sdk_stats_record(enum thingset_sdk_stats_transport transport,
+                                                 enum thingset_sdk_stats_phase phase,
+                                                 uint32_t start)
+{
+    return 0;
+}
+#endif /* CONFIG_THINGSET_SDK_STATS */
+
+#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
+/**
+ * Subscribe a transport to the live reports
+ *
+ * The live subset is encoded once per reporting period for each data format used by the
+ * subscribed transports and the same encoded report is passed to all transports using that
+ * format.
+ *
+ * Transports can only be added, but not removed again. Transports which are temporarily not
+ * able to send (e.g. because they are not connected) should ignore the report.
+ *
+ * @param sink Pointer to the sink, which must stay valid.
+ */
+void thingset_sdk_add_live_report_sink(struct thingset_sdk_report_sink *sink);
+#endif
+
+#ifdef CONFIG_THINGSET_OBSERVE
+/**
+ * Start observing a path
+ *
+ * This is an application API: ThingSet has no request to subscribe to a path, so remote clients
+ * cannot add observers via the transports.
+ *
+ * The callback, user_data, format, path, pmin, pmax and deadband fields of the observer have to
+ * be set before. The first report is sent immediately. Observers can neither be added nor
+ * removed from within an observer callback.
+ *
+ * @param obs Pointer to the observer, which must stay valid until it was removed again.
+ *
+ * @returns 0 for success, -EINVAL if the path was not found or the parameters are invalid,
+ *          -EALREADY if the observer was already added
+ */
+int thingset_sdk_observe(struct thingset_sdk_observer *obs);
+
+/**
+ * Stop observing a path
+ *
+ * @param obs Pointer to the observer.
+ *
+ * @returns 0 for success or -ENOENT if the observer was not found
+ */
+int thingset_sdk_unobserve(struct thingset_sdk_observer *obs);
+#endif /* CONFIG_THINGSET_OBSERVE */
+
 #ifdef __cplusplus
 }
 #endif
@@ -88,15 +88,15 @@ static char rx_buf[CONFIG_THINGSET_BLE_RX_BUF_SIZE];
 static size_t rx_buf_pos = 0;
 static bool discard_buffer;
 
+/* timestamp when the request in rx_buf was complete, for request processing statistics */
+static uint32_t rx_time;
+
 /* binary semaphore used as mutex in ISR context */
 static struct k_sem rx_buf_lock;
 
 static thingset_sdk_rx_callback_t rx_callback;
 
 static struct k_work_delayable processing_work;
-#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
-static struct k_work_delayable reporting_work;
-#endif
 
 static void thingset_ble_ccc_change(const struct bt_gatt_attr *attr, uint16_t value)
 {
@@ -127,6 +127,7 @@ static ssize_t thingset_ble_rx(struct bt_conn *conn, const struct bt_gatt_attr *
             else {
                 rx_buf[rx_buf_pos] = '\0';
                 /* start processing the request and keep the rx_buf_lock */
+                rx_time = thingset_sdk_stats_timestamp();
                 thingset_sdk_reschedule_work(&processing_work, K_NO_WAIT);
                 return len;
             }
@@ -194,32 +195,32 @@ int thingset_ble_send(const uint8_t *buf, size_t len)
 
 int thingset_ble_send_report(const char *path)
 {
-    struct shared_buffer *tx_buf = thingset_sdk_shared_buffer();
-    k_sem_take(&tx_buf->lock, K_FOREVER);
+    struct thingset_sdk_buf *tx_buf = thingset_sdk_buf_alloc(
+        CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+    if (tx_buf == NULL) {
+        return -ENOMEM;
+    }
 
     int len =
         thingset_report_path(&ts, tx_buf->data, tx_buf->size, path, THINGSET_TXT_NAMES_VALUES);
     int ret = thingset_ble_send(tx_buf->data, len);
 
-    k_sem_give(&tx_buf->lock);
+    thingset_sdk_buf_free(tx_buf);
     return ret;
 }
 
 #ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
 
-static void ble_regular_report_handler(struct k_work *work)
+static void ble_live_report_cb(const uint8_t *buf, size_t len, void *user_data)
 {
-    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
-    static int64_t pub_time;
-
-    if (live_reporting_enable) {
-        thingset_ble_send_report(TS_NAME_SUBSET_LIVE);
-    }
-
-    pub_time += 1000 * live_reporting_period;
-    thingset_sdk_reschedule_work(dwork, K_TIMEOUT_ABS_MS(pub_time));
+    thingset_ble_send(buf, len);
 }
 
+static struct thingset_sdk_report_sink live_report_sink = {
+    .callback = ble_live_report_cb,
+    .format = THINGSET_TXT_NAMES_VALUES,
+};
+
 #endif
 
 static void ble_process_msg_handler(struct k_work *work)
@@ -228,16 +229,27 @@ static void ble_process_msg_handler(struct k_work *work)
         LOG_DBG("Received Request (%d bytes): %s", rx_buf_pos, rx_buf);
 
         if (rx_callback == NULL) {
-            struct shared_buffer *tx_buf = thingset_sdk_shared_buffer();
-            k_sem_take(&tx_buf->lock, K_FOREVER);
-
-            int len = thingset_process_message(&ts, (uint8_t *)rx_buf, rx_buf_pos, tx_buf->data,
-                                               tx_buf->size);
-            if (len > 0) {
-                thingset_ble_send(tx_buf->data, len);
+            uint32_t t = thingset_sdk_stats_record(THINGSET_SDK_STATS_BLE, THINGSET_SDK_STATS_QUEUE,
+                                                   rx_time);
+
+            struct thingset_sdk_buf *tx_buf = thingset_sdk_buf_alloc(
+                CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+            if (tx_buf != NULL) {
+                t = thingset_sdk_stats_record(THINGSET_SDK_STATS_BLE, THINGSET_SDK_STATS_BUF_WAIT,
+                                              t);
+                int len = thingset_sdk_process_message((uint8_t *)rx_buf, rx_buf_pos,
+                                                       tx_buf->data, tx_buf->size);
+                t = thingset_sdk_stats_record(THINGSET_SDK_STATS_BLE, THINGSET_SDK_STATS_PROCESS,
+                                              t);
+                if (len > 0) {
+                    thingset_ble_send(tx_buf->data, len);
+                }
+
+                thingset_sdk_buf_free(tx_buf);
+                thingset_sdk_stats_record(THINGSET_SDK_STATS_BLE, THINGSET_SDK_STATS_TX, t);
+                thingset_sdk_stats_record(THINGSET_SDK_STATS_BLE, THINGSET_SDK_STATS_TOTAL,
+                                          rx_time);
             }
-
-            k_sem_give(&tx_buf->lock);
         }
         else {
             /* external processing (e.g. for gateway applications) */
@@ -260,9 +272,6 @@ static int thingset_ble_init()
     k_sem_init(&rx_buf_lock, 1, 1);
 
     k_work_init_delayable(&processing_work, ble_process_msg_handler);
-#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
-    k_work_init_delayable(&reporting_work, ble_regular_report_handler);
-#endif
 
     int err = bt_enable(NULL);
     if (err) {
@@ -278,7 +287,7 @@ static int thingset_ble_init()
     LOG_INF("Waiting for Bluetooth connections...");
 
 #ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
-    thingset_sdk_reschedule_work(&reporting_work, K_NO_WAIT);
+    thingset_sdk_add_live_report_sink(&live_report_sink);
 #endif
 
     return 0;
@@ -18,6 +18,8 @@
 #include <thingset/sdk.h>
 #include <thingset/storage.h>
 
+#include <math.h>
+
 LOG_MODULE_REGISTER(thingset_can, CONFIG_THINGSET_SDK_LOG_LEVEL);
 
 extern uint8_t eui64[8];
@@ -51,60 +53,136 @@ static const struct isotp_fast_opts fc_opts = {
 #endif
 };
 
+#ifdef CONFIG_THINGSET_CAN_TX_BUF_POOL
+NET_BUF_POOL_VAR_DEFINE(thingset_can_tx_pool, CONFIG_THINGSET_CAN_TX_BUF_COUNT,
+                        CONFIG_THINGSET_CAN_TX_BUF_POOL_SIZE, 0, NULL);
+#else
+/* TX buffer of the response currently sent, also used as argument of the sent callback */
+static struct thingset_sdk_buf *thingset_can_rsp_buf;
+static K_SEM_DEFINE(thingset_can_rsp_lock, 1, 1);
+/* timestamps of the request and of the start of the response transmission for statistics */
+static uint32_t thingset_can_rsp_rx_time;
+static uint32_t thingset_can_rsp_tx_time;
+#endif
+
 #ifdef CONFIG_THINGSET_CAN_REPORT_RX
+/* stored in the user data of the first chunk of a report */
 struct thingset_can_rx_context
 {
-    uint8_t src_addr;
+    uint32_t last_frame; /* uptime in ms when the last frame was received */
+    uint16_t len;        /* total length of all chunks */
     uint8_t msg;
     uint8_t seq;
-    bool started;
 };
 
+/* reports are reassembled in chains of chunks, so they only occupy the memory they need */
 NET_BUF_POOL_DEFINE(thingset_can_rx_buffer_pool, CONFIG_THINGSET_CAN_REPORT_RX_NUM_BUFFERS,
                     CONFIG_THINGSET_CAN_REPORT_RX_BUFFER_SIZE,
                     sizeof(struct thingset_can_rx_context), NULL);
 
-/* Simple hashtable (key is src_addr % number of buckets) to speed up buffer retrival */
-static sys_slist_t rx_buf_lookup[CONFIG_THINGSET_CAN_REPORT_RX_BUCKETS];
-
-static struct net_buf *thingset_can_get_rx_buf(uint8_t src_addr)
+static void thingset_can_free_rx_buf(struct thingset_can *ts_can, uint8_t src_addr)
 {
-    sys_slist_t *list = &rx_buf_lookup[src_addr % CONFIG_THINGSET_CAN_REPORT_RX_BUCKETS];
+    struct net_buf *buffer = ts_can->report_rx_bufs[src_addr];
 
-    sys_snode_t *pnode;
-    struct net_buf *buffer;
-    SYS_SLIST_FOR_EACH_NODE(list, pnode)
-    {
-        buffer = CONTAINER_OF(pnode, struct net_buf, node);
-        struct thingset_can_rx_context *context =
-            (struct thingset_can_rx_context *)buffer->user_data;
-        if (context != NULL && context->src_addr == src_addr) {
-            LOG_DBG("Found existing RX buffer for sender %x", src_addr);
-            return buffer;
+    if (buffer != NULL) {
+        LOG_DBG("Releasing RX buffer for sender %x", src_addr);
+        ts_can->report_rx_bufs[src_addr] = NULL;
+        net_buf_unref(buffer);
+    }
+}
+
+/**
+ * Frees reassemblies which did not receive any frames within the timeout, e.g. because the
+ * sender was disconnected in the middle of a report.
+ *
+ * Only called if the pool ran out of chunks, so there is no need for a timer.
+ *
+ * @param keep Reassembly currently appended to, which must not be freed, or NULL
+ *
+ * @returns true if any chunks were freed
+ */
+static bool thingset_can_evict_rx_bufs(struct thingset_can *ts_can, struct net_buf *keep)
+{
+    uint32_t now = k_uptime_get_32();
+    bool evicted = false;
+
+    for (int i = 0; i < ARRAY_SIZE(ts_can->report_rx_bufs); i++) {
+        struct net_buf *buffer = ts_can->report_rx_bufs[i];
+        if (buffer != NULL && buffer != keep) {
+            struct thingset_can_rx_context *context =
+                (struct thingset_can_rx_context *)buffer->user_data;
+            if (now - context->last_frame >= CONFIG_THINGSET_CAN_REPORT_RX_TIMEOUT) {
+                LOG_DBG("Evicting stale RX buffer of sender %x", i);
+                thingset_can_free_rx_buf(ts_can, i);
+                ts_can->report_rx_stats.evicted++;
+                evicted = true;
+            }
         }
     }
 
-    buffer = net_buf_alloc(&thingset_can_rx_buffer_pool, K_NO_WAIT);
-    if (buffer != NULL) {
-        struct thingset_can_rx_context *context =
-            (struct thingset_can_rx_context *)buffer->user_data;
-        context->src_addr = src_addr;
-        context->seq = 0;
-        sys_slist_append(list, &buffer->node);
-        LOG_DBG("Created new RX buffer for sender %x", src_addr);
-        return buffer;
+    return evicted;
+}
+
+static struct net_buf *thingset_can_alloc_rx_chunk(struct thingset_can *ts_can,
+                                                   struct net_buf *keep)
+{
+    struct net_buf *chunk = net_buf_alloc(&thingset_can_rx_buffer_pool, K_NO_WAIT);
+
+    if (chunk == NULL && thingset_can_evict_rx_bufs(ts_can, keep)) {
+        chunk = net_buf_alloc(&thingset_can_rx_buffer_pool, K_NO_WAIT);
     }
 
-    return NULL;
+    return chunk;
 }
 
-static void thingset_can_free_rx_buf(struct net_buf *buffer)
+/**
+ * Appends the data to the report, adding chunks as needed.
+ *
+ * @returns 0 for success or negative errno
+ */
+static int thingset_can_append_rx_data(struct thingset_can *ts_can, struct net_buf *buffer,
+                                       const uint8_t *data, size_t len)
 {
     struct thingset_can_rx_context *context = (struct thingset_can_rx_context *)buffer->user_data;
-    sys_slist_t *list = &rx_buf_lookup[context->src_addr % CONFIG_THINGSET_CAN_REPORT_RX_BUCKETS];
-    sys_slist_find_and_remove(list, &buffer->node);
-    LOG_DBG("Releasing RX buffer of length %d for sender %x", buffer->len, context->src_addr);
-    net_buf_unref(buffer);
+    struct net_buf *last = net_buf_frag_last(buffer);
+
+    if (context->len + len > CONFIG_THINGSET_CAN_REPORT_RX_MAX_SIZE) {
+        return -EMSGSIZE;
+    }
+
+    while (len > 0) {
+        if (net_buf_tailroom(last) == 0) {
+            struct net_buf *chunk = thingset_can_alloc_rx_chunk(ts_can, buffer);
+            if (chunk == NULL) {
+                return -ENOBUFS;
+            }
+            net_buf_frag_insert(last, chunk);
+            last = chunk;
+        }
+
+        size_t chunk_len = MIN(len, net_buf_tailroom(last));
+        net_buf_add_mem(last, data, chunk_len);
+        context->len += chunk_len;
+        data += chunk_len;
+        len -= chunk_len;
+    }
+
+    return 0;
+}
+
+static void thingset_can_dispatch_report(struct thingset_can *ts_can, struct net_buf *buffer,
+                                         uint8_t source_addr)
+{
+    if (buffer->frags == NULL) {
+        ts_can->report_rx_cb(buffer->data, buffer->len, source_addr);
+    }
+    else {
+        struct thingset_can_rx_context *context =
+            (struct thingset_can_rx_context *)buffer->user_data;
+        size_t len = net_buf_linearize(ts_can->report_rx_data, sizeof(ts_can->report_rx_data),
+                                       buffer, 0, context->len);
+        ts_can->report_rx_cb(ts_can->report_rx_data, len, source_addr);
+    }
 }
 #endif /* CONFIG_THINGSET_CAN_REPORT_RX */
 
@@ -181,7 +259,85 @@ static void thingset_can_addr_claim_rx_cb(const struct device *dev, struct can_f
     /* Optimization: store in internal database to exclude from potentially available addresses */
 }
 
+#ifdef CONFIG_THINGSET_CAN_RX_DISPATCH
+#define RX_DISPATCH_RING_MASK (CONFIG_THINGSET_CAN_RX_DISPATCH_QUEUE_SIZE - 1)
+
+BUILD_ASSERT((CONFIG_THINGSET_CAN_RX_DISPATCH_QUEUE_SIZE & RX_DISPATCH_RING_MASK) == 0,
+             "CONFIG_THINGSET_CAN_RX_DISPATCH_QUEUE_SIZE must be a power of two");
+
+static K_SEM_DEFINE(rx_dispatch_sem, 0, 1);
+
+/* instances are only added and never removed, so the dispatch thread traverses it without lock */
+static sys_slist_t rx_dispatch_list = SYS_SLIST_STATIC_INIT(&rx_dispatch_list);
+static struct k_spinlock rx_dispatch_lock;
+
+/**
+ * Adds an event to the ring of the instance and wakes up the dispatch thread.
+ *
+ * Must only be called from the CAN RX callbacks, which are not run concurrently for the same
+ * controller. If the ring is full, the event is dropped and the report buffer is released.
+ */
+static void thingset_can_rx_dispatch_put(struct thingset_can *ts_can,
+                                         const struct thingset_can_rx_event *event)
+{
+    atomic_val_t head = atomic_get(&ts_can->rx_dispatch_head);
+    uint32_t used = head - atomic_get(&ts_can->rx_dispatch_tail);
+
+    if (used >= CONFIG_THINGSET_CAN_RX_DISPATCH_QUEUE_SIZE) {
+        LOG_WRN("Dispatch queue full, dropped data from 0x%X", event->source_addr);
+        ts_can->rx_dispatch_stats.dropped++;
+        if (event->report != NULL) {
+            net_buf_unref(event->report);
+        }
+        return;
+    }
+
+    ts_can->rx_dispatch_ring[head & RX_DISPATCH_RING_MASK] = *event;
+    /* publish the slot only after it was written */
+    atomic_set(&ts_can->rx_dispatch_head, head + 1);
+
+    ts_can->rx_dispatch_stats.queue_high_water =
+        MAX(ts_can->rx_dispatch_stats.queue_high_water, used + 1);
+
+    k_sem_give(&rx_dispatch_sem);
+}
+
+static void thingset_can_rx_dispatch_account(struct thingset_can *ts_can, uint32_t start)
+{
+    uint32_t cycles = k_cycle_get_32() - start;
+
+    ts_can->rx_dispatch_stats.isr_count++;
+    ts_can->rx_dispatch_stats.isr_cycles += cycles;
+    ts_can->rx_dispatch_stats.isr_cycles_max =
+        MAX(ts_can->rx_dispatch_stats.isr_cycles_max, cycles);
+}
+#endif /* CONFIG_THINGSET_CAN_RX_DISPATCH */
+
 #ifdef CONFIG_THINGSET_CAN_ITEM_RX
+/*
+ * Checks a received item against the subscriptions if the installed filters are not exact. The
+ * list of subscriptions is short, so it is scanned instead of keeping a bitmap of all data IDs.
+ */
+static bool thingset_can_item_subscribed(struct thingset_can *ts_can, uint16_t data_id,
+                                         uint8_t source_addr)
+{
+    k_spinlock_key_t key = k_spin_lock(&ts_can->item_rx_subs_lock);
+    bool subscribed = !ts_can->item_rx_sw_filter;
+
+    for (int i = 0; !subscribed && i < ts_can->item_rx_subs_count; i++) {
+        struct thingset_can_item_subscription *sub = &ts_can->item_rx_subs[i];
+        if ((sub->source_addr == THINGSET_CAN_ADDR_BROADCAST || sub->source_addr == source_addr)
+            && data_id >= sub->data_id_min && data_id <= sub->data_id_max)
+        {
+            subscribed = true;
+        }
+    }
+
+    k_spin_unlock(&ts_can->item_rx_subs_lock, key);
+
+    return subscribed;
+}
+
 static void thingset_can_item_rx_cb(const struct device *dev, struct can_frame *frame,
                                     void *user_data)
 {
@@ -189,69 +345,351 @@ static void thingset_can_item_rx_cb(const struct device *dev, struct can_frame *
     uint16_t data_id = THINGSET_CAN_DATA_ID_GET(frame->id);
     uint8_t source_addr = THINGSET_CAN_SOURCE_GET(frame->id);
 
+    if (!thingset_can_item_subscribed(ts_can, data_id, source_addr)) {
+        return;
+    }
+
+#ifdef CONFIG_THINGSET_CAN_RX_DISPATCH
+    uint32_t start = k_cycle_get_32();
+    struct thingset_can_rx_event event = {
+        .data_id = data_id,
+        .source_addr = source_addr,
+        .len = can_dlc_to_bytes(frame->dlc),
+    };
+
+    memcpy(event.data, frame->data, event.len);
+    thingset_can_rx_dispatch_put(ts_can, &event);
+    thingset_can_rx_dispatch_account(ts_can, start);
+#else
     ts_can->item_rx_cb(data_id, frame->data, can_dlc_to_bytes(frame->dlc), source_addr);
+#endif
 }
 #endif /* CONFIG_THINGSET_CAN_ITEM_RX */
 
 #ifdef CONFIG_THINGSET_CAN_REPORT_RX
-static void thingset_can_report_rx_cb(const struct device *dev, struct can_frame *frame,
-                                      void *user_data)
+static void thingset_can_report_rx_frame(struct thingset_can *ts_can, struct can_frame *frame)
 {
-    struct thingset_can *ts_can = user_data;
     uint8_t source_addr = THINGSET_CAN_SOURCE_GET(frame->id);
     uint8_t msg_no = THINGSET_CAN_MSG_NO_GET(frame->id);
     uint8_t seq = THINGSET_CAN_SEQ_NO_GET(frame->id);
+    uint32_t mf_type = frame->id & THINGSET_CAN_MF_TYPE_MASK;
+    struct thingset_can_rx_context *context;
+    int err;
 
-    struct net_buf *buffer = thingset_can_get_rx_buf(source_addr);
-    if (buffer != NULL) {
-        struct thingset_can_rx_context *context =
-            (struct thingset_can_rx_context *)buffer->user_data;
+    struct net_buf *buffer = ts_can->report_rx_bufs[source_addr];
 
-        if ((frame->id & THINGSET_CAN_MF_TYPE_MASK) == THINGSET_CAN_MF_TYPE_SINGLE
-            || (frame->id & THINGSET_CAN_MF_TYPE_MASK) == THINGSET_CAN_MF_TYPE_FIRST)
-        {
-            context->msg = msg_no;
-            context->started = true;
+    if (mf_type == THINGSET_CAN_MF_TYPE_SINGLE || mf_type == THINGSET_CAN_MF_TYPE_FIRST) {
+        if (buffer != NULL) {
+            LOG_WRN("Incomplete report from 0x%X replaced", source_addr);
+            ts_can->report_rx_stats.dropped_seq++;
+            thingset_can_free_rx_buf(ts_can, source_addr);
         }
-        else if (context->msg != msg_no) {
-            LOG_WRN("Out-of-message frame received");
-            thingset_can_free_rx_buf(buffer);
+        buffer = thingset_can_alloc_rx_chunk(ts_can, NULL);
+        if (buffer == NULL) {
+            LOG_WRN("Discarded report from 0x%X: no buffer", source_addr);
+            ts_can->report_rx_stats.dropped_no_buf++;
             return;
         }
-        else if (!context->started) {
-            LOG_WRN("Missing first frame");
-            thingset_can_free_rx_buf(buffer);
+        ts_can->report_rx_bufs[source_addr] = buffer;
+        LOG_DBG("Started new RX buffer for sender %x", source_addr);
+        context = (struct thingset_can_rx_context *)buffer->user_data;
+        context->msg = msg_no;
+        context->seq = 0;
+        context->len = 0;
+    }
+    else if (buffer == NULL) {
+        LOG_WRN("Missing first frame");
+        ts_can->report_rx_stats.dropped_seq++;
+        return;
+    }
+    else {
+        context = (struct thingset_can_rx_context *)buffer->user_data;
+        if (context->msg != msg_no) {
+            LOG_WRN("Out-of-message frame received");
+            ts_can->report_rx_stats.dropped_seq++;
+            thingset_can_free_rx_buf(ts_can, source_addr);
             return;
         }
+    }
 
-        if ((context->seq & 0xF) == seq) {
-            int chunk_len = can_dlc_to_bytes(frame->dlc);
-            if (buffer->len + chunk_len > buffer->size) {
-                LOG_WRN("Discarded too large report from 0x%X", source_addr);
-                thingset_can_free_rx_buf(buffer);
-                return;
-            }
-            uint8_t *buf = net_buf_add(buffer, chunk_len);
-            LOG_DBG("Reassembling %d bytes from ID 0x%08X", chunk_len, frame->id);
-            memcpy(buf, frame->data, chunk_len);
-            if ((frame->id & THINGSET_CAN_MF_TYPE_MASK) == THINGSET_CAN_MF_TYPE_SINGLE
-                || (frame->id & THINGSET_CAN_MF_TYPE_MASK) == THINGSET_CAN_MF_TYPE_LAST)
-            {
-                LOG_DBG("Finished; dispatching %d bytes from node %x", buffer->len, source_addr);
-                ts_can->report_rx_cb(buffer->data, buffer->len, source_addr);
-                thingset_can_free_rx_buf(buffer);
-            }
+    if ((context->seq & 0xF) != seq) {
+        /* out-of-sequence frame received, so free the buffer */
+        LOG_WRN("Out-of-sequence frame received");
+        ts_can->report_rx_stats.dropped_seq++;
+        thingset_can_free_rx_buf(ts_can, source_addr);
+        return;
+    }
+
+    /* refreshed first, as appending may evict stale reassemblies to get a new chunk */
+    context->last_frame = k_uptime_get_32();
 
-            context->seq++;
+    LOG_DBG("Reassembling %d bytes from ID 0x%08X", can_dlc_to_bytes(frame->dlc), frame->id);
+    err = thingset_can_append_rx_data(ts_can, buffer, frame->data, can_dlc_to_bytes(frame->dlc));
+    if (err == -EMSGSIZE) {
+        LOG_WRN("Discarded too large report from 0x%X", source_addr);
+        ts_can->report_rx_stats.dropped_too_large++;
+        thingset_can_free_rx_buf(ts_can, source_addr);
+        return;
+    }
+    else if (err != 0) {
+        LOG_WRN("Discarded report from 0x%X: no buffer", source_addr);
+        ts_can->report_rx_stats.dropped_no_buf++;
+        thingset_can_free_rx_buf(ts_can, source_addr);
+        return;
+    }
+
+    context->seq++;
+
+    if (mf_type == THINGSET_CAN_MF_TYPE_SINGLE || mf_type == THINGSET_CAN_MF_TYPE_LAST) {
+        LOG_DBG("Finished; dispatching %d bytes from node %x", context->len, source_addr);
+#ifdef CONFIG_THINGSET_CAN_RX_DISPATCH
+        /* the dispatch thread takes over the buffer */
+        ts_can->report_rx_bufs[source_addr] = NULL;
+        thingset_can_rx_dispatch_put(ts_can, &(struct thingset_can_rx_event){
+                                                 .report = buffer,
+                                                 .source_addr = source_addr,
+                                             });
+#else
+        thingset_can_dispatch_report(ts_can, buffer, source_addr);
+        thingset_can_free_rx_buf(ts_can, source_addr);
+#endif
+    }
+}
+
+static void thingset_can_report_rx_cb(const struct device *dev, struct can_frame *frame,
+                                      void *user_data)
+{
+    struct thingset_can *ts_can = user_data;
+
+#ifdef CONFIG_THINGSET_CAN_RX_DISPATCH
+    uint32_t start = k_cycle_get_32();
+
+    thingset_can_report_rx_frame(ts_can, frame);
+    thingset_can_rx_dispatch_account(ts_can, start);
+#else
+    thingset_can_report_rx_frame(ts_can, frame);
+#endif
+}
+#endif /* CONFIG_THINGSET_CAN_REPORT_RX */
+
+#ifdef CONFIG_THINGSET_CAN_RX_DISPATCH
+static void thingset_can_rx_dispatch_drain(struct thingset_can *ts_can)
+{
+    atomic_val_t tail = atomic_get(&ts_can->rx_dispatch_tail);
+
+    while (tail != atomic_get(&ts_can->rx_dispatch_head)) {
+        struct thingset_can_rx_event *event =
+            &ts_can->rx_dispatch_ring[tail & RX_DISPATCH_RING_MASK];
+
+#ifdef CONFIG_THINGSET_CAN_REPORT_RX
+        if (event->report != NULL) {
+            thingset_can_dispatch_report(ts_can, event->report, event->source_addr);
+            net_buf_unref(event->report);
+        }
+#endif
+#ifdef CONFIG_THINGSET_CAN_ITEM_RX
+        if (event->report == NULL) {
+            ts_can->item_rx_cb(event->data_id, event->data, event->len, event->source_addr);
+        }
+#endif
+
+        /* release the slot only after the event was processed */
+        atomic_set(&ts_can->rx_dispatch_tail, ++tail);
+    }
+}
+
+static void thingset_can_rx_dispatch_thread(void *p1, void *p2, void *p3)
+{
+    struct thingset_can *ts_can;
+
+    while (true) {
+        /* events received until the queues were drained are handled in the same batch */
+        k_sem_take(&rx_dispatch_sem, K_FOREVER);
+
+        SYS_SLIST_FOR_EACH_CONTAINER(&rx_dispatch_list, ts_can, rx_dispatch_node)
+        {
+            thingset_can_rx_dispatch_drain(ts_can);
+        }
+    }
+}
+
+K_THREAD_DEFINE(thingset_can_rx_dispatch, CONFIG_THINGSET_CAN_RX_DISPATCH_STACK_SIZE,
+                thingset_can_rx_dispatch_thread, NULL, NULL, NULL,
+                CONFIG_THINGSET_CAN_RX_DISPATCH_PRIORITY, 0, 0);
+
+void thingset_can_get_rx_dispatch_stats_inst(const struct thingset_can *ts_can,
+                                             struct thingset_can_rx_dispatch_stats *stats)
+{
+    *stats = ts_can->rx_dispatch_stats;
+}
+#endif /* CONFIG_THINGSET_CAN_RX_DISPATCH */
+
+/*
+ * Prepares the frame of a packetized report containing the data starting at pos.
+ *
+ * @returns number of bytes of the report contained in the frame
+ */
+static int thingset_can_prepare_report_frame(struct thingset_can *ts_can, struct can_frame *frame,
+                                             const uint8_t *data, int len, int pos, uint8_t seq)
+{
+    uint32_t mf_type;
+    int chunk_len;
+
+    if (len - pos > CAN_MAX_DLEN) {
+        chunk_len = CAN_MAX_DLEN;
+        mf_type = (pos == 0) ? THINGSET_CAN_MF_TYPE_FIRST : THINGSET_CAN_MF_TYPE_CONSEC;
+    }
+    else {
+        chunk_len = len - pos;
+        mf_type = (pos == 0) ? THINGSET_CAN_MF_TYPE_SINGLE : THINGSET_CAN_MF_TYPE_LAST;
+    }
+
+    frame->flags = CAN_FRAME_IDE | (IS_ENABLED(CONFIG_CAN_FD_MODE) ? CAN_FRAME_FDF : 0);
+    memcpy(frame->data, data + pos, chunk_len);
+    frame->id = THINGSET_CAN_PRIO_REPORT_LOW | THINGSET_CAN_TYPE_MF_REPORT
+                | THINGSET_CAN_MSG_NO_SET(ts_can->msg_no) | mf_type | THINGSET_CAN_SEQ_NO_SET(seq)
+                | THINGSET_CAN_SOURCE_SET(ts_can->node_addr);
+    frame->dlc = can_bytes_to_dlc(chunk_len);
+    if (IS_ENABLED(CONFIG_CAN_FD_MODE)) {
+        /* pad message with empty bytes */
+        memset(frame->data + chunk_len, 0, can_dlc_to_bytes(frame->dlc) - chunk_len);
+    }
+
+    return chunk_len;
+}
+
+#ifdef CONFIG_THINGSET_CAN_REPORT_TX_QUEUE
+
+NET_BUF_POOL_VAR_DEFINE(thingset_can_report_tx_pool, CONFIG_THINGSET_CAN_REPORT_TX_BUF_COUNT,
+                        CONFIG_THINGSET_CAN_REPORT_TX_BUF_POOL_SIZE, 0, NULL);
+
+/*
+ * Reports are transmitted one frame at a time. The next frame is sent from the TX complete
+ * callback of the previous one, or from the report timer if a frame separation time is
+ * configured or the TX queue of the CAN controller was full. As there is only one frame in
+ * flight, the state of the current report is never accessed concurrently. The lock only
+ * protects the handover of queued reports.
+ */
+static void thingset_can_report_tx_next(struct thingset_can *ts_can);
+
+static void thingset_can_report_tx_finish(struct thingset_can *ts_can)
+{
+    struct net_buf *next;
+    sys_snode_t *node;
+
+    net_buf_unref(ts_can->report_tx_buf);
+    ts_can->msg_no++;
+
+    k_spinlock_key_t key = k_spin_lock(&ts_can->report_tx_lock);
+    node = sys_slist_get(&ts_can->report_tx_queue);
+    next = (node != NULL) ? CONTAINER_OF(node, struct net_buf, node) : NULL;
+    ts_can->report_tx_buf = next;
+    k_spin_unlock(&ts_can->report_tx_lock, key);
+
+    if (next != NULL) {
+        ts_can->report_tx_pos = 0;
+        ts_can->report_tx_seq = 0;
+        ts_can->report_tx_retries = 0;
+        if (CONFIG_THINGSET_CAN_FRAME_SEPARATION_TIME > 0) {
+            k_timer_start(&ts_can->report_tx_timer,
+                          K_MSEC(CONFIG_THINGSET_CAN_FRAME_SEPARATION_TIME), K_NO_WAIT);
         }
         else {
-            /* out-of-sequence frame received, so free the buffer */
-            LOG_WRN("Out-of-sequence frame received");
-            thingset_can_free_rx_buf(buffer);
+            thingset_can_report_tx_next(ts_can);
         }
     }
 }
-#endif /* CONFIG_THINGSET_CAN_REPORT_RX */
+
+static void thingset_can_report_tx_cb(const struct device *dev, int error, void *user_data)
+{
+    struct thingset_can *ts_can = user_data;
+    struct net_buf *buf = ts_can->report_tx_buf;
+
+    if (error != 0) {
+        LOG_DBG("Sending report %u failed: %d", ts_can->msg_no, error);
+        thingset_can_report_tx_finish(ts_can);
+        return;
+    }
+
+    ts_can->report_tx_pos += MIN(buf->len - ts_can->report_tx_pos, CAN_MAX_DLEN);
+    ts_can->report_tx_seq++;
+
+    if (ts_can->report_tx_pos >= buf->len) {
+        thingset_can_report_tx_finish(ts_can);
+    }
+    else if (CONFIG_THINGSET_CAN_FRAME_SEPARATION_TIME > 0) {
+        k_timer_start(&ts_can->report_tx_timer, K_MSEC(CONFIG_THINGSET_CAN_FRAME_SEPARATION_TIME),
+                      K_NO_WAIT);
+    }
+    else {
+        thingset_can_report_tx_next(ts_can);
+    }
+}
+
+static void thingset_can_report_tx_next(struct thingset_can *ts_can)
+{
+    struct net_buf *buf = ts_can->report_tx_buf;
+    struct can_frame frame;
+
+    thingset_can_prepare_report_frame(ts_can, &frame, buf->data, buf->len, ts_can->report_tx_pos,
+                                      ts_can->report_tx_seq);
+
+    int ret = can_send(ts_can->dev, &frame, K_NO_WAIT, thingset_can_report_tx_cb, ts_can);
+    if (ret == -EAGAIN && ts_can->report_tx_retries++ < CONFIG_THINGSET_CAN_REPORT_SEND_TIMEOUT) {
+        /* TX queue of the CAN controller is full, so try again later */
+        k_timer_start(&ts_can->report_tx_timer, K_MSEC(1), K_NO_WAIT);
+    }
+    else if (ret != 0) {
+        LOG_DBG("Error sending CAN frame with ID 0x%X: %d", frame.id, ret);
+        thingset_can_report_tx_finish(ts_can);
+    }
+    else {
+        ts_can->report_tx_retries = 0;
+    }
+}
+
+static void thingset_can_report_tx_timer_handler(struct k_timer *timer)
+{
+    struct thingset_can *ts_can = CONTAINER_OF(timer, struct thingset_can, report_tx_timer);
+
+    thingset_can_report_tx_next(ts_can);
+}
+
+static int thingset_can_send_report_data(struct thingset_can *ts_can, const uint8_t *data, int len)
+{
+    struct net_buf *buf;
+    bool start;
+
+    /* hand a copy of the report over to the transmitter, so the shared buffer is free again */
+    buf = net_buf_alloc_len(&thingset_can_report_tx_pool, len, K_NO_WAIT);
+    if (buf == NULL) {
+        LOG_WRN("No buffer for report of %d bytes", len);
+        return -ENOMEM;
+    }
+    net_buf_add_mem(buf, data, len);
+
+    k_spinlock_key_t key = k_spin_lock(&ts_can->report_tx_lock);
+    start = (ts_can->report_tx_buf == NULL);
+    if (start) {
+        ts_can->report_tx_buf = buf;
+    }
+    else {
+        /* sent after the reports queued before to preserve the order of messages */
+        sys_slist_append(&ts_can->report_tx_queue, &buf->node);
+    }
+    k_spin_unlock(&ts_can->report_tx_lock, key);
+
+    if (start) {
+        ts_can->report_tx_pos = 0;
+        ts_can->report_tx_seq = 0;
+        ts_can->report_tx_retries = 0;
+        thingset_can_report_tx_next(ts_can);
+    }
+
+    return 0;
+}
+
+#else /* !CONFIG_THINGSET_CAN_REPORT_TX_QUEUE */
 
 static void thingset_can_report_tx_cb(const struct device *dev, int error, void *user_data)
 {
@@ -260,54 +698,19 @@ static void thingset_can_report_tx_cb(const struct device *dev, int error, void
     k_sem_give(&ts_can->report_tx_sem);
 }
 
-int thingset_can_send_report_inst(struct thingset_can *ts_can, const char *path,
-                                  enum thingset_data_format format)
+/* must be called with the shared buffer locked, as the frames are sent from the report data */
+static int thingset_can_send_report_data(struct thingset_can *ts_can, const uint8_t *data, int len)
 {
-    int len, ret = 0;
+    int ret = 0;
     int pos = 0;
-    int chunk_len;
     uint8_t seq = 0;
-    bool end = false;
-
-    struct shared_buffer *tx_buf = thingset_sdk_shared_buffer();
-    k_sem_take(&tx_buf->lock, K_FOREVER);
 
     k_sem_reset(&ts_can->report_tx_sem);
 
-    len = thingset_report_path(&ts, tx_buf->data, tx_buf->size, path, format);
-    if (len <= 0) {
-        goto out;
-    }
-
-    struct can_frame frame = {
-        .flags = CAN_FRAME_IDE | (IS_ENABLED(CONFIG_CAN_FD_MODE) ? CAN_FRAME_FDF : 0),
-    };
+    struct can_frame frame;
 
     do {
-        uint32_t mf_type;
-        if (len - pos > CAN_MAX_DLEN) {
-            chunk_len = CAN_MAX_DLEN;
-            mf_type = (pos == 0) ? THINGSET_CAN_MF_TYPE_FIRST : THINGSET_CAN_MF_TYPE_CONSEC;
-        }
-        else {
-            chunk_len = len - pos;
-            end = true;
-            mf_type = (pos == 0) ? THINGSET_CAN_MF_TYPE_SINGLE : THINGSET_CAN_MF_TYPE_LAST;
-        }
-        memcpy(frame.data, tx_buf->data + pos, chunk_len);
-        frame.id = THINGSET_CAN_PRIO_REPORT_LOW | THINGSET_CAN_TYPE_MF_REPORT
-                   | THINGSET_CAN_MSG_NO_SET(ts_can->msg_no) | mf_type
-                   | THINGSET_CAN_SEQ_NO_SET(seq) | THINGSET_CAN_SOURCE_SET(ts_can->node_addr);
-        frame.dlc = can_bytes_to_dlc(chunk_len);
-        if (end && IS_ENABLED(CONFIG_CAN_FD_MODE)) {
-            /* pad message with empty bytes */
-            size_t frame_len = can_dlc_to_bytes(frame.dlc);
-            if (frame_len > chunk_len) {
-                for (unsigned int i = 0; i < frame_len - chunk_len; i++) {
-                    frame.data[chunk_len + i] = 0x00;
-                }
-            }
-        }
+        int chunk_len = thingset_can_prepare_report_frame(ts_can, &frame, data, len, pos, seq);
 
         ret = can_send(ts_can->dev, &frame, K_MSEC(CONFIG_THINGSET_CAN_REPORT_SEND_TIMEOUT),
                        thingset_can_report_tx_cb, ts_can);
@@ -331,28 +734,37 @@ int thingset_can_send_report_inst(struct thingset_can *ts_can, const char *path,
 
     ts_can->msg_no++;
 
-out:
-    k_sem_give(&tx_buf->lock);
     return ret;
 }
 
-#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
-static void thingset_can_live_reporting_handler(struct k_work *work)
+#endif /* CONFIG_THINGSET_CAN_REPORT_TX_QUEUE */
+
+int thingset_can_send_report_inst(struct thingset_can *ts_can, const char *path,
+                                  enum thingset_data_format format)
 {
-    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
-    struct thingset_can *ts_can = CONTAINER_OF(dwork, struct thingset_can, live_reporting_work);
+    int len, ret = 0;
 
-    if (live_reporting_enable) {
-        thingset_can_send_report_inst(ts_can, TS_NAME_SUBSET_LIVE, THINGSET_BIN_IDS_VALUES);
+    struct thingset_sdk_buf *tx_buf = thingset_sdk_buf_alloc(
+        CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+    if (tx_buf == NULL) {
+        return -ENOMEM;
     }
 
-    ts_can->next_live_report_time += 1000 * live_reporting_period;
-    if (ts_can->next_live_report_time <= k_uptime_get()) {
-        /* ensure proper initialization of next_live_report_time */
-        ts_can->next_live_report_time = k_uptime_get() + 1000 * live_reporting_period;
+    len = thingset_report_path(&ts, tx_buf->data, tx_buf->size, path, format);
+    if (len > 0) {
+        ret = thingset_can_send_report_data(ts_can, tx_buf->data, len);
     }
 
-    thingset_sdk_reschedule_work(dwork, K_TIMEOUT_ABS_MS(ts_can->next_live_report_time));
+    thingset_sdk_buf_free(tx_buf);
+    return ret;
+}
+
+#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
+static void thingset_can_live_report_cb(const uint8_t *buf, size_t len, void *user_data)
+{
+    struct thingset_can *ts_can = user_data;
+
+    thingset_can_send_report_data(ts_can, buf, len);
 }
 #endif /* CONFIG_THINGSET_SUBSET_LIVE_METRICS */
 
@@ -362,6 +774,71 @@ static void thingset_can_item_tx_cb(const struct device *dev, int error, void *u
     /* Do nothing: Single-frame reports are fire and forget. */
 }
 
+static void thingset_can_control_plan_build(struct thingset_can *ts_can)
+{
+    struct thingset_sdk_buf *sbuf =
+        thingset_sdk_buf_alloc(CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_FOREVER);
+    struct thingset_data_object *obj = NULL;
+    int data_len;
+
+    ts_can->control_plan_len = 0;
+
+    while ((obj = thingset_iterate_subsets(&ts, CONFIG_THINGSET_CAN_CONTROL_SUBSET, obj)) != NULL) {
+        /* items which never fit into a single frame are sorted out once */
+        data_len = thingset_export_item(&ts, sbuf->data, sbuf->size, obj, THINGSET_BIN_VALUES_ONLY);
+        if (data_len > CAN_MAX_DLEN) {
+            LOG_WRN("Value of data item %x exceeds single CAN frame payload size", obj->id);
+        }
+        else if (ts_can->control_plan_len >= ARRAY_SIZE(ts_can->control_plan)) {
+            LOG_WRN("Data item %x exceeds control plan size", obj->id);
+        }
+        else {
+            struct thingset_can_control_item *item =
+                &ts_can->control_plan[ts_can->control_plan_len++];
+
+            *item = (struct thingset_can_control_item){
+                .obj = obj,
+                .can_id = THINGSET_CAN_TYPE_SF_REPORT | THINGSET_CAN_PRIO_REPORT_LOW
+                          | THINGSET_CAN_DATA_ID_SET(obj->id),
+#ifdef CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE
+                .min_interval = CONFIG_THINGSET_CAN_CONTROL_MIN_INTERVAL,
+                .max_interval = CONFIG_THINGSET_CAN_CONTROL_MAX_INTERVAL,
+#endif
+            };
+        }
+        obj++; /* continue with object behind current one */
+    }
+    thingset_sdk_buf_free(sbuf);
+}
+
+#ifdef CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE
+static bool thingset_can_control_item_due(struct thingset_can_control_item *item,
+                                          const uint8_t *data, int data_len, uint32_t now)
+{
+    uint32_t elapsed = now - item->last_sent;
+    float value;
+
+    if (!item->sent) {
+        return true;
+    }
+
+    if (elapsed < item->min_interval) {
+        return false;
+    }
+
+    if (item->max_interval > 0 && elapsed >= item->max_interval) {
+        return true;
+    }
+
+    if (thingset_sdk_item_value_float(item->obj, &value)) {
+        /* the comparison is false for NaN, so a change from or to NaN is always published */
+        return !(fabsf(value - item->last_value) <= item->deadband);
+    }
+
+    return data_len != item->last_len || memcmp(data, item->last_data, data_len) != 0;
+}
+#endif /* CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE */
+
 static void thingset_can_control_reporting_handler(struct k_work *work)
 {
     struct k_work_delayable *dwork = k_work_delayable_from_work(work);
@@ -369,88 +846,441 @@ static void thingset_can_control_reporting_handler(struct k_work *work)
     int data_len = 0;
     int err;
 
+#ifdef CONFIG_THINGSET_SDK_WORKQ_STATS
+    thingset_sdk_work_stats_record(THINGSET_SDK_PRIO_CONTROL, ts_can->next_control_report_time);
+#endif
+
     struct can_frame frame = {
         .flags = CAN_FRAME_IDE,
     };
-    struct shared_buffer *sbuf = thingset_sdk_shared_buffer();
-
-    struct thingset_data_object *obj = NULL;
-    while (live_reporting_enable
-           && (obj = thingset_iterate_subsets(&ts, CONFIG_THINGSET_CAN_CONTROL_SUBSET, obj))
-                  != NULL)
-    {
-        k_sem_take(&sbuf->lock, K_FOREVER);
-        data_len = thingset_export_item(&ts, sbuf->data, sbuf->size, obj, THINGSET_BIN_VALUES_ONLY);
-        if (data_len > CAN_MAX_DLEN) {
-            LOG_WRN("Value of data item %x exceeds single CAN frame payload size", obj->id);
-            k_sem_give(&sbuf->lock);
-        }
-        else if (data_len > 0) {
-            memcpy(frame.data, sbuf->data, data_len);
-            k_sem_give(&sbuf->lock);
-            frame.id = THINGSET_CAN_TYPE_SF_REPORT | THINGSET_CAN_PRIO_REPORT_LOW
-                       | THINGSET_CAN_DATA_ID_SET(obj->id)
-                       | THINGSET_CAN_SOURCE_SET(ts_can->node_addr);
 #ifdef CONFIG_CAN_FD_MODE
-            frame.flags |= CAN_FRAME_FDF;
+    frame.flags |= CAN_FRAME_FDF;
 #endif
-            frame.dlc = can_bytes_to_dlc(data_len);
-            err = can_send(ts_can->dev, &frame, K_MSEC(CONFIG_THINGSET_CAN_REPORT_SEND_TIMEOUT),
-                           thingset_can_item_tx_cb, NULL);
-            if (err != 0) {
-                LOG_DBG("Error sending CAN frame with ID %x", frame.id);
-            }
-#ifdef CONFIG_CAN_FD_MODE
-            frame.flags &= ~CAN_FRAME_FDF;
+
+    k_sem_take(&ts_can->control_plan_lock, K_FOREVER);
+
+    for (int i = 0; live_reporting_enable && i < ts_can->control_plan_len; i++) {
+        struct thingset_can_control_item *item = &ts_can->control_plan[i];
+
+        /* the plan only contains items known to fit, so no shared buffer is needed */
+        data_len = thingset_export_item(&ts, frame.data, sizeof(frame.data), item->obj,
+                                        THINGSET_BIN_VALUES_ONLY);
+        if (data_len <= 0) {
+            continue;
+        }
+
+#ifdef CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE
+        uint32_t now = k_uptime_get_32();
+
+        if (!thingset_can_control_item_due(item, frame.data, data_len, now)) {
+            continue;
+        }
 #endif
+
+        frame.id = item->can_id | THINGSET_CAN_SOURCE_SET(ts_can->node_addr);
+        frame.dlc = can_bytes_to_dlc(data_len);
+        err = can_send(ts_can->dev, &frame, K_MSEC(CONFIG_THINGSET_CAN_REPORT_SEND_TIMEOUT),
+                       thingset_can_item_tx_cb, NULL);
+        if (err != 0) {
+            LOG_DBG("Error sending CAN frame with ID %x", frame.id);
+            continue;
         }
-        else {
-            k_sem_give(&sbuf->lock);
+
+#ifdef CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE
+        item->sent = true;
+        item->last_sent = now;
+        thingset_sdk_item_value_float(item->obj, &item->last_value);
+        memcpy(item->last_data, frame.data, data_len);
+        item->last_len = data_len;
+#endif
+    }
+
+    k_sem_give(&ts_can->control_plan_lock);
+
+    ts_can->next_control_report_time += CONFIG_THINGSET_CAN_CONTROL_REPORTING_PERIOD;
+    if (ts_can->next_control_report_time <= k_uptime_get()) {
+        /* ensure proper initialization of next_control_report_time */
+        ts_can->next_control_report_time =
+            k_uptime_get() + CONFIG_THINGSET_CAN_CONTROL_REPORTING_PERIOD;
+    }
+
+    thingset_sdk_reschedule_work_prio(dwork, K_TIMEOUT_ABS_MS(ts_can->next_control_report_time),
+                                      THINGSET_SDK_PRIO_CONTROL);
+}
+
+void thingset_can_update_control_plan_inst(struct thingset_can *ts_can)
+{
+    k_sem_take(&ts_can->control_plan_lock, K_FOREVER);
+    thingset_can_control_plan_build(ts_can);
+    k_sem_give(&ts_can->control_plan_lock);
+}
+
+#ifdef CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE
+int thingset_can_set_control_params_inst(struct thingset_can *ts_can, uint16_t data_id,
+                                         float deadband, uint16_t min_interval,
+                                         uint16_t max_interval)
+{
+    int err = -ENOENT;
+
+    k_sem_take(&ts_can->control_plan_lock, K_FOREVER);
+
+    for (int i = 0; i < ts_can->control_plan_len; i++) {
+        struct thingset_can_control_item *item = &ts_can->control_plan[i];
+
+        if (item->obj->id == data_id) {
+            item->deadband = deadband;
+            item->min_interval = min_interval;
+            item->max_interval = max_interval;
+            err = 0;
+            break;
         }
-        obj++; /* continue with object behind current one */
     }
 
-    ts_can->next_control_report_time += CONFIG_THINGSET_CAN_CONTROL_REPORTING_PERIOD;
-    if (ts_can->next_control_report_time <= k_uptime_get()) {
-        /* ensure proper initialization of next_control_report_time */
-        ts_can->next_control_report_time =
-            k_uptime_get() + CONFIG_THINGSET_CAN_CONTROL_REPORTING_PERIOD;
+    k_sem_give(&ts_can->control_plan_lock);
+
+    return err;
+}
+#endif /* CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE */
+#endif
+
+static struct isotp_fast_addr thingset_can_get_tx_addr(const struct isotp_fast_addr *rx_addr)
+{
+    return (struct isotp_fast_addr){
+        .ext_id = (rx_addr->ext_id & 0x1F000000)
+#ifdef CONFIG_THINGSET_CAN_ROUTING_BUSES
+                  | THINGSET_CAN_TARGET_BUS_SET(THINGSET_CAN_SOURCE_BUS_GET(rx_addr->ext_id))
+                  | THINGSET_CAN_SOURCE_BUS_SET(THINGSET_CAN_TARGET_BUS_GET(rx_addr->ext_id))
+#else /* CONFIG_THINGSET_CAN_ROUTING_BRIDGES */
+                  | THINGSET_CAN_BRIDGE_SET(THINGSET_CAN_BRIDGE_GET(rx_addr->ext_id))
+#endif
+                  | THINGSET_CAN_SOURCE_SET(THINGSET_CAN_TARGET_GET(rx_addr->ext_id))
+                  | THINGSET_CAN_TARGET_SET(THINGSET_CAN_SOURCE_GET(rx_addr->ext_id)),
+    };
+}
+
+static struct isotp_fast_addr thingset_can_get_request_addr(struct thingset_can *ts_can,
+                                                            uint8_t target_addr, uint8_t route)
+{
+    return (struct isotp_fast_addr){
+        .ext_id = THINGSET_CAN_TYPE_REQRESP | THINGSET_CAN_PRIO_REQRESP
+#ifdef CONFIG_THINGSET_CAN_ROUTING_BUSES
+                  | THINGSET_CAN_SOURCE_BUS_SET(ts_can->route) | THINGSET_CAN_TARGET_BUS_SET(route)
+#else /* CONFIG_THINGSET_CAN_ROUTING_BRIDGES */
+                  | THINGSET_CAN_BRIDGE_SET(route)
+#endif
+                  | THINGSET_CAN_SOURCE_SET(ts_can->node_addr)
+                  | THINGSET_CAN_TARGET_SET(target_addr),
+    };
+}
+
+/*
+ * Pending requests are stored in a hash table keyed by the CAN ID of the expected response,
+ * which contains the address and bus/bridge number of the node the request was sent to. A
+ * request to the broadcast address is answered by all nodes, so it is stored separately.
+ *
+ * A transaction is pending as long as it is in the table. Whoever removes it (the response, the
+ * timeout, a send error or a cancellation) invokes the callback and frees the slot afterwards.
+ */
+static inline sys_slist_t *thingset_can_reqresp_bucket(struct thingset_can *ts_can,
+                                                       uint32_t can_id)
+{
+    /* fold the bus/bridge number onto the source address */
+    uint32_t hash = (can_id ^ (can_id >> 16)) & 0xFF;
+
+    return &ts_can->reqresp_buckets[hash % CONFIG_THINGSET_CAN_REQRESP_BUCKETS];
+}
+
+/* must be called with reqresp_lock held */
+static struct thingset_can_request_response *
+thingset_can_reqresp_find(struct thingset_can *ts_can, uint32_t can_id)
+{
+    struct thingset_can_request_response *rr;
+
+    SYS_SLIST_FOR_EACH_CONTAINER(thingset_can_reqresp_bucket(ts_can, can_id), rr, node)
+    {
+        if (rr->can_id == can_id) {
+            return rr;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Removes a transaction from the table. Must be called with reqresp_lock held.
+ *
+ * @returns false if the transaction was already removed, e.g. by the timeout
+ */
+static bool thingset_can_reqresp_unlink(struct thingset_can *ts_can,
+                                        struct thingset_can_request_response *rr)
+{
+    if (!rr->pending) {
+        return false;
+    }
+
+    rr->pending = false;
+    if (rr->functional) {
+        ts_can->reqresp_functional = NULL;
+    }
+    else {
+        sys_slist_find_and_remove(thingset_can_reqresp_bucket(ts_can, rr->can_id), &rr->node);
+    }
+
+    return true;
+}
+
+static void thingset_can_reqresp_free(struct thingset_can_request_response *rr)
+{
+    struct thingset_can *ts_can = rr->ts_can;
+
+    isotp_fast_timeout_stop(&rr->timeout);
+
+    k_spinlock_key_t key = k_spin_lock(&ts_can->reqresp_lock);
+    rr->callback = NULL;
+    rr->cb_arg = NULL;
+    k_spin_unlock(&ts_can->reqresp_lock, key);
+
+    /* wake up senders waiting for a free slot */
+    k_sem_give(&ts_can->reqresp_sem);
+}
+
+/*
+ * Completes a transaction which was unlinked by the caller without a response, optionally
+ * invoking the callback with the given errors. While callbacks for responses to a broadcast
+ * request are still running, the last of them completes the transaction instead, so the slot is
+ * not reused and no response is delivered after the final callback.
+ */
+static void thingset_can_reqresp_complete(struct thingset_can_request_response *rr, bool notify,
+                                          int send_err, int recv_err)
+{
+    struct thingset_can *ts_can = rr->ts_can;
+
+    k_spinlock_key_t key = k_spin_lock(&ts_can->reqresp_lock);
+    if (rr->collecting > 0) {
+        rr->deferred = true;
+        rr->notify = notify;
+        rr->send_err = send_err;
+        rr->recv_err = recv_err;
+        k_spin_unlock(&ts_can->reqresp_lock, key);
+        return;
+    }
+    k_spin_unlock(&ts_can->reqresp_lock, key);
+
+    if (notify) {
+        rr->callback(NULL, 0, send_err, recv_err, 0, rr->cb_arg);
+    }
+    thingset_can_reqresp_free(rr);
+}
+
+static void thingset_can_reqresp_finish(struct thingset_can_request_response *rr, int send_err,
+                                        int recv_err)
+{
+    struct thingset_can *ts_can = rr->ts_can;
+
+    k_spinlock_key_t key = k_spin_lock(&ts_can->reqresp_lock);
+    bool owner = thingset_can_reqresp_unlink(ts_can, rr);
+    k_spin_unlock(&ts_can->reqresp_lock, key);
+
+    if (owner) {
+        thingset_can_reqresp_complete(rr, true, send_err, recv_err);
+    }
+}
+
+static void thingset_can_reqresp_timeout_handler(struct isotp_fast_timeout *timeout)
+{
+    struct thingset_can_request_response *rr =
+        CONTAINER_OF(timeout, struct thingset_can_request_response, timeout);
+
+    thingset_can_reqresp_finish(rr, 0, -ETIMEDOUT);
+}
+
+/*
+ * Adds a transaction to the table. Responses to several requests to the same node cannot be
+ * told apart, so the request has to wait until a previous one to the same node was finished,
+ * just like if all slots are in use.
+ */
+static int thingset_can_reqresp_add(struct thingset_can *ts_can, uint32_t can_id, bool functional,
+                                    thingset_can_reqresp_callback_t callback, void *callback_arg,
+                                    k_timeout_t timeout,
+                                    struct thingset_can_request_response **rr_out)
+{
+    k_timepoint_t end = sys_timepoint_calc(timeout);
+    struct thingset_can_request_response *rr;
+
+    while (true) {
+        k_spinlock_key_t key = k_spin_lock(&ts_can->reqresp_lock);
+
+        rr = NULL;
+        if (functional ? ts_can->reqresp_functional == NULL
+                       : thingset_can_reqresp_find(ts_can, can_id) == NULL)
+        {
+            for (int i = 0; i < ARRAY_SIZE(ts_can->request_response); i++) {
+                if (ts_can->request_response[i].callback == NULL) {
+                    rr = &ts_can->request_response[i];
+                    break;
+                }
+            }
+        }
+
+        if (rr != NULL) {
+            rr->callback = callback;
+            rr->cb_arg = callback_arg;
+            rr->can_id = can_id;
+            rr->functional = functional;
+            rr->pending = true;
+            rr->collecting = 0;
+            rr->deferred = false;
+            if (functional) {
+                ts_can->reqresp_functional = rr;
+            }
+            else {
+                sys_slist_append(thingset_can_reqresp_bucket(ts_can, can_id), &rr->node);
+            }
+            if (!K_TIMEOUT_EQ(timeout, K_FOREVER)) {
+                /*
+                 * The time spent waiting for a slot counts towards the timeout. The remaining
+                 * time is relative also for K_TIMEOUT_ABS_*() and 0 for K_NO_WAIT.
+                 */
+                uint64_t ms = k_ticks_to_ms_ceil64(sys_timepoint_timeout(end).ticks);
+                isotp_fast_timeout_start(&rr->timeout, MIN(ms, ISOTP_FAST_TIMEOUT_MAX_MS));
+            }
+        }
+
+        k_spin_unlock(&ts_can->reqresp_lock, key);
+
+        if (rr != NULL) {
+            *rr_out = rr;
+            return 0;
+        }
+
+        if (k_sem_take(&ts_can->reqresp_sem, sys_timepoint_timeout(end)) != 0) {
+            return -ETIMEDOUT;
+        }
+    }
+}
+
+/*
+ * Delivers a received message to the pending transaction it responds to. Requests to the
+ * broadcast address are answered by all nodes, so the source address is not compared. As requests
+ * from other nodes arrive on the same CAN ID, only responses are accepted then.
+ *
+ * The transaction is looked up and either unlinked or marked as collecting in the same critical
+ * section, so it cannot be completed and its slot reused while the callback runs.
+ *
+ * @returns false if the message does not belong to a pending transaction
+ */
+static bool thingset_can_reqresp_dispatch(struct thingset_can *ts_can, uint32_t can_id,
+                                          uint8_t *data, size_t len)
+{
+    uint8_t source_addr = THINGSET_CAN_SOURCE_GET(can_id);
+    struct thingset_can_request_response *rr;
+
+    k_spinlock_key_t key = k_spin_lock(&ts_can->reqresp_lock);
+
+    rr = thingset_can_reqresp_find(ts_can, can_id);
+    if (rr != NULL) {
+        thingset_can_reqresp_unlink(ts_can, rr);
+        k_spin_unlock(&ts_can->reqresp_lock, key);
+
+        rr->callback(data, len, 0, 0, source_addr, rr->cb_arg);
+        thingset_can_reqresp_free(rr);
+        return true;
+    }
+
+    rr = ts_can->reqresp_functional;
+    if (rr == NULL || ((rr->can_id ^ can_id) & ~THINGSET_CAN_SOURCE_MASK) != 0 || len == 0
+        || (data[0] < 0x80 && data[0] != ':'))
+    {
+        k_spin_unlock(&ts_can->reqresp_lock, key);
+        return false;
+    }
+
+    /* responses are collected until the timeout finishes the transaction */
+    thingset_can_reqresp_callback_t callback = rr->callback;
+    void *cb_arg = rr->cb_arg;
+    rr->collecting++;
+    k_spin_unlock(&ts_can->reqresp_lock, key);
+
+    callback(data, len, 0, 0, source_addr, cb_arg);
+
+    key = k_spin_lock(&ts_can->reqresp_lock);
+    bool complete = --rr->collecting == 0 && rr->deferred;
+    k_spin_unlock(&ts_can->reqresp_lock, key);
+
+    if (complete) {
+        /* the transaction was finished while the callback was running */
+        thingset_can_reqresp_complete(rr, rr->notify, rr->send_err, rr->recv_err);
     }
 
-    thingset_sdk_reschedule_work(dwork, K_TIMEOUT_ABS_MS(ts_can->next_control_report_time));
+    return true;
 }
-#endif
 
-void thingset_can_reset_request_response(struct thingset_can_request_response *rr)
+static int thingset_can_prepare_send(struct thingset_can *ts_can, uint8_t target_addr,
+                                     uint8_t route, thingset_can_reqresp_callback_t callback,
+                                     void *callback_arg, k_timeout_t timeout,
+                                     struct isotp_fast_addr *tx_addr,
+                                     struct thingset_can_request_response **rr)
 {
-    rr->callback = NULL;
-    rr->cb_arg = NULL;
-    rr->can_id = 0;
-    k_timer_stop(&rr->timer);
-    k_sem_give(&rr->sem);
+    if (!device_is_ready(ts_can->dev)) {
+        return -ENODEV;
+    }
+
+    *tx_addr = thingset_can_get_request_addr(ts_can, target_addr, route);
+    *rr = NULL;
+
+    if (callback != NULL) {
+        return thingset_can_reqresp_add(ts_can, thingset_can_get_tx_addr(tx_addr).ext_id,
+                                        target_addr == THINGSET_CAN_ADDR_BROADCAST, callback,
+                                        callback_arg, timeout, rr);
+    }
+
+    return 0;
 }
 
-static struct isotp_fast_addr thingset_can_get_tx_addr(const struct isotp_fast_addr *rx_addr)
+/*
+ * Removes a transaction without invoking its callback, e.g. if the request could not be sent.
+ *
+ * @returns false if the transaction was already finished
+ */
+static bool thingset_can_reqresp_cancel(struct thingset_can_request_response *rr)
 {
-    return (struct isotp_fast_addr){
-        .ext_id = (rx_addr->ext_id & 0x1F000000)
-#ifdef CONFIG_THINGSET_CAN_ROUTING_BUSES
-                  | THINGSET_CAN_TARGET_BUS_SET(THINGSET_CAN_SOURCE_BUS_GET(rx_addr->ext_id))
-                  | THINGSET_CAN_SOURCE_BUS_SET(THINGSET_CAN_TARGET_BUS_GET(rx_addr->ext_id))
-#else /* CONFIG_THINGSET_CAN_ROUTING_BRIDGES */
-                  | THINGSET_CAN_BRIDGE_SET(THINGSET_CAN_BRIDGE_GET(rx_addr->ext_id))
-#endif
-                  | THINGSET_CAN_SOURCE_SET(THINGSET_CAN_TARGET_GET(rx_addr->ext_id))
-                  | THINGSET_CAN_TARGET_SET(THINGSET_CAN_SOURCE_GET(rx_addr->ext_id)),
-    };
+    struct thingset_can *ts_can = rr->ts_can;
+
+    k_spinlock_key_t key = k_spin_lock(&ts_can->reqresp_lock);
+    bool owner = thingset_can_reqresp_unlink(ts_can, rr);
+    k_spin_unlock(&ts_can->reqresp_lock, key);
+
+    if (owner) {
+        thingset_can_reqresp_complete(rr, false, 0, 0);
+    }
+
+    return owner;
 }
 
-static void thingset_can_reqresp_timeout_handler(struct k_timer *timer)
+int thingset_can_cancel_request_inst(struct thingset_can *ts_can, uint8_t target_addr,
+                                     uint8_t route)
 {
-    struct thingset_can_request_response *rr =
-        CONTAINER_OF(timer, struct thingset_can_request_response, timer);
-    rr->callback(NULL, 0, 0, -ETIMEDOUT, 0, rr->cb_arg);
-    thingset_can_reset_request_response(rr);
+    struct isotp_fast_addr tx_addr = thingset_can_get_request_addr(ts_can, target_addr, route);
+    uint32_t can_id = thingset_can_get_tx_addr(&tx_addr).ext_id;
+    struct thingset_can_request_response *rr;
+
+    /* look up and unlink at once, as the slot could be reused in between otherwise */
+    k_spinlock_key_t key = k_spin_lock(&ts_can->reqresp_lock);
+    if (target_addr == THINGSET_CAN_ADDR_BROADCAST) {
+        rr = ts_can->reqresp_functional;
+    }
+    else {
+        rr = thingset_can_reqresp_find(ts_can, can_id);
+    }
+    bool owner = rr != NULL && thingset_can_reqresp_unlink(ts_can, rr);
+    k_spin_unlock(&ts_can->reqresp_lock, key);
+
+    if (!owner) {
+        return -ENOENT;
+    }
+
+    thingset_can_reqresp_complete(rr, false, 0, 0);
+    return 0;
 }
 
 int thingset_can_send_inst(struct thingset_can *ts_can, uint8_t *tx_buf, size_t tx_len,
@@ -458,40 +1288,94 @@ int thingset_can_send_inst(struct thingset_can *ts_can, uint8_t *tx_buf, size_t
                            thingset_can_reqresp_callback_t callback, void *callback_arg,
                            k_timeout_t timeout)
 {
-    if (!device_is_ready(ts_can->dev)) {
-        return -ENODEV;
+    struct thingset_can_request_response *rr;
+    struct isotp_fast_addr tx_addr;
+
+    int ret = thingset_can_prepare_send(ts_can, target_addr, route, callback, callback_arg,
+                                        timeout, &tx_addr, &rr);
+    if (ret != 0) {
+        return ret;
     }
 
-    struct isotp_fast_addr tx_addr = {
-        .ext_id = THINGSET_CAN_TYPE_REQRESP | THINGSET_CAN_PRIO_REQRESP
-#ifdef CONFIG_THINGSET_CAN_ROUTING_BUSES
-                  | THINGSET_CAN_SOURCE_BUS_SET(ts_can->route) | THINGSET_CAN_TARGET_BUS_SET(route)
-#else /* CONFIG_THINGSET_CAN_ROUTING_BRIDGES */
-                  | THINGSET_CAN_BRIDGE_SET(route)
-#endif
-                  | THINGSET_CAN_SOURCE_SET(ts_can->node_addr)
-                  | THINGSET_CAN_TARGET_SET(target_addr),
-    };
+    ret = isotp_fast_send(&ts_can->ctx, tx_buf, tx_len, tx_addr, rr);
 
-    if (callback != NULL) {
-        if (k_sem_take(&ts_can->request_response.sem, timeout) != 0) {
-            return -ETIMEDOUT;
+    if (ret == ISOTP_N_OK) {
+        return 0;
+    }
+    else {
+        LOG_ERR("Error sending data to addr 0x%X: %d", target_addr, ret);
+        if (rr != NULL) {
+            thingset_can_reqresp_cancel(rr);
         }
+        return -EIO;
+    }
+}
 
-        ts_can->request_response.callback = callback;
-        ts_can->request_response.cb_arg = callback_arg;
-        k_timer_init(&ts_can->request_response.timer, thingset_can_reqresp_timeout_handler, NULL);
-        k_timer_start(&ts_can->request_response.timer, timeout, timeout);
-        ts_can->request_response.can_id = thingset_can_get_tx_addr(&tx_addr).ext_id;
+#ifdef CONFIG_THINGSET_CAN_TX_BUF_POOL
+int thingset_can_send_buf_inst(struct thingset_can *ts_can, struct net_buf *buf,
+                               uint8_t target_addr, uint8_t route,
+                               thingset_can_reqresp_callback_t callback, void *callback_arg,
+                               k_timeout_t timeout)
+{
+    struct thingset_can_request_response *rr;
+    struct isotp_fast_addr tx_addr;
+
+    int ret = thingset_can_prepare_send(ts_can, target_addr, route, callback, callback_arg,
+                                        timeout, &tx_addr, &rr);
+    if (ret != 0) {
+        net_buf_unref(buf);
+        return ret;
     }
 
-    int ret = isotp_fast_send(&ts_can->ctx, tx_buf, tx_len, tx_addr, ts_can);
+    ret = isotp_fast_send_buf(&ts_can->ctx, buf, tx_addr, rr);
 
     if (ret == ISOTP_N_OK) {
         return 0;
     }
     else {
         LOG_ERR("Error sending data to addr 0x%X: %d", target_addr, ret);
+        if (rr != NULL) {
+            thingset_can_reqresp_cancel(rr);
+        }
+        return -EIO;
+    }
+}
+#endif /* CONFIG_THINGSET_CAN_TX_BUF_POOL */
+
+int thingset_can_send_broadcast_inst(struct thingset_can *ts_can, uint8_t *tx_buf, size_t tx_len,
+                                     uint8_t route, thingset_can_reqresp_callback_t callback,
+                                     void *callback_arg, k_timeout_t timeout)
+{
+    struct thingset_can_request_response *rr;
+    struct isotp_fast_addr tx_addr;
+
+    /* the collection of responses is only finished by the timeout */
+    if (callback != NULL && K_TIMEOUT_EQ(timeout, K_FOREVER)) {
+        return -EINVAL;
+    }
+
+    int ret = thingset_can_prepare_send(ts_can, THINGSET_CAN_ADDR_BROADCAST, route, callback,
+                                        callback_arg, timeout, &tx_addr, &rr);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = isotp_fast_send_functional(&ts_can->ctx, tx_buf, tx_len, tx_addr, rr);
+
+    if (ret == ISOTP_N_OK) {
+        return 0;
+    }
+
+    if (rr != NULL) {
+        thingset_can_reqresp_cancel(rr);
+    }
+
+    if (ret == ISOTP_N_BUFFER_OVERFLW) {
+        LOG_ERR("Broadcast request of %zu bytes exceeds a single frame", tx_len);
+        return -EMSGSIZE;
+    }
+    else {
+        LOG_ERR("Error sending broadcast request: %d", ret);
         return -EIO;
     }
 }
@@ -506,35 +1390,88 @@ static void thingset_can_reqresp_recv_callback(struct net_buf *buffer, int rem_l
     }
 
     if (rem_len == 0) {
-        size_t len = net_buf_frags_len(buffer);
-        net_buf_linearize(ts_can->rx_buffer, sizeof(ts_can->rx_buffer), buffer, 0, len);
-        if (ts_can->request_response.callback != NULL
-            && ts_can->request_response.can_id == addr.ext_id)
-        {
-            ts_can->request_response.callback(ts_can->rx_buffer, len, 0, 0,
-                                              (uint8_t)(addr.ext_id & 0xFF),
-                                              ts_can->request_response.cb_arg);
-            thingset_can_reset_request_response(&ts_can->request_response);
-        }
-        else {
-            struct shared_buffer *sbuf = thingset_sdk_shared_buffer();
-            k_sem_take(&sbuf->lock, K_FOREVER);
-            int tx_len =
-                thingset_process_message(&ts, ts_can->rx_buffer, len, sbuf->data, sbuf->size);
+#ifdef CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER
+        /* message was reassembled into a single buffer, so it can be processed in place */
+        uint8_t *rx_data = buffer->data;
+        size_t len = buffer->len;
+#else
+        uint8_t *rx_data = ts_can->rx_buffer;
+        size_t len = net_buf_linearize(ts_can->rx_buffer, sizeof(ts_can->rx_buffer), buffer, 0,
+                                       net_buf_frags_len(buffer));
+#endif
+        if (!thingset_can_reqresp_dispatch(ts_can, addr.ext_id, rx_data, len)) {
+            /* reassembled requests are processed right away, so there is no queueing delay */
+            uint32_t rx_time = thingset_sdk_stats_timestamp();
+            uint32_t t;
+#ifdef CONFIG_THINGSET_CAN_TX_BUF_POOL
+            struct thingset_sdk_buf *sbuf = thingset_sdk_buf_alloc(
+                CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+            if (sbuf == NULL) {
+                return;
+            }
+            t = thingset_sdk_stats_record(THINGSET_SDK_STATS_CAN, THINGSET_SDK_STATS_BUF_WAIT,
+                                          rx_time);
+            int tx_len = thingset_sdk_process_message(rx_data, len, sbuf->data, sbuf->size);
+            t = thingset_sdk_stats_record(THINGSET_SDK_STATS_CAN, THINGSET_SDK_STATS_PROCESS, t);
+            /* hand a copy of the response over to ISO-TP, so the TX buffer is free again */
+            struct net_buf *tx_buf = NULL;
+            if (tx_len > 0) {
+                tx_buf = net_buf_alloc_len(&thingset_can_tx_pool, tx_len, K_NO_WAIT);
+                if (tx_buf != NULL) {
+                    net_buf_add_mem(tx_buf, sbuf->data, tx_len);
+                }
+                else {
+                    LOG_ERR("No buffer for response of %d bytes", tx_len);
+                }
+            }
+            thingset_sdk_buf_free(sbuf);
+            if (tx_buf != NULL) {
+                uint8_t target_addr = THINGSET_CAN_SOURCE_GET(addr.ext_id);
+                uint8_t route = IS_ENABLED(CONFIG_THINGSET_CAN_ROUTING_BUSES)
+                                    ? THINGSET_CAN_SOURCE_BUS_GET(addr.ext_id)
+                                    : THINGSET_CAN_BRIDGE_GET(addr.ext_id);
+                thingset_can_send_buf_inst(ts_can, tx_buf, target_addr, route, NULL, NULL,
+                                           K_NO_WAIT);
+                /* the response is sent asynchronously, so only the hand-over to ISO-TP counts */
+                thingset_sdk_stats_record(THINGSET_SDK_STATS_CAN, THINGSET_SDK_STATS_TX, t);
+                thingset_sdk_stats_record(THINGSET_SDK_STATS_CAN, THINGSET_SDK_STATS_TOTAL,
+                                          rx_time);
+            }
+#else
+            /* one response at a time is sent directly from the TX buffer */
+            k_sem_take(&thingset_can_rsp_lock, K_FOREVER);
+            thingset_can_rsp_buf = thingset_sdk_buf_alloc(
+                CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+            if (thingset_can_rsp_buf == NULL) {
+                k_sem_give(&thingset_can_rsp_lock);
+                return;
+            }
+            t = thingset_sdk_stats_record(THINGSET_SDK_STATS_CAN, THINGSET_SDK_STATS_BUF_WAIT,
+                                          rx_time);
+            int tx_len = thingset_sdk_process_message(rx_data, len, thingset_can_rsp_buf->data,
+                                                      thingset_can_rsp_buf->size);
+            thingset_can_rsp_rx_time = rx_time;
+            thingset_can_rsp_tx_time =
+                thingset_sdk_stats_record(THINGSET_SDK_STATS_CAN, THINGSET_SDK_STATS_PROCESS, t);
+            int err = -ENODATA;
             if (tx_len > 0) {
                 uint8_t target_addr = THINGSET_CAN_SOURCE_GET(addr.ext_id);
                 uint8_t route = IS_ENABLED(CONFIG_THINGSET_CAN_ROUTING_BUSES)
                                     ? THINGSET_CAN_SOURCE_BUS_GET(addr.ext_id)
                                     : THINGSET_CAN_BRIDGE_GET(addr.ext_id);
-                int err = thingset_can_send_inst(ts_can, sbuf->data, tx_len, target_addr, route,
-                                                 NULL, NULL, K_NO_WAIT);
-                if (err != 0) {
-                    k_sem_give(&sbuf->lock);
+                struct isotp_fast_addr tx_addr =
+                    thingset_can_get_request_addr(ts_can, target_addr, route);
+                err = isotp_fast_send(&ts_can->ctx, thingset_can_rsp_buf->data, tx_len, tx_addr,
+                                      &thingset_can_rsp_lock);
+                if (err != ISOTP_N_OK) {
+                    LOG_ERR("Error sending response to addr 0x%X: %d", target_addr, err);
                 }
             }
-            else {
-                k_sem_give(&sbuf->lock);
+            if (err != ISOTP_N_OK) {
+                thingset_sdk_buf_free(thingset_can_rsp_buf);
+                k_sem_give(&thingset_can_rsp_lock);
             }
+#endif /* CONFIG_THINGSET_CAN_TX_BUF_POOL */
         }
     }
 }
@@ -547,14 +1484,24 @@ static void thingset_can_reqresp_recv_error_callback(int8_t error, struct isotp_
 
 static void thingset_can_reqresp_sent_callback(int result, void *arg)
 {
-    struct thingset_can *ts_can = arg;
-    if (ts_can->request_response.callback != NULL && result != 0) {
-        ts_can->request_response.callback(NULL, 0, 0, result, 0, ts_can->request_response.cb_arg);
-        thingset_can_reset_request_response(&ts_can->request_response);
+#ifndef CONFIG_THINGSET_CAN_TX_BUF_POOL
+    if (arg == &thingset_can_rsp_lock) {
+        /* responses are sent directly from the TX buffer, which is held until now */
+        thingset_sdk_stats_record(THINGSET_SDK_STATS_CAN, THINGSET_SDK_STATS_TX,
+                                  thingset_can_rsp_tx_time);
+        thingset_sdk_stats_record(THINGSET_SDK_STATS_CAN, THINGSET_SDK_STATS_TOTAL,
+                                  thingset_can_rsp_rx_time);
+        thingset_sdk_buf_free(thingset_can_rsp_buf);
+        k_sem_give(&thingset_can_rsp_lock);
+        return;
     }
-    else {
-        struct shared_buffer *sbuf = thingset_sdk_shared_buffer();
-        k_sem_give(&sbuf->lock);
+#endif
+
+    /* requests expecting a response are sent with their transaction as argument */
+    struct thingset_can_request_response *rr = arg;
+
+    if (rr != NULL && result != 0) {
+        thingset_can_reqresp_finish(rr, result, 0);
     }
 }
 
@@ -573,17 +1520,46 @@ int thingset_can_init_inst(struct thingset_can *ts_can, const struct device *can
     }
 
 #ifdef CONFIG_THINGSET_CAN_REPORT_RX
-    for (int i = 0; i < CONFIG_THINGSET_CAN_REPORT_RX_BUCKETS; i++) {
-        sys_slist_init(&rx_buf_lookup[i]);
-    }
+    memset(ts_can->report_rx_bufs, 0, sizeof(ts_can->report_rx_bufs));
+    memset(&ts_can->report_rx_stats, 0, sizeof(ts_can->report_rx_stats));
+#endif
+#ifdef CONFIG_THINGSET_CAN_ITEM_RX
+    k_sem_init(&ts_can->item_rx_lock, 1, 1);
+    ts_can->item_rx_subs_count = 0;
+    ts_can->item_rx_filter_count = 0;
+    ts_can->item_rx_sw_filter = false;
+#endif
+#ifdef CONFIG_THINGSET_CAN_RX_DISPATCH
+    atomic_set(&ts_can->rx_dispatch_head, 0);
+    atomic_set(&ts_can->rx_dispatch_tail, 0);
+    memset(&ts_can->rx_dispatch_stats, 0, sizeof(ts_can->rx_dispatch_stats));
+
+    k_spinlock_key_t key = k_spin_lock(&rx_dispatch_lock);
+    sys_slist_append(&rx_dispatch_list, &ts_can->rx_dispatch_node);
+    k_spin_unlock(&rx_dispatch_lock, key);
 #endif
-    k_sem_init(&ts_can->request_response.sem, 1, 1);
+    k_sem_init(&ts_can->reqresp_sem, 0, K_SEM_MAX_LIMIT);
+    for (int i = 0; i < CONFIG_THINGSET_CAN_REQRESP_BUCKETS; i++) {
+        sys_slist_init(&ts_can->reqresp_buckets[i]);
+    }
+    for (int i = 0; i < ARRAY_SIZE(ts_can->request_response); i++) {
+        struct thingset_can_request_response *rr = &ts_can->request_response[i];
+        rr->ts_can = ts_can;
+        rr->callback = NULL;
+        rr->pending = false;
+        isotp_fast_timeout_init(&rr->timeout, thingset_can_reqresp_timeout_handler);
+    }
+    ts_can->reqresp_functional = NULL;
+#ifdef CONFIG_THINGSET_CAN_REPORT_TX_QUEUE
+    k_timer_init(&ts_can->report_tx_timer, thingset_can_report_tx_timer_handler, NULL);
+    sys_slist_init(&ts_can->report_tx_queue);
+    ts_can->report_tx_buf = NULL;
+#else
     k_sem_init(&ts_can->report_tx_sem, 0, 1);
-
-#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
-    k_work_init_delayable(&ts_can->live_reporting_work, thingset_can_live_reporting_handler);
 #endif
+
 #ifdef CONFIG_THINGSET_CAN_CONTROL_REPORTING
+    k_sem_init(&ts_can->control_plan_lock, 1, 1);
     k_work_init_delayable(&ts_can->control_reporting_work, thingset_can_control_reporting_handler);
 #endif
     k_work_init_delayable(&ts_can->addr_claim_work, thingset_can_addr_claim_tx_handler);
@@ -723,11 +1699,29 @@ int thingset_can_init_inst(struct thingset_can *ts_can, const struct device *can
                     ts_can, thingset_can_reqresp_recv_error_callback,
                     thingset_can_reqresp_sent_callback);
 
+#ifdef CONFIG_THINGSET_CAN_BROADCAST_REQUESTS
+    struct isotp_fast_addr broadcast_addr = {
+        .ext_id = THINGSET_CAN_TYPE_REQRESP | THINGSET_CAN_PRIO_REQRESP
+                  | THINGSET_CAN_TARGET_SET(THINGSET_CAN_ADDR_BROADCAST),
+    };
+    if (isotp_fast_add_rx_addr(&ts_can->ctx, broadcast_addr,
+                               CONFIG_ISOTP_FAST_CUSTOM_ADDRESSING_RX_MASK, true)
+        != ISOTP_N_OK)
+    {
+        LOG_ERR("Unable to add filter for broadcast requests");
+    }
+#endif
+
 #ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
-    thingset_sdk_reschedule_work(&ts_can->live_reporting_work, K_NO_WAIT);
+    ts_can->live_report_sink.callback = thingset_can_live_report_cb;
+    ts_can->live_report_sink.user_data = ts_can;
+    ts_can->live_report_sink.format = THINGSET_BIN_IDS_VALUES;
+    thingset_sdk_add_live_report_sink(&ts_can->live_report_sink);
 #endif
 #ifdef CONFIG_THINGSET_CAN_CONTROL_REPORTING
-    thingset_sdk_reschedule_work(&ts_can->control_reporting_work, K_NO_WAIT);
+    thingset_can_update_control_plan_inst(ts_can);
+    thingset_sdk_reschedule_work_prio(&ts_can->control_reporting_work, K_NO_WAIT,
+                                      THINGSET_SDK_PRIO_CONTROL);
 #endif
 
     return 0;
@@ -762,12 +1756,170 @@ int thingset_can_set_report_rx_callback_inst(struct thingset_can *ts_can,
 
     return 0;
 }
+
+void thingset_can_get_report_rx_stats_inst(const struct thingset_can *ts_can,
+                                           struct thingset_can_report_rx_stats *stats)
+{
+    *stats = ts_can->report_rx_stats;
+}
 #endif /* CONFIG_THINGSET_CAN_REPORT_RX */
 
 #ifdef CONFIG_THINGSET_CAN_ITEM_RX
+/*
+ * Merges two filters into the narrowest filter accepting both.
+ *
+ * @returns true if the merged filter accepts exactly the IDs of both filters
+ */
+static bool thingset_can_item_filters_merge(const struct can_filter *a, const struct can_filter *b,
+                                            struct can_filter *merged)
+{
+    uint32_t diff = a->id ^ b->id;
+
+    merged->mask = a->mask & b->mask & ~diff;
+    merged->id = a->id & merged->mask;
+    merged->flags = CAN_FILTER_IDE;
+
+    /* one filter contains the other or both are halves of the merged filter */
+    return merged->mask == a->mask || merged->mask == b->mask
+           || (a->mask == b->mask && IS_POWER_OF_TWO(diff) && (diff & a->mask) != 0);
+}
+
+/*
+ * Adds a filter to the set, merging filters until the set fits into the available filters.
+ *
+ * The set must have room for one filter more than CONFIG_THINGSET_CAN_ITEM_RX_FILTERS.
+ *
+ * @returns false if filters had to be widened beyond the subscribed IDs
+ */
+static bool thingset_can_item_filters_add(struct can_filter *filters, int *count,
+                                          const struct can_filter *filter)
+{
+    struct can_filter merged;
+    bool exact = true;
+
+    filters[(*count)++] = *filter;
+
+    while (*count > 1) {
+        int best_i = -1, best_j = -1;
+        int best_bits = -1;
+        bool best_exact = false;
+
+        for (int i = 0; i < *count - 1; i++) {
+            for (int j = i + 1; j < *count; j++) {
+                bool pair_exact =
+                    thingset_can_item_filters_merge(&filters[i], &filters[j], &merged);
+                /* the more bits are compared, the fewer IDs are accepted in excess */
+                int bits = POPCOUNT(merged.mask);
+                if ((pair_exact && !best_exact) || (pair_exact == best_exact && bits > best_bits)) {
+                    best_i = i;
+                    best_j = j;
+                    best_bits = bits;
+                    best_exact = pair_exact;
+                }
+            }
+        }
+
+        /* exact merges are always done, as they save filters for free */
+        if (!best_exact && *count <= CONFIG_THINGSET_CAN_ITEM_RX_FILTERS) {
+            break;
+        }
+
+        thingset_can_item_filters_merge(&filters[best_i], &filters[best_j], &filters[best_i]);
+        filters[best_j] = filters[--(*count)];
+        exact = exact && best_exact;
+    }
+
+    return exact;
+}
+
+static void thingset_can_item_rx_filters_remove(struct thingset_can *ts_can)
+{
+    for (int i = 0; i < ts_can->item_rx_filter_count; i++) {
+        can_remove_rx_filter(ts_can->dev, ts_can->item_rx_filter_ids[i]);
+    }
+    ts_can->item_rx_filter_count = 0;
+}
+
+/*
+ * Compiles the subscriptions into CAN filters and installs them.
+ */
+static int thingset_can_item_rx_filters_install(struct thingset_can *ts_can)
+{
+    struct can_filter filters[CONFIG_THINGSET_CAN_ITEM_RX_FILTERS + 1];
+    int count = 0;
+    bool exact = true;
+
+    if (ts_can->item_rx_subs_count == 0) {
+        filters[count++] = sf_report_filter;
+    }
+
+    for (int i = 0; i < ts_can->item_rx_subs_count; i++) {
+        struct thingset_can_item_subscription *sub = &ts_can->item_rx_subs[i];
+        uint32_t source_mask = 0;
+        uint32_t lo = sub->data_id_min;
+
+        if (sub->source_addr != THINGSET_CAN_ADDR_BROADCAST) {
+            source_mask = THINGSET_CAN_SOURCE_MASK;
+        }
+
+        /* split the range into the largest aligned blocks, each matched by a single filter */
+        while (lo <= sub->data_id_max) {
+            uint32_t size = (lo == 0) ? BIT(16) : (lo & -lo);
+            while (lo + size - 1 > sub->data_id_max) {
+                size >>= 1;
+            }
+
+            struct can_filter filter = {
+                .id = THINGSET_CAN_TYPE_SF_REPORT | THINGSET_CAN_DATA_ID_SET(lo)
+                      | (THINGSET_CAN_SOURCE_SET(sub->source_addr) & source_mask),
+                .mask = THINGSET_CAN_TYPE_MASK | THINGSET_CAN_DATA_ID_SET(~(size - 1))
+                        | source_mask,
+                .flags = CAN_FILTER_IDE,
+            };
+            exact = thingset_can_item_filters_add(filters, &count, &filter) && exact;
+
+            lo += size;
+        }
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&ts_can->item_rx_subs_lock);
+    ts_can->item_rx_sw_filter = !exact;
+    k_spin_unlock(&ts_can->item_rx_subs_lock, key);
+
+    for (int i = 0; i < count; i++) {
+        int filter_id =
+            can_add_rx_filter(ts_can->dev, thingset_can_item_rx_cb, ts_can, &filters[i]);
+        if (filter_id < 0) {
+            if (i == 0) {
+                LOG_ERR("Unable to add report filter: %d", filter_id);
+                return filter_id;
+            }
+
+            /* controller ran out of filters: accept all items and filter in software */
+            LOG_WRN("Only %d of %d filters available for data items", i, count);
+            thingset_can_item_rx_filters_remove(ts_can);
+            key = k_spin_lock(&ts_can->item_rx_subs_lock);
+            ts_can->item_rx_sw_filter = ts_can->item_rx_subs_count > 0;
+            k_spin_unlock(&ts_can->item_rx_subs_lock, key);
+            filters[0] = sf_report_filter;
+            count = 1;
+            i = -1;
+            continue;
+        }
+        ts_can->item_rx_filter_ids[ts_can->item_rx_filter_count++] = filter_id;
+    }
+
+    LOG_DBG("Installed %d filters for data items (software filter %s)", count,
+            ts_can->item_rx_sw_filter ? "on" : "off");
+
+    return 0;
+}
+
 int thingset_can_set_item_rx_callback_inst(struct thingset_can *ts_can,
                                            thingset_can_item_rx_callback_t rx_cb)
 {
+    int err;
+
     if (!device_is_ready(ts_can->dev)) {
         return -ENODEV;
     }
@@ -776,16 +1928,81 @@ int thingset_can_set_item_rx_callback_inst(struct thingset_can *ts_can,
         return -EINVAL;
     }
 
+    k_sem_take(&ts_can->item_rx_lock, K_FOREVER);
+
+    thingset_can_item_rx_filters_remove(ts_can);
     ts_can->item_rx_cb = rx_cb;
+    err = thingset_can_item_rx_filters_install(ts_can);
 
-    int filter_id =
-        can_add_rx_filter(ts_can->dev, thingset_can_item_rx_cb, ts_can, &sf_report_filter);
-    if (filter_id < 0) {
-        LOG_ERR("Unable to add report filter: %d", filter_id);
-        return filter_id;
+    k_sem_give(&ts_can->item_rx_lock);
+
+    return err;
+}
+
+int thingset_can_subscribe_items_inst(struct thingset_can *ts_can, uint8_t source_addr,
+                                      uint16_t data_id_min, uint16_t data_id_max)
+{
+    int err = 0;
+
+    if (data_id_min > data_id_max) {
+        return -EINVAL;
     }
 
-    return 0;
+    k_sem_take(&ts_can->item_rx_lock, K_FOREVER);
+
+    if (ts_can->item_rx_subs_count >= ARRAY_SIZE(ts_can->item_rx_subs)) {
+        err = -ENOMEM;
+        goto out;
+    }
+
+    thingset_can_item_rx_filters_remove(ts_can);
+
+    /* the RX callback of a frame received before the filters were removed may still run */
+    k_spinlock_key_t key = k_spin_lock(&ts_can->item_rx_subs_lock);
+    ts_can->item_rx_subs[ts_can->item_rx_subs_count++] = (struct thingset_can_item_subscription){
+        .data_id_min = data_id_min,
+        .data_id_max = data_id_max,
+        .source_addr = source_addr,
+    };
+    k_spin_unlock(&ts_can->item_rx_subs_lock, key);
+
+    if (ts_can->item_rx_cb != NULL) {
+        err = thingset_can_item_rx_filters_install(ts_can);
+    }
+
+out:
+    k_sem_give(&ts_can->item_rx_lock);
+
+    return err;
+}
+
+int thingset_can_unsubscribe_items_inst(struct thingset_can *ts_can, uint8_t source_addr,
+                                        uint16_t data_id_min, uint16_t data_id_max)
+{
+    int err = -ENOENT;
+
+    k_sem_take(&ts_can->item_rx_lock, K_FOREVER);
+
+    for (int i = 0; i < ts_can->item_rx_subs_count; i++) {
+        struct thingset_can_item_subscription *sub = &ts_can->item_rx_subs[i];
+        if (sub->source_addr == source_addr && sub->data_id_min == data_id_min
+            && sub->data_id_max == data_id_max)
+        {
+            thingset_can_item_rx_filters_remove(ts_can);
+            k_spinlock_key_t key = k_spin_lock(&ts_can->item_rx_subs_lock);
+            *sub = ts_can->item_rx_subs[--ts_can->item_rx_subs_count];
+            k_spin_unlock(&ts_can->item_rx_subs_lock, key);
+            err = 0;
+            if (ts_can->item_rx_cb != NULL) {
+                err = thingset_can_item_rx_filters_install(ts_can);
+            }
+            break;
+        }
+    }
+
+    k_sem_give(&ts_can->item_rx_lock);
+
+    return err;
 }
 #endif /* CONFIG_THINGSET_CAN_ITEM_RX */
 
@@ -820,11 +2037,62 @@ int thingset_can_send(uint8_t *tx_buf, size_t tx_len, uint8_t target_addr, uint8
                                   callback_arg, timeout);
 }
 
+#ifdef CONFIG_THINGSET_CAN_TX_BUF_POOL
+int thingset_can_send_buf(struct net_buf *buf, uint8_t target_addr, uint8_t route,
+                          thingset_can_reqresp_callback_t callback, void *callback_arg,
+                          k_timeout_t timeout)
+{
+    return thingset_can_send_buf_inst(&ts_can_single, buf, target_addr, route, callback,
+                                      callback_arg, timeout);
+}
+#endif
+
+int thingset_can_send_broadcast(uint8_t *tx_buf, size_t tx_len, uint8_t route,
+                                thingset_can_reqresp_callback_t callback, void *callback_arg,
+                                k_timeout_t timeout)
+{
+    return thingset_can_send_broadcast_inst(&ts_can_single, tx_buf, tx_len, route, callback,
+                                            callback_arg, timeout);
+}
+
+int thingset_can_cancel_request(uint8_t target_addr, uint8_t route)
+{
+    return thingset_can_cancel_request_inst(&ts_can_single, target_addr, route);
+}
+
+#ifdef CONFIG_THINGSET_CAN_CONTROL_REPORTING
+void thingset_can_update_control_plan(void)
+{
+    thingset_can_update_control_plan_inst(&ts_can_single);
+}
+#endif
+
+#ifdef CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE
+int thingset_can_set_control_params(uint16_t data_id, float deadband, uint16_t min_interval,
+                                    uint16_t max_interval)
+{
+    return thingset_can_set_control_params_inst(&ts_can_single, data_id, deadband, min_interval,
+                                                max_interval);
+}
+#endif
+
 #ifdef CONFIG_THINGSET_CAN_REPORT_RX
 int thingset_can_set_report_rx_callback(thingset_can_report_rx_callback_t rx_cb)
 {
     return thingset_can_set_report_rx_callback_inst(&ts_can_single, rx_cb);
 }
+
+void thingset_can_get_report_rx_stats(struct thingset_can_report_rx_stats *stats)
+{
+    thingset_can_get_report_rx_stats_inst(&ts_can_single, stats);
+}
+#endif
+
+#ifdef CONFIG_THINGSET_CAN_RX_DISPATCH
+void thingset_can_get_rx_dispatch_stats(struct thingset_can_rx_dispatch_stats *stats)
+{
+    thingset_can_get_rx_dispatch_stats_inst(&ts_can_single, stats);
+}
 #endif
 
 #ifdef CONFIG_THINGSET_CAN_ITEM_RX
@@ -832,6 +2100,19 @@ int thingset_can_set_item_rx_callback(thingset_can_item_rx_callback_t rx_cb)
 {
     return thingset_can_set_item_rx_callback_inst(&ts_can_single, rx_cb);
 }
+
+int thingset_can_subscribe_items(uint8_t source_addr, uint16_t data_id_min, uint16_t data_id_max)
+{
+    return thingset_can_subscribe_items_inst(&ts_can_single, source_addr, data_id_min,
+                                             data_id_max);
+}
+
+int thingset_can_unsubscribe_items(uint8_t source_addr, uint16_t data_id_min,
+                                   uint16_t data_id_max)
+{
+    return thingset_can_unsubscribe_items_inst(&ts_can_single, source_addr, data_id_min,
+                                               data_id_max);
+}
 #endif
 
 struct thingset_can *thingset_can_get_inst()
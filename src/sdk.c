@@ -11,6 +11,7 @@
 #include <zephyr/random/random.h>
 #include <zephyr/sys/crc.h>
 
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -35,6 +36,7 @@ uint8_t eui64[8];
 
 char node_name[] = CONFIG_THINGSET_NODE_NAME;
 
+#ifdef CONFIG_THINGSET_SHARED_TX_BUF
 /* buffer should be word-aligned e.g. for hardware CRC calculations */
 static uint8_t buf_data[CONFIG_THINGSET_SHARED_TX_BUF_SIZE] __aligned(sizeof(int));
 
@@ -42,19 +44,71 @@ static struct shared_buffer sbuf = {
     .data = buf_data,
     .size = sizeof(buf_data),
 };
+#endif
+
+#define SDK_BUF_BLOCK_SIZE \
+    ROUND_UP(sizeof(struct thingset_sdk_buf) + CONFIG_THINGSET_SHARED_TX_BUF_SIZE, sizeof(int))
 
+K_MEM_SLAB_DEFINE_STATIC(sdk_buf_slab, SDK_BUF_BLOCK_SIZE, CONFIG_THINGSET_SDK_BUF_COUNT,
+                         sizeof(int));
+
+K_THREAD_STACK_DEFINE(control_stack_area, CONFIG_THINGSET_SDK_CONTROL_THREAD_STACK_SIZE);
 K_THREAD_STACK_DEFINE(thread_stack_area, CONFIG_THINGSET_SDK_THREAD_STACK_SIZE);
+K_THREAD_STACK_DEFINE(background_stack_area, CONFIG_THINGSET_SDK_BACKGROUND_THREAD_STACK_SIZE);
 
 /*
- * The services need a dedicated work queue, as the LoRaWAN stack uses the system
+ * The services need dedicated work queues, as the LoRaWAN stack uses the system
  * work queue and gets blocked if other LoRaWAN messages are sent and processed from
  * the system work queue in parallel.
+ *
+ * Separate queues per priority tier ensure that e.g. a slow EEPROM write does not delay
+ * a control report.
  */
-static struct k_work_q thingset_workq;
+static struct k_work_q thingset_workq[THINGSET_SDK_PRIO_COUNT];
+
+#ifdef CONFIG_THINGSET_SDK_WORKQ_STATS
+static struct thingset_sdk_work_stats work_stats[THINGSET_SDK_PRIO_COUNT];
+static struct k_spinlock work_stats_lock;
+#endif
+
+#ifdef CONFIG_THINGSET_REPORT_CACHE
+struct report_cache_entry
+{
+    /** subset the report was generated from, 0 if the entry is unused */
+    uint16_t subset;
+    enum thingset_data_format format;
+    /** length of the cached report, 0 if no valid report is cached */
+    uint16_t len;
+    /** number of consecutive periods the report was not sent */
+    uint8_t suppressed;
+    uint8_t data[CONFIG_THINGSET_REPORT_CACHE_SIZE];
+};
+
+/* entries are only modified by the live reporting work */
+static struct report_cache_entry report_cache[CONFIG_THINGSET_REPORT_CACHE_ENTRIES];
+
+/* set for entries which have to be encoded again, can be set from any context */
+static ATOMIC_DEFINE(report_cache_dirty, CONFIG_THINGSET_REPORT_CACHE_ENTRIES);
+#endif
+
+#ifdef CONFIG_THINGSET_OBSERVE
+static void observe_handler(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(observe_work, observe_handler);
+static K_MUTEX_DEFINE(observers_lock);
+static sys_slist_t observers = SYS_SLIST_STATIC_INIT(&observers);
+#endif
 
 #ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
 bool live_reporting_enable = IS_ENABLED(CONFIG_THINGSET_REPORTING_LIVE_ENABLE_PRESET);
 uint32_t live_reporting_period = CONFIG_THINGSET_REPORTING_LIVE_PERIOD_PRESET;
+
+static struct k_work_delayable live_reporting_work;
+static int64_t next_live_report_time;
+
+/* sinks are only added and never removed, so the reporting handler traverses it without lock */
+static sys_slist_t live_report_sinks = SYS_SLIST_STATIC_INIT(&live_report_sinks);
+static struct k_spinlock live_report_sinks_lock;
 #endif
 
 #ifdef CONFIG_THINGSET_SUBSET_SUMMARY_METRICS
@@ -103,6 +157,58 @@ THINGSET_ADD_ITEM_UINT32(TS_ID_REP_SUMMARY, TS_ID_REP_SUMMARY_PERIOD, "sPeriod_s
                          &summary_reporting_period, THINGSET_ANY_RW, TS_SUBSET_NVM);
 #endif
 
+#ifdef CONFIG_THINGSET_SDK_STATS
+struct stats_summary
+{
+    uint32_t reqs;
+    uint32_t proc_max;
+    uint32_t total_max;
+};
+
+static struct thingset_sdk_latency_stats latency_stats[THINGSET_SDK_STATS_TRANSPORT_COUNT]
+                                                      [THINGSET_SDK_STATS_PHASE_COUNT];
+static struct k_spinlock latency_stats_lock;
+
+/* values of the _Stats group, updated before it is read */
+static struct stats_summary stats_summary[THINGSET_SDK_STATS_TRANSPORT_COUNT];
+
+static void stats_group_callback(enum thingset_callback_reason reason);
+static int32_t stats_reset(void);
+
+THINGSET_ADD_GROUP(TS_ID_ROOT, TS_ID_STATS, "_Stats", stats_group_callback);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_SERIAL_REQS, "rSerialReqs",
+                         &stats_summary[THINGSET_SDK_STATS_SERIAL].reqs, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_SERIAL_PROC_MAX, "rSerialProcMax_us",
+                         &stats_summary[THINGSET_SDK_STATS_SERIAL].proc_max, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_SERIAL_TOTAL_MAX, "rSerialTotalMax_us",
+                         &stats_summary[THINGSET_SDK_STATS_SERIAL].total_max, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_BLE_REQS, "rBLEReqs",
+                         &stats_summary[THINGSET_SDK_STATS_BLE].reqs, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_BLE_PROC_MAX, "rBLEProcMax_us",
+                         &stats_summary[THINGSET_SDK_STATS_BLE].proc_max, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_BLE_TOTAL_MAX, "rBLETotalMax_us",
+                         &stats_summary[THINGSET_SDK_STATS_BLE].total_max, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_CAN_REQS, "rCANReqs",
+                         &stats_summary[THINGSET_SDK_STATS_CAN].reqs, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_CAN_PROC_MAX, "rCANProcMax_us",
+                         &stats_summary[THINGSET_SDK_STATS_CAN].proc_max, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_CAN_TOTAL_MAX, "rCANTotalMax_us",
+                         &stats_summary[THINGSET_SDK_STATS_CAN].total_max, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_WEBSOCKET_REQS, "rWebsocketReqs",
+                         &stats_summary[THINGSET_SDK_STATS_WEBSOCKET].reqs, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_WEBSOCKET_PROC_MAX, "rWebsocketProcMax_us",
+                         &stats_summary[THINGSET_SDK_STATS_WEBSOCKET].proc_max, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_WEBSOCKET_TOTAL_MAX, "rWebsocketTotalMax_us",
+                         &stats_summary[THINGSET_SDK_STATS_WEBSOCKET].total_max, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_SHELL_REQS, "rShellReqs",
+                         &stats_summary[THINGSET_SDK_STATS_SHELL].reqs, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_SHELL_PROC_MAX, "rShellProcMax_us",
+                         &stats_summary[THINGSET_SDK_STATS_SHELL].proc_max, THINGSET_ANY_R, 0);
+THINGSET_ADD_ITEM_UINT32(TS_ID_STATS, TS_ID_STATS_SHELL_TOTAL_MAX, "rShellTotalMax_us",
+                         &stats_summary[THINGSET_SDK_STATS_SHELL].total_max, THINGSET_ANY_R, 0);
+THINGSET_ADD_FN_INT32(TS_ID_STATS, TS_ID_STATS_RESET, "xReset", &stats_reset, THINGSET_ANY_RW);
+#endif /* CONFIG_THINGSET_SDK_STATS */
+
 #ifdef CONFIG_THINGSET_GENERATE_NODE_ID
 /*
  * Requirement: Generate a 64-bit ID from the 96-bit STM32 CPUID with very low
@@ -153,25 +259,576 @@ static void generate_device_eui()
 }
 #endif /* CONFIG_THINGSET_GENERATE_NODE_ID */
 
+#ifdef CONFIG_THINGSET_SHARED_TX_BUF
 struct shared_buffer *thingset_sdk_shared_buffer(void)
 {
     return &sbuf;
 }
+#endif
+
+struct thingset_sdk_buf *thingset_sdk_buf_alloc(size_t size, k_timeout_t timeout)
+{
+    struct thingset_sdk_buf *buf;
+
+    if (size > CONFIG_THINGSET_SHARED_TX_BUF_SIZE) {
+        LOG_ERR("Requested buffer of %zu bytes exceeds max. size", size);
+        return NULL;
+    }
+
+    if (k_mem_slab_alloc(&sdk_buf_slab, (void **)&buf, timeout) != 0) {
+        LOG_WRN("No TX buffer available");
+        return NULL;
+    }
+
+    buf->size = CONFIG_THINGSET_SHARED_TX_BUF_SIZE;
+    return buf;
+}
+
+void thingset_sdk_buf_free(struct thingset_sdk_buf *buf)
+{
+    k_mem_slab_free(&sdk_buf_slab, buf);
+}
+
+int thingset_sdk_reschedule_work_prio(struct k_work_delayable *dwork, k_timeout_t delay,
+                                      enum thingset_sdk_prio prio)
+{
+    if (prio >= THINGSET_SDK_PRIO_COUNT) {
+        return -EINVAL;
+    }
+
+    return k_work_reschedule_for_queue(&thingset_workq[prio], dwork, delay);
+}
 
 int thingset_sdk_reschedule_work(struct k_work_delayable *dwork, k_timeout_t delay)
 {
-    return k_work_reschedule_for_queue(&thingset_workq, dwork, delay);
+    return thingset_sdk_reschedule_work_prio(dwork, delay, THINGSET_SDK_PRIO_COMM);
+}
+
+#ifdef CONFIG_THINGSET_SDK_WORKQ_STATS
+void thingset_sdk_work_stats_record(enum thingset_sdk_prio prio, int64_t deadline)
+{
+    if (prio >= THINGSET_SDK_PRIO_COUNT || deadline <= 0) {
+        return;
+    }
+
+    int64_t lateness = k_uptime_get() - deadline;
+    struct thingset_sdk_work_stats *stats = &work_stats[prio];
+
+    k_spinlock_key_t key = k_spin_lock(&work_stats_lock);
+    stats->runs++;
+    if (lateness > 0) {
+        stats->late++;
+        stats->total_lateness += lateness;
+        if (lateness > stats->max_lateness) {
+            stats->max_lateness = lateness;
+        }
+    }
+    k_spin_unlock(&work_stats_lock, key);
+}
+
+int thingset_sdk_get_work_stats(enum thingset_sdk_prio prio, struct thingset_sdk_work_stats *stats)
+{
+    if (prio >= THINGSET_SDK_PRIO_COUNT) {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&work_stats_lock);
+    *stats = work_stats[prio];
+    k_spin_unlock(&work_stats_lock, key);
+
+    return 0;
+}
+#endif /* CONFIG_THINGSET_SDK_WORKQ_STATS */
+
+/* requests which may change data */
+static bool thingset_sdk_is_write_request(uint8_t function_code)
+{
+    switch (function_code) {
+        case THINGSET_BIN_EXEC:
+        case THINGSET_BIN_DELETE:
+        case THINGSET_BIN_CREATE:
+        case THINGSET_BIN_UPDATE:
+        case THINGSET_BIN_DESIRE:
+        case THINGSET_TXT_EXEC:
+        case THINGSET_TXT_DELETE:
+        case THINGSET_TXT_CREATE:
+        case THINGSET_TXT_UPDATE:
+        case THINGSET_TXT_DESIRE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int thingset_sdk_process_message(const uint8_t *req, size_t req_len, uint8_t *rsp,
+                                 size_t rsp_size)
+{
+    int len = thingset_process_message(&ts, req, req_len, rsp, rsp_size);
+
+    if (req_len > 0 && thingset_sdk_is_write_request(req[0])) {
+        thingset_sdk_mark_dirty(NULL);
+    }
+
+    return len;
+}
+
+void thingset_sdk_mark_dirty(const struct thingset_data_object *obj)
+{
+#ifdef CONFIG_THINGSET_REPORT_CACHE
+    for (int i = 0; i < ARRAY_SIZE(report_cache); i++) {
+        if (obj == NULL || (obj->subsets & report_cache[i].subset) != 0) {
+            atomic_set_bit(report_cache_dirty, i);
+        }
+    }
+#endif
+}
+
+bool thingset_sdk_item_value_float(const struct thingset_data_object *obj, float *value)
+{
+    switch (obj->type) {
+        case THINGSET_TYPE_U8:
+            *value = *obj->data.u8;
+            return true;
+        case THINGSET_TYPE_I8:
+            *value = *obj->data.i8;
+            return true;
+        case THINGSET_TYPE_U16:
+            *value = *obj->data.u16;
+            return true;
+        case THINGSET_TYPE_I16:
+            *value = *obj->data.i16;
+            return true;
+        case THINGSET_TYPE_U32:
+            *value = *obj->data.u32;
+            return true;
+        case THINGSET_TYPE_I32:
+        case THINGSET_TYPE_DECFRAC:
+            *value = *obj->data.i32;
+            return true;
+        case THINGSET_TYPE_F32:
+            *value = *obj->data.f32;
+            return true;
+        default:
+            return false;
+    }
+}
+
+#ifdef CONFIG_THINGSET_SDK_STATS
+static const char *const stats_transport_names[] = {
+    [THINGSET_SDK_STATS_SERIAL] = "serial",
+    [THINGSET_SDK_STATS_BLE] = "ble",
+    [THINGSET_SDK_STATS_CAN] = "can",
+    [THINGSET_SDK_STATS_WEBSOCKET] = "websocket",
+    [THINGSET_SDK_STATS_SHELL] = "shell",
+};
+
+static const char *const stats_phase_names[] = {
+    [THINGSET_SDK_STATS_QUEUE] = "queue",
+    [THINGSET_SDK_STATS_BUF_WAIT] = "buf_wait",
+    [THINGSET_SDK_STATS_PROCESS] = "process",
+    [THINGSET_SDK_STATS_TX] = "tx",
+    [THINGSET_SDK_STATS_TOTAL] = "total",
+};
+
+uint32_t thingset_sdk_stats_record(enum thingset_sdk_stats_transport transport,
+                                   enum thingset_sdk_stats_phase phase, uint32_t start)
+{
+    uint32_t now = k_cycle_get_32();
+
+    if (transport >= THINGSET_SDK_STATS_TRANSPORT_COUNT || phase >= THINGSET_SDK_STATS_PHASE_COUNT)
+    {
+        return now;
+    }
+
+    uint32_t us = k_cyc_to_us_floor32(now - start);
+
+    /* bucket i covers [2^i, 2^(i+1)) us */
+    int bucket = us > 1 ? 31 - __builtin_clz(us) : 0;
+    bucket = MIN(bucket, CONFIG_THINGSET_SDK_STATS_BUCKETS - 1);
+
+    struct thingset_sdk_latency_stats *stats = &latency_stats[transport][phase];
+
+    k_spinlock_key_t key = k_spin_lock(&latency_stats_lock);
+    stats->count++;
+    stats->total_us += us;
+    stats->max_us = MAX(stats->max_us, us);
+    stats->hist[bucket]++;
+    k_spin_unlock(&latency_stats_lock, key);
+
+    return now;
+}
+
+int thingset_sdk_get_latency_stats(enum thingset_sdk_stats_transport transport,
+                                   enum thingset_sdk_stats_phase phase,
+                                   struct thingset_sdk_latency_stats *stats)
+{
+    if (transport >= THINGSET_SDK_STATS_TRANSPORT_COUNT || phase >= THINGSET_SDK_STATS_PHASE_COUNT)
+    {
+        return -EINVAL;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&latency_stats_lock);
+    *stats = latency_stats[transport][phase];
+    k_spin_unlock(&latency_stats_lock, key);
+
+    return 0;
+}
+
+void thingset_sdk_reset_latency_stats(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&latency_stats_lock);
+    memset(latency_stats, 0, sizeof(latency_stats));
+    k_spin_unlock(&latency_stats_lock, key);
+}
+
+const char *thingset_sdk_stats_transport_name(enum thingset_sdk_stats_transport transport)
+{
+    return transport < THINGSET_SDK_STATS_TRANSPORT_COUNT ? stats_transport_names[transport] : "";
+}
+
+const char *thingset_sdk_stats_phase_name(enum thingset_sdk_stats_phase phase)
+{
+    return phase < THINGSET_SDK_STATS_PHASE_COUNT ? stats_phase_names[phase] : "";
+}
+
+static void stats_group_callback(enum thingset_callback_reason reason)
+{
+    if (reason != THINGSET_CALLBACK_PRE_READ) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&latency_stats_lock);
+    for (int i = 0; i < THINGSET_SDK_STATS_TRANSPORT_COUNT; i++) {
+        stats_summary[i].reqs = latency_stats[i][THINGSET_SDK_STATS_PROCESS].count;
+        stats_summary[i].proc_max = latency_stats[i][THINGSET_SDK_STATS_PROCESS].max_us;
+        stats_summary[i].total_max = latency_stats[i][THINGSET_SDK_STATS_TOTAL].max_us;
+    }
+    k_spin_unlock(&latency_stats_lock, key);
+}
+
+static int32_t stats_reset(void)
+{
+    thingset_sdk_reset_latency_stats();
+
+    return 0;
+}
+#endif /* CONFIG_THINGSET_SDK_STATS */
+
+#ifdef CONFIG_THINGSET_REPORT_CACHE
+static struct report_cache_entry *report_cache_get(uint16_t subset,
+                                                   enum thingset_data_format format)
+{
+    for (int i = 0; i < ARRAY_SIZE(report_cache); i++) {
+        struct report_cache_entry *entry = &report_cache[i];
+
+        if (entry->subset == subset && entry->format == format) {
+            return entry;
+        }
+        else if (entry->subset == 0) {
+            entry->format = format;
+            entry->len = 0;
+            entry->subset = subset;
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+#endif /* CONFIG_THINGSET_REPORT_CACHE */
+
+#ifdef CONFIG_THINGSET_REPORT_CACHE
+/* @returns true if the report should not be sent in this period */
+static bool report_cache_suppress(struct report_cache_entry *entry, bool unchanged)
+{
+#ifdef CONFIG_THINGSET_REPORT_CACHE_SUPPRESS_UNCHANGED
+    if (unchanged && entry->suppressed < CONFIG_THINGSET_REPORT_CACHE_MAX_SUPPRESSED) {
+        entry->suppressed++;
+        return true;
+    }
+    entry->suppressed = 0;
+#endif
+    return false;
+}
+#endif /* CONFIG_THINGSET_REPORT_CACHE */
+
+#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
+/*
+ * Provides the live report in the given format, either from the cache or encoded into buf,
+ * which is allocated on first use.
+ *
+ * @returns length of the report, 0 if it should not be sent or negative error code
+ */
+static int live_report_get(enum thingset_data_format format, struct thingset_sdk_buf **buf,
+                           const uint8_t **data)
+{
+#ifdef CONFIG_THINGSET_REPORT_CACHE
+    struct report_cache_entry *entry = report_cache_get(TS_SUBSET_LIVE, format);
+
+    if (entry != NULL && !atomic_test_and_clear_bit(report_cache_dirty, entry - report_cache)
+        && entry->len > 0)
+    {
+        *data = entry->data;
+        return report_cache_suppress(entry, true) ? 0 : entry->len;
+    }
+#endif
+
+    if (*buf == NULL) {
+        *buf = thingset_sdk_buf_alloc(CONFIG_THINGSET_SHARED_TX_BUF_SIZE,
+                                      K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+    }
+
+    int len = -ENOMEM;
+    if (*buf != NULL) {
+        len = thingset_report_path(&ts, (*buf)->data, (*buf)->size, TS_NAME_SUBSET_LIVE, format);
+    }
+
+    if (len <= 0) {
+        LOG_WRN("Failed to encode live report: %d", len);
+#ifdef CONFIG_THINGSET_REPORT_CACHE
+        if (entry != NULL) {
+            entry->len = 0;
+        }
+#endif
+        return len;
+    }
+
+    *data = (*buf)->data;
+
+#ifdef CONFIG_THINGSET_REPORT_CACHE
+    if (entry != NULL) {
+        /* values may have been written without actually changing them */
+        bool unchanged = len == entry->len && memcmp(entry->data, (*buf)->data, len) == 0;
+
+        if (len <= sizeof(entry->data)) {
+            memcpy(entry->data, (*buf)->data, len);
+            entry->len = len;
+        }
+        else {
+            entry->len = 0;
+        }
+
+        if (report_cache_suppress(entry, unchanged)) {
+            return 0;
+        }
+    }
+#endif
+
+    return len;
+}
+
+void thingset_sdk_add_live_report_sink(struct thingset_sdk_report_sink *sink)
+{
+    k_spinlock_key_t key = k_spin_lock(&live_report_sinks_lock);
+    sys_slist_append(&live_report_sinks, &sink->node);
+    k_spin_unlock(&live_report_sinks_lock, key);
 }
 
+static void live_reporting_handler(struct k_work *work)
+{
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct thingset_sdk_report_sink *sink, *other;
+    uint32_t encoded_formats = 0;
+
+#ifdef CONFIG_THINGSET_SDK_WORKQ_STATS
+    thingset_sdk_work_stats_record(THINGSET_SDK_PRIO_COMM, next_live_report_time);
+#endif
+
+    if (live_reporting_enable) {
+        struct thingset_sdk_buf *buf = NULL;
+        const uint8_t *data;
+
+        SYS_SLIST_FOR_EACH_CONTAINER(&live_report_sinks, sink, node)
+        {
+            if (encoded_formats & BIT(sink->format)) {
+                continue;
+            }
+            encoded_formats |= BIT(sink->format);
+
+            /* encode once and pass the report to all sinks using the same format */
+            int len = live_report_get(sink->format, &buf, &data);
+            if (len <= 0) {
+                continue;
+            }
+
+            SYS_SLIST_FOR_EACH_CONTAINER(&live_report_sinks, other, node)
+            {
+                if (other->format == sink->format) {
+                    other->callback(data, len, other->user_data);
+                }
+            }
+        }
+
+        if (buf != NULL) {
+            thingset_sdk_buf_free(buf);
+        }
+    }
+
+    /* deadlines are derived from the previous one, so the reports do not drift */
+    next_live_report_time += 1000 * live_reporting_period;
+    if (next_live_report_time <= k_uptime_get()) {
+        /* ensure proper initialization of next_live_report_time and skip missed periods */
+        next_live_report_time = k_uptime_get() + 1000 * live_reporting_period;
+    }
+
+    thingset_sdk_reschedule_work(dwork, K_TIMEOUT_ABS_MS(next_live_report_time));
+}
+#endif /* CONFIG_THINGSET_SUBSET_LIVE_METRICS */
+
+#ifdef CONFIG_THINGSET_OBSERVE
+static void observe_check(struct thingset_sdk_observer *obs, int64_t now,
+                          struct thingset_sdk_buf **buf)
+{
+    bool due = !obs->sent || (obs->pmax > 0 && now - obs->last_sent >= obs->pmax);
+    bool reported = false;
+    float value;
+
+    bool numeric = obs->obj != NULL && thingset_sdk_item_value_float(obs->obj, &value);
+    if (!due && numeric) {
+        /* the comparison is false for NaN, so a change from or to NaN is always reported */
+        due = !(fabsf(value - obs->last_value) <= obs->deadband);
+    }
+
+    /* numeric items are only encoded if they have to be reported */
+    if (due || !numeric) {
+        if (*buf == NULL) {
+            *buf = thingset_sdk_buf_alloc(CONFIG_THINGSET_SHARED_TX_BUF_SIZE,
+                                          K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+        }
+
+        int len = -ENOMEM;
+        if (*buf != NULL) {
+            len = thingset_report_path(&ts, (*buf)->data, (*buf)->size, obs->path, obs->format);
+        }
+
+        if (len > 0) {
+            uint32_t crc = crc32_ieee((*buf)->data, len);
+            if (!due) {
+                due = crc != obs->last_crc;
+            }
+
+            if (due) {
+                obs->callback((*buf)->data, len, obs->user_data);
+                reported = true;
+                obs->sent = true;
+                obs->last_sent = now;
+                obs->last_crc = crc;
+                if (numeric) {
+                    obs->last_value = value;
+                }
+            }
+        }
+        else {
+            LOG_WRN("Failed to encode observed path %s: %d", obs->path, len);
+        }
+    }
+
+    if (reported) {
+        obs->next_check = now + MAX(obs->pmin, CONFIG_THINGSET_OBSERVE_POLL_INTERVAL);
+    }
+    else {
+        obs->next_check = now + CONFIG_THINGSET_OBSERVE_POLL_INTERVAL;
+    }
+
+    if (obs->sent && obs->pmax > 0) {
+        obs->next_check = MIN(obs->next_check, obs->last_sent + obs->pmax);
+    }
+}
+
+static void observe_handler(struct k_work *work)
+{
+    struct thingset_sdk_observer *obs;
+    struct thingset_sdk_buf *buf = NULL;
+    int64_t now = k_uptime_get();
+    int64_t next_run = INT64_MAX;
+
+    k_mutex_lock(&observers_lock, K_FOREVER);
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&observers, obs, node)
+    {
+        if (now >= obs->next_check) {
+            observe_check(obs, now, &buf);
+        }
+        next_run = MIN(next_run, obs->next_check);
+    }
+
+    /* rescheduled with the lock held, so a new observer does not get overwritten */
+    if (next_run != INT64_MAX) {
+        thingset_sdk_reschedule_work(&observe_work, K_TIMEOUT_ABS_MS(next_run));
+    }
+
+    k_mutex_unlock(&observers_lock);
+
+    if (buf != NULL) {
+        thingset_sdk_buf_free(buf);
+    }
+}
+
+int thingset_sdk_observe(struct thingset_sdk_observer *obs)
+{
+    int index;
+    int err = 0;
+
+    if (obs->callback == NULL || obs->path == NULL || (obs->pmax > 0 && obs->pmax < obs->pmin))
+    {
+        return -EINVAL;
+    }
+
+    const struct thingset_data_object *obj =
+        thingset_get_object_by_path(&ts, obs->path, strlen(obs->path), &index);
+    if (obj == NULL) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&observers_lock, K_FOREVER);
+    if (sys_slist_find(&observers, &obs->node, NULL)) {
+        /* the observer is in use by the observe work, so it must not be changed */
+        err = -EALREADY;
+    }
+    else {
+        obs->obj = obj;
+        obs->sent = false;
+        obs->next_check = k_uptime_get();
+        sys_slist_append(&observers, &obs->node);
+        thingset_sdk_reschedule_work(&observe_work, K_NO_WAIT);
+    }
+    k_mutex_unlock(&observers_lock);
+
+    return err;
+}
+
+int thingset_sdk_unobserve(struct thingset_sdk_observer *obs)
+{
+    k_mutex_lock(&observers_lock, K_FOREVER);
+    bool found = sys_slist_find_and_remove(&observers, &obs->node);
+    k_mutex_unlock(&observers_lock);
+
+    return found ? 0 : -ENOENT;
+}
+#endif /* CONFIG_THINGSET_OBSERVE */
+
 static int thingset_sdk_init(void)
 {
+#ifdef CONFIG_THINGSET_SHARED_TX_BUF
     k_sem_init(&sbuf.lock, 1, 1);
+#endif
+
+    for (int i = 0; i < THINGSET_SDK_PRIO_COUNT; i++) {
+        k_work_queue_init(&thingset_workq[i]);
+    }
 
-    k_work_queue_init(&thingset_workq);
-    k_work_queue_start(&thingset_workq, thread_stack_area, K_THREAD_STACK_SIZEOF(thread_stack_area),
+    k_work_queue_start(&thingset_workq[THINGSET_SDK_PRIO_CONTROL], control_stack_area,
+                       K_THREAD_STACK_SIZEOF(control_stack_area),
+                       CONFIG_THINGSET_SDK_CONTROL_THREAD_PRIORITY, NULL);
+    k_work_queue_start(&thingset_workq[THINGSET_SDK_PRIO_COMM], thread_stack_area,
+                       K_THREAD_STACK_SIZEOF(thread_stack_area),
                        CONFIG_THINGSET_SDK_THREAD_PRIORITY, NULL);
+    k_work_queue_start(&thingset_workq[THINGSET_SDK_PRIO_BACKGROUND], background_stack_area,
+                       K_THREAD_STACK_SIZEOF(background_stack_area),
+                       CONFIG_THINGSET_SDK_BACKGROUND_THREAD_PRIORITY, NULL);
 
-    k_thread_name_set(&thingset_workq.thread, "thingset_sdk");
+    k_thread_name_set(&thingset_workq[THINGSET_SDK_PRIO_CONTROL].thread, "thingset_ctrl");
+    k_thread_name_set(&thingset_workq[THINGSET_SDK_PRIO_COMM].thread, "thingset_sdk");
+    k_thread_name_set(&thingset_workq[THINGSET_SDK_PRIO_BACKGROUND].thread, "thingset_bg");
 
     thingset_init_global(&ts);
 
@@ -179,6 +836,11 @@ static int thingset_sdk_init(void)
     generate_device_eui();
 #endif
 
+#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
+    k_work_init_delayable(&live_reporting_work, live_reporting_handler);
+    thingset_sdk_reschedule_work(&live_reporting_work, K_NO_WAIT);
+#endif
+
     return 0;
 }
 
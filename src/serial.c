@@ -32,15 +32,15 @@ static char rx_buf[CONFIG_THINGSET_SERIAL_RX_BUF_SIZE];
 static volatile size_t rx_buf_pos = 0;
 static bool discard_buffer;
 
+/* timestamp when the request in rx_buf was complete, for request processing statistics */
+static uint32_t rx_time;
+
 /* binary semaphore used as mutex in ISR context */
 static struct k_sem rx_buf_lock;
 
 static thingset_sdk_rx_callback_t rx_callback;
 
 static struct k_work_delayable processing_work;
-#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
-static struct k_work_delayable reporting_work;
-#endif
 
 int thingset_serial_send(const uint8_t *buf, size_t len)
 {
@@ -69,33 +69,33 @@ int thingset_serial_send(const uint8_t *buf, size_t len)
 
 int thingset_serial_send_report(const char *path)
 {
-    struct shared_buffer *tx_buf = thingset_sdk_shared_buffer();
-    k_sem_take(&tx_buf->lock, K_FOREVER);
+    struct thingset_sdk_buf *tx_buf = thingset_sdk_buf_alloc(
+        CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+    if (tx_buf == NULL) {
+        return -ENOMEM;
+    }
 
     int len =
         thingset_report_path(&ts, tx_buf->data, tx_buf->size, path, THINGSET_TXT_NAMES_VALUES);
 
     int ret = thingset_serial_send(tx_buf->data, len);
 
-    k_sem_give(&tx_buf->lock);
+    thingset_sdk_buf_free(tx_buf);
     return ret;
 }
 
 #ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
 
-static void serial_regular_report_handler(struct k_work *work)
+static void serial_live_report_cb(const uint8_t *buf, size_t len, void *user_data)
 {
-    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
-    static int64_t pub_time;
-
-    if (live_reporting_enable) {
-        thingset_serial_send_report(TS_NAME_SUBSET_LIVE);
-    }
-
-    pub_time += 1000 * live_reporting_period;
-    thingset_sdk_reschedule_work(dwork, K_TIMEOUT_ABS_MS(pub_time));
+    thingset_serial_send(buf, len);
 }
 
+static struct thingset_sdk_report_sink live_report_sink = {
+    .callback = serial_live_report_cb,
+    .format = THINGSET_TXT_NAMES_VALUES,
+};
+
 #endif
 
 static void serial_process_msg_handler(struct k_work *work)
@@ -125,16 +125,27 @@ static void serial_process_msg_handler(struct k_work *work)
 #endif /* CONFIG_THINGSET_SERIAL_ENFORCE_CRC */
 
         if (rx_callback == NULL) {
-            struct shared_buffer *tx_buf = thingset_sdk_shared_buffer();
-            k_sem_take(&tx_buf->lock, K_FOREVER);
+            uint32_t t = thingset_sdk_stats_record(THINGSET_SDK_STATS_SERIAL,
+                                                   THINGSET_SDK_STATS_QUEUE, rx_time);
+
+            struct thingset_sdk_buf *tx_buf = thingset_sdk_buf_alloc(
+                CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+            if (tx_buf == NULL) {
+                goto out;
+            }
+            t = thingset_sdk_stats_record(THINGSET_SDK_STATS_SERIAL, THINGSET_SDK_STATS_BUF_WAIT,
+                                          t);
 
-            int len = thingset_process_message(&ts, (uint8_t *)rx_buf, rx_buf_pos, tx_buf->data,
-                                               tx_buf->size);
+            int len = thingset_sdk_process_message((uint8_t *)rx_buf, rx_buf_pos, tx_buf->data,
+                                                   tx_buf->size);
+            t = thingset_sdk_stats_record(THINGSET_SDK_STATS_SERIAL, THINGSET_SDK_STATS_PROCESS, t);
             if (len > 0) {
                 thingset_serial_send(tx_buf->data, len);
             }
 
-            k_sem_give(&tx_buf->lock);
+            thingset_sdk_buf_free(tx_buf);
+            thingset_sdk_stats_record(THINGSET_SDK_STATS_SERIAL, THINGSET_SDK_STATS_TX, t);
+            thingset_sdk_stats_record(THINGSET_SDK_STATS_SERIAL, THINGSET_SDK_STATS_TOTAL, rx_time);
         }
         else {
             /* external processing (e.g. for gateway applications) */
@@ -173,6 +184,7 @@ static void serial_rx_buf_put(uint8_t c)
         }
         else {
             // start processing request and keep the rx_buf_lock
+            rx_time = thingset_sdk_stats_timestamp();
             thingset_sdk_reschedule_work(&processing_work, K_NO_WAIT);
         }
         return;
@@ -226,17 +238,13 @@ static int thingset_serial_init()
 
     k_work_init_delayable(&processing_work, serial_process_msg_handler);
 
-#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
-    k_work_init_delayable(&reporting_work, serial_regular_report_handler);
-#endif
-
 #ifdef CONFIG_UART_INTERRUPT_DRIVEN
     uart_irq_callback_user_data_set(uart_dev, serial_rx_cb, NULL);
     uart_irq_rx_enable(uart_dev);
 #endif
 
 #ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
-    thingset_sdk_reschedule_work(&reporting_work, K_NO_WAIT);
+    thingset_sdk_add_live_report_sink(&live_report_sink);
 #endif
 
     return 0;
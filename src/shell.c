@@ -17,12 +17,9 @@
 
 static uint8_t req_buf[CONFIG_SHELL_CMD_BUFF_SIZE];
 
-#if defined(CONFIG_THINGSET_SHELL_REPORTING) && defined(CONFIG_THINGSET_SUBSET_LIVE_METRICS)
-static struct k_work_delayable reporting_work;
-#endif
-
 static int cmd_thingset(const struct shell *shell, size_t argc, char **argv)
 {
+    uint32_t rx_time = thingset_sdk_stats_timestamp();
     size_t pos = 0;
     for (size_t cnt = 1; cnt < argc; cnt++) {
         int ret = snprintf(req_buf + pos, sizeof(req_buf) - pos, "%s ", argv[cnt]);
@@ -34,52 +31,92 @@ static int cmd_thingset(const struct shell *shell, size_t argc, char **argv)
     }
     req_buf[--pos] = '\0';
 
-    struct shared_buffer *rsp_buf = thingset_sdk_shared_buffer();
-    k_sem_take(&rsp_buf->lock, K_FOREVER);
+    struct thingset_sdk_buf *rsp_buf = thingset_sdk_buf_alloc(
+        CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+    if (rsp_buf == NULL) {
+        shell_print(shell, "Error: No response buffer available.");
+        return -ENOMEM;
+    }
+    uint32_t t =
+        thingset_sdk_stats_record(THINGSET_SDK_STATS_SHELL, THINGSET_SDK_STATS_BUF_WAIT, rx_time);
 
-    int len = thingset_process_message(&ts, (uint8_t *)req_buf, strlen(req_buf), rsp_buf->data,
-                                       rsp_buf->size);
+    int len = thingset_sdk_process_message((uint8_t *)req_buf, strlen(req_buf), rsp_buf->data,
+                                           rsp_buf->size);
+    t = thingset_sdk_stats_record(THINGSET_SDK_STATS_SHELL, THINGSET_SDK_STATS_PROCESS, t);
 
     if (len > 0) {
         shell_print(shell, "%s", rsp_buf->data);
     }
 
-    k_sem_give(&rsp_buf->lock);
+    thingset_sdk_buf_free(rsp_buf);
+    thingset_sdk_stats_record(THINGSET_SDK_STATS_SHELL, THINGSET_SDK_STATS_TX, t);
+    thingset_sdk_stats_record(THINGSET_SDK_STATS_SHELL, THINGSET_SDK_STATS_TOTAL, rx_time);
 
     return 0;
 }
 
 SHELL_CMD_ARG_REGISTER(thingset, NULL, "ThingSet request", cmd_thingset, 1, 10);
 
-#if defined(CONFIG_THINGSET_SHELL_REPORTING) && defined(CONFIG_THINGSET_SUBSET_LIVE_METRICS)
+#ifdef CONFIG_THINGSET_SDK_STATS
 
-static void shell_regular_report_handler(struct k_work *work)
+static int cmd_thingset_stats(const struct shell *shell, size_t argc, char **argv)
 {
-    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
-    const struct shell *sh = shell_backend_uart_get_ptr();
-    static int64_t pub_time;
+    struct thingset_sdk_latency_stats stats;
 
-    if (live_reporting_enable) {
-        struct shared_buffer *tx_buf = thingset_sdk_shared_buffer();
-        k_sem_take(&tx_buf->lock, K_FOREVER);
-
-        int len = thingset_report_path(&ts, tx_buf->data, tx_buf->size, TS_NAME_SUBSET_LIVE,
-                                       THINGSET_TXT_NAMES_VALUES);
-        if (len > 0) {
-            shell_print(sh, "%.*s", tx_buf->size, tx_buf->data);
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") != 0) {
+            shell_print(shell, "Error: Unknown argument %s.", argv[1]);
+            return -EINVAL;
         }
+        thingset_sdk_reset_latency_stats();
+        return 0;
+    }
 
-        k_sem_give(&tx_buf->lock);
+    for (int tr = 0; tr < THINGSET_SDK_STATS_TRANSPORT_COUNT; tr++) {
+        for (int ph = 0; ph < THINGSET_SDK_STATS_PHASE_COUNT; ph++) {
+            thingset_sdk_get_latency_stats(tr, ph, &stats);
+            if (stats.count == 0) {
+                continue;
+            }
+
+            shell_print(shell, "%s %s: count %u, avg %u us, max %u us",
+                        thingset_sdk_stats_transport_name(tr), thingset_sdk_stats_phase_name(ph),
+                        stats.count, (uint32_t)(stats.total_us / stats.count), stats.max_us);
+
+            for (int i = 0; i < CONFIG_THINGSET_SDK_STATS_BUCKETS; i++) {
+                if (stats.hist[i] > 0) {
+                    shell_print(shell, "  %s%u us: %u", i == 0 ? "< " : ">= ",
+                                i == 0 ? 2 : 1U << i, stats.hist[i]);
+                }
+            }
+        }
     }
 
-    pub_time += 1000 * live_reporting_period;
-    thingset_sdk_reschedule_work(dwork, K_TIMEOUT_ABS_MS(pub_time));
+    return 0;
 }
 
+SHELL_CMD_ARG_REGISTER(thingset_stats, NULL, "ThingSet request processing statistics [reset]",
+                       cmd_thingset_stats, 1, 1);
+
+#endif /* CONFIG_THINGSET_SDK_STATS */
+
+#if defined(CONFIG_THINGSET_SHELL_REPORTING) && defined(CONFIG_THINGSET_SUBSET_LIVE_METRICS)
+
+static void shell_live_report_cb(const uint8_t *buf, size_t len, void *user_data)
+{
+    const struct shell *sh = shell_backend_uart_get_ptr();
+
+    shell_print(sh, "%.*s", (int)len, buf);
+}
+
+static struct thingset_sdk_report_sink live_report_sink = {
+    .callback = shell_live_report_cb,
+    .format = THINGSET_TXT_NAMES_VALUES,
+};
+
 static int thingset_shell_init()
 {
-    k_work_init_delayable(&reporting_work, shell_regular_report_handler);
-    thingset_sdk_reschedule_work(&reporting_work, K_NO_WAIT);
+    thingset_sdk_add_live_report_sink(&live_report_sink);
 
     return 0;
 }
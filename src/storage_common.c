@@ -25,7 +25,7 @@ void thingset_storage_save_queued(bool force)
         storage_save_allowed = true;
     }
 
-    thingset_sdk_reschedule_work(&storage_work, K_NO_WAIT);
+    thingset_sdk_reschedule_work_prio(&storage_work, K_NO_WAIT, THINGSET_SDK_PRIO_BACKGROUND);
 }
 
 static void thingset_storage_update_handler()
@@ -45,7 +45,8 @@ static void thingset_storage_save_handler(struct k_work *work)
     }
 
 #ifdef CONFIG_THINGSET_STORAGE_AUTOSAVE
-    thingset_sdk_reschedule_work(dwork, K_HOURS(CONFIG_THINGSET_STORAGE_AUTOSAVE_INTERVAL));
+    thingset_sdk_reschedule_work_prio(dwork, K_HOURS(CONFIG_THINGSET_STORAGE_AUTOSAVE_INTERVAL),
+                                      THINGSET_SDK_PRIO_BACKGROUND);
 #endif
 }
 
@@ -73,7 +74,9 @@ static int thingset_storage_init(void)
     }
 
 #ifdef CONFIG_THINGSET_STORAGE_AUTOSAVE
-    thingset_sdk_reschedule_work(&storage_work, K_HOURS(CONFIG_THINGSET_STORAGE_AUTOSAVE_INTERVAL));
+    thingset_sdk_reschedule_work_prio(&storage_work,
+                                      K_HOURS(CONFIG_THINGSET_STORAGE_AUTOSAVE_INTERVAL),
+                                      THINGSET_SDK_PRIO_BACKGROUND);
 #endif
 
     return 0;
@@ -58,9 +58,8 @@ static int thingset_eeprom_load(off_t offset)
         return -EINVAL;
     }
 
-    struct shared_buffer *sbuf = thingset_sdk_shared_buffer();
-
-    k_sem_take(&sbuf->lock, K_FOREVER);
+    struct thingset_sdk_buf *sbuf =
+        thingset_sdk_buf_alloc(CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_FOREVER);
 
     if (header.data_len > sbuf->size) {
 #ifdef CONFIG_THINGSET_STORAGE_EEPROM_PROGRESSIVE_IMPORT_EXPORT
@@ -152,7 +151,7 @@ static int thingset_eeprom_load(off_t offset)
     }
 
 out:
-    k_sem_give(&sbuf->lock);
+    thingset_sdk_buf_free(sbuf);
 
     return err;
 }
@@ -161,13 +160,13 @@ static int thingset_eeprom_save(off_t offset, size_t useable_size)
 {
     int err = 0;
 
-    struct shared_buffer *sbuf = thingset_sdk_shared_buffer();
-    k_sem_take(&sbuf->lock, K_FOREVER);
+    struct thingset_sdk_buf *sbuf =
+        thingset_sdk_buf_alloc(CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_FOREVER);
 
     struct thingset_eeprom_header header = { .version = CONFIG_THINGSET_STORAGE_DATA_VERSION };
 
 #ifdef CONFIG_THINGSET_STORAGE_EEPROM_PROGRESSIVE_IMPORT_EXPORT
-    LOG_DBG("Initialising with buffer of size %d", sbuf->size);
+    LOG_DBG("Initialising with buffer of size %zu", sbuf->size);
 
     int rtn;
     int i = 0;
@@ -274,7 +273,7 @@ static int thingset_eeprom_save(off_t offset, size_t useable_size)
     }
 #endif /* CONFIG_THINGSET_STORAGE_EEPROM_PROGRESSIVE_IMPORT_EXPORT */
 out:
-    k_sem_give(&sbuf->lock);
+    thingset_sdk_buf_free(sbuf);
 
     return err;
 }
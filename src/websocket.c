@@ -38,10 +38,6 @@ static char server_path[23]; /* "/node/" + pNodeID (16 bytes) + '\0' */
 
 static int websock = -1;
 
-#ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
-static struct k_work_delayable reporting_work;
-#endif
-
 THINGSET_ADD_ITEM_STRING(TS_ID_NET, TS_ID_NET_WEBSOCKET_HOST, "sWebsocketHost", server_host,
                          sizeof(server_host), THINGSET_ANY_RW, TS_SUBSET_NVM);
 
@@ -191,33 +187,35 @@ int thingset_websocket_send(const uint8_t *buf, size_t len)
 
 int thingset_websocket_send_report(const char *path)
 {
-    struct shared_buffer *tx_buf = thingset_sdk_shared_buffer();
-    k_sem_take(&tx_buf->lock, K_FOREVER);
+    struct thingset_sdk_buf *tx_buf = thingset_sdk_buf_alloc(
+        CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+    if (tx_buf == NULL) {
+        return -ENOMEM;
+    }
 
     int len =
         thingset_report_path(&ts, tx_buf->data, tx_buf->size, path, THINGSET_TXT_NAMES_VALUES);
 
     int ret = thingset_websocket_send(tx_buf->data, len);
 
-    k_sem_give(&tx_buf->lock);
+    thingset_sdk_buf_free(tx_buf);
     return ret;
 }
 
 #ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
 
-static void websocket_regular_report_handler(struct k_work *work)
+static void websocket_live_report_cb(const uint8_t *buf, size_t len, void *user_data)
 {
-    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
-    static int64_t pub_time;
-
-    if (live_reporting_enable && websock >= 0) {
-        thingset_websocket_send_report(TS_NAME_SUBSET_LIVE);
+    if (websock >= 0) {
+        thingset_websocket_send(buf, len);
     }
-
-    pub_time += 1000 * live_reporting_period;
-    thingset_sdk_reschedule_work(dwork, K_TIMEOUT_ABS_MS(pub_time));
 }
 
+static struct thingset_sdk_report_sink live_report_sink = {
+    .callback = websocket_live_report_cb,
+    .format = THINGSET_TXT_NAMES_VALUES,
+};
+
 #endif
 
 /* disabled because struct sigaction is not found when compiled for Zephyr v3.6 */
@@ -254,8 +252,7 @@ static void websocket_thread(void)
 #endif
 
 #ifdef CONFIG_THINGSET_SUBSET_LIVE_METRICS
-    k_work_init_delayable(&reporting_work, websocket_regular_report_handler);
-    thingset_sdk_reschedule_work(&reporting_work, K_NO_WAIT);
+    thingset_sdk_add_live_report_sink(&live_report_sink);
 #endif
 
     if (IS_ENABLED(CONFIG_NET_SOCKETS_SOCKOPT_TLS)) {
@@ -310,17 +307,30 @@ static void websocket_thread(void)
                 break;
             }
 
-            struct shared_buffer *tx_buf = thingset_sdk_shared_buffer();
-            k_sem_take(&tx_buf->lock, K_FOREVER);
+            /* requests are processed right after reception, so there is no queueing delay */
+            uint32_t rx_time = thingset_sdk_stats_timestamp();
+
+            struct thingset_sdk_buf *tx_buf = thingset_sdk_buf_alloc(
+                CONFIG_THINGSET_SHARED_TX_BUF_SIZE, K_MSEC(CONFIG_THINGSET_SDK_BUF_TIMEOUT));
+            if (tx_buf == NULL) {
+                continue;
+            }
+            uint32_t t = thingset_sdk_stats_record(THINGSET_SDK_STATS_WEBSOCKET,
+                                                   THINGSET_SDK_STATS_BUF_WAIT, rx_time);
 
-            int len = thingset_process_message(&ts, (uint8_t *)rx_buf, bytes_received, tx_buf->data,
-                                               tx_buf->size);
+            int len = thingset_sdk_process_message((uint8_t *)rx_buf, bytes_received,
+                                                   tx_buf->data, tx_buf->size);
+            t = thingset_sdk_stats_record(THINGSET_SDK_STATS_WEBSOCKET, THINGSET_SDK_STATS_PROCESS,
+                                          t);
             if (len > 0) {
                 LOG_DBG("Sending response with %d bytes", len);
                 thingset_websocket_send(tx_buf->data, len);
             }
 
-            k_sem_give(&tx_buf->lock);
+            thingset_sdk_buf_free(tx_buf);
+            thingset_sdk_stats_record(THINGSET_SDK_STATS_WEBSOCKET, THINGSET_SDK_STATS_TX, t);
+            thingset_sdk_stats_record(THINGSET_SDK_STATS_WEBSOCKET, THINGSET_SDK_STATS_TOTAL,
+                                      rx_time);
         }
     }
 }
@@ -10,32 +10,40 @@
 #include <assert.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/sys/byteorder.h>
+#ifdef CONFIG_ISOTP_FAST_STMIN_COUNTER
+#include <zephyr/drivers/counter.h>
+#endif
 
 LOG_MODULE_REGISTER(isotp_fast, CONFIG_ISOTP_LOG_LEVEL);
 
 static void receive_work_handler(struct k_work *work);
-static void receive_timeout_handler(struct k_timer *timer);
+static void receive_timeout_handler(struct isotp_fast_timeout *timeout);
 static void receive_state_machine(struct isotp_fast_recv_ctx *rctx);
 static void send_work_handler(struct k_work *work);
 static void send_timeout_handler(struct k_timer *timer);
+static void send_bs_timeout_handler(struct isotp_fast_timeout *timeout);
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+static void send_cf_pipeline(struct isotp_fast_send_ctx *sctx);
+#endif
 
-/**
- * Determines whether two @ref isotp_fast_addr structures are equal.
- */
-static inline bool isotp_fast_addr_equal(struct isotp_fast_addr *left,
-                                         struct isotp_fast_addr *right)
-{
-#ifdef CONFIG_ISOTP_FAST_EXTENDED_ADDRESSING
-    return left->ext_id == right->ext_id && left->ext_addr == right->ext_addr;
-#else
-    return left->ext_id == right->ext_id;
+#ifdef CONFIG_ISOTP_FAST_WORKQUEUE
+static K_THREAD_STACK_DEFINE(isotp_fast_workq_stack, CONFIG_ISOTP_FAST_WORKQUEUE_STACK_SIZE);
+static struct k_work_q isotp_fast_workq;
 #endif
-}
 
 /* Memory slab to hold send contexts */
 K_MEM_SLAB_DEFINE(isotp_send_ctx_slab, sizeof(struct isotp_fast_send_ctx),
                   CONFIG_ISOTP_FAST_TX_BUF_COUNT, 4);
 
+#if CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH > 0
+/* Memory slab to hold messages queued behind an ongoing transfer */
+K_MEM_SLAB_DEFINE(isotp_send_req_slab, sizeof(struct isotp_fast_send_req),
+                  CONFIG_ISOTP_FAST_TX_QUEUE_POOL_SIZE, 4);
+#endif
+
+/* protects the send context buckets and the queues of the send contexts */
+static struct k_spinlock send_ctx_lock;
+
 /* Memory slab to hold receive contexts */
 K_MEM_SLAB_DEFINE(isotp_recv_ctx_slab, sizeof(struct isotp_fast_recv_ctx),
                   CONFIG_ISOTP_FAST_RX_BUF_COUNT, 4);
@@ -46,6 +54,29 @@ K_MEM_SLAB_DEFINE(isotp_recv_await_ctx_slab, sizeof(struct isotp_fast_recv_await
                   CONFIG_ISOTP_FAST_RX_BUF_COUNT, 4);
 #endif
 
+#ifdef CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER
+/**
+ * Pool of variable-sized buffers for incoming messages. Each receive context
+ * leases a single buffer sized to the message length announced in the SF or
+ * FF, so payloads of consecutive frames are copied straight into it without
+ * allocating further fragments.
+ */
+NET_BUF_POOL_VAR_DEFINE(isotp_rx_pool, CONFIG_ISOTP_FAST_RX_BUF_COUNT,
+                        CONFIG_ISOTP_FAST_RX_LINEAR_POOL_SIZE, sizeof(int), NULL);
+#else
+#define ISOTP_FAST_RX_POOL_COUNT                                                                   \
+    (CONFIG_ISOTP_FAST_RX_BUF_COUNT * CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT)
+
+#ifdef CONFIG_ISOTP_FAST_RX_BACKPRESSURE
+/* buffers neither in use nor reserved for the current block of a transfer */
+static atomic_t rx_buf_credits = ATOMIC_INIT(ISOTP_FAST_RX_POOL_COUNT);
+
+static void rx_buf_destroy(struct net_buf *buf);
+#define ISOTP_FAST_RX_BUF_DESTROY rx_buf_destroy
+#else
+#define ISOTP_FAST_RX_BUF_DESTROY NULL
+#endif
+
 /**
  * Pool of buffers for incoming messages. The current implementation
  * sizes these to match the size of a CAN frame less the 1 header byte
@@ -54,23 +85,115 @@ K_MEM_SLAB_DEFINE(isotp_recv_await_ctx_slab, sizeof(struct isotp_fast_recv_await
  * number of buffers) and CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT (i.e. how big a
  * message does one anticipate receiving).
  */
-NET_BUF_POOL_DEFINE(isotp_rx_pool,
-                    CONFIG_ISOTP_FAST_RX_BUF_COUNT *CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT,
-                    CAN_MAX_DLEN - 1, sizeof(int), NULL);
+NET_BUF_POOL_DEFINE(isotp_rx_pool, ISOTP_FAST_RX_POOL_COUNT, CAN_MAX_DLEN - 1, sizeof(int),
+                    ISOTP_FAST_RX_BUF_DESTROY);
 
-static int get_send_ctx(struct isotp_fast_ctx *ctx, struct isotp_fast_addr tx_addr,
-                        struct isotp_fast_send_ctx **sctx)
+#ifdef CONFIG_ISOTP_FAST_RX_BACKPRESSURE
+static void rx_buf_destroy(struct net_buf *buf)
 {
-    struct isotp_fast_send_ctx *context;
+    net_buf_destroy(buf);
+    atomic_inc(&rx_buf_credits);
+}
 
-    SYS_SLIST_FOR_EACH_CONTAINER(&ctx->isotp_send_ctx_list, context, node)
-    {
-        if (isotp_fast_addr_equal(&context->tx_addr, &tx_addr)) {
-            LOG_DBG("Found existing send context for recipient %x", tx_addr.ext_id);
-            *sctx = context;
+/**
+ * Takes up to max buffer credits.
+ *
+ * @returns number of credits taken
+ */
+static atomic_val_t rx_buf_credits_take(atomic_val_t max)
+{
+    atomic_val_t avail;
+    atomic_val_t num;
+
+    do {
+        avail = atomic_get(&rx_buf_credits);
+        num = MIN(avail, max);
+        if (num <= 0) {
             return 0;
         }
+    } while (!atomic_cas(&rx_buf_credits, avail, avail - num));
+
+    return num;
+}
+#endif /* CONFIG_ISOTP_FAST_RX_BACKPRESSURE */
+#endif /* CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER */
+
+#ifdef ISOTP_FAST_RECEIVE_QUEUE
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_ISOTP_FAST_RX_RING_SIZE),
+             "CONFIG_ISOTP_FAST_RX_RING_SIZE must be a power of two");
+#endif
+
+#ifdef CONFIG_ISOTP_FAST_STMIN_COUNTER
+static const struct device *const stmin_counter =
+    DEVICE_DT_GET(DT_CHOSEN(thingset_isotp_fast_counter));
+
+/* bitmask of the alarm channels currently assigned to a send context */
+static atomic_t stmin_counter_chans;
+#endif
+
+#ifdef CONFIG_ISOTP_FAST_STMIN_STATS
+static struct k_spinlock stmin_stats_lock;
+static struct isotp_fast_stmin_stats stmin_stats;
+static uint64_t stmin_stats_abs_dev_sum;
+#endif
+
+static inline struct k_work_q *get_work_q(struct isotp_fast_ctx *ctx)
+{
+    if (ctx->work_q != NULL) {
+        return ctx->work_q;
+    }
+#ifdef CONFIG_ISOTP_FAST_WORKQUEUE
+    return &isotp_fast_workq;
+#else
+    return &k_sys_work_q;
+#endif
+}
+
+static inline void receive_submit(struct isotp_fast_recv_ctx *rctx)
+{
+    k_work_submit_to_queue(get_work_q(rctx->ctx), &rctx->work);
+}
+
+static inline void send_submit(struct isotp_fast_send_ctx *sctx)
+{
+    k_work_submit_to_queue(get_work_q(sctx->ctx), &sctx->work);
+}
+
+/**
+ * Prepares a send context for the transfer of the next message.
+ */
+static void send_ctx_load(struct isotp_fast_send_ctx *sctx, const uint8_t *data,
+                          struct net_buf *buf, uint32_t len, void *cb_arg)
+{
+    if (sctx->buf != NULL) {
+        net_buf_unref(sctx->buf);
     }
+    sctx->buf = buf;
+    sctx->frag = buf;
+    sctx->data = buf != NULL ? buf->data : data;
+    sctx->rem_len = len;
+    sctx->cb_arg = cb_arg;
+    sctx->bs = sctx->ctx->opts->bs;
+    sctx->stmin = sctx->ctx->opts->stmin;
+    sctx->state = ISOTP_TX_SEND_FF;
+    sctx->error = 0;
+    sctx->wft = 0;
+    sctx->backlog = 0;
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+    atomic_set(&sctx->inflight, 0);
+    atomic_set(&sctx->fill_req, 0);
+    sctx->nas_deadline = 0;
+#endif
+}
+
+/**
+ * Creates a send context, which has to be added to the bucket of the recipient by the caller
+ * after loading the first message.
+ */
+static int alloc_send_ctx(struct isotp_fast_ctx *ctx, struct isotp_fast_addr tx_addr,
+                          struct isotp_fast_send_ctx **sctx)
+{
+    struct isotp_fast_send_ctx *context;
 
     int err = k_mem_slab_alloc(&isotp_send_ctx_slab, (void **)&context, K_NO_WAIT);
     if (err != 0) {
@@ -79,14 +202,18 @@ static int get_send_ctx(struct isotp_fast_ctx *ctx, struct isotp_fast_addr tx_ad
     *sctx = context;
     context->ctx = ctx;
     context->tx_addr = tx_addr;
-    context->bs = ctx->opts->bs;
-    context->stmin = ctx->opts->stmin;
-    context->state = ISOTP_TX_SEND_FF;
-    context->error = 0;
+    context->buf = NULL;
+#ifdef CONFIG_ISOTP_FAST_STMIN_COUNTER
+    context->counter_chan = -1;
+#endif
+#if CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH > 0
+    sys_slist_init(&context->queue);
+    context->queued = 0;
+#endif
     k_sem_init(&context->sem, 0, 1);
     k_work_init(&context->work, send_work_handler);
     k_timer_init(&context->timer, send_timeout_handler, NULL);
-    sys_slist_append(&ctx->isotp_send_ctx_list, &context->node);
+    isotp_fast_timeout_init(&context->timeout, send_bs_timeout_handler);
     LOG_DBG("Created new send context for recipient %x", tx_addr.ext_id);
 
     return 0;
@@ -95,20 +222,39 @@ static int get_send_ctx(struct isotp_fast_ctx *ctx, struct isotp_fast_addr tx_ad
 static inline void free_send_ctx(struct isotp_fast_send_ctx *sctx)
 {
     LOG_DBG("Freeing send context for recipient %x", sctx->tx_addr.ext_id);
+    k_spinlock_key_t key = k_spin_lock(&send_ctx_lock);
+    sys_slist_find_and_remove(isotp_fast_send_bucket(sctx->ctx, &sctx->tx_addr), &sctx->node);
+    k_spin_unlock(&send_ctx_lock, key);
     k_timer_stop(&sctx->timer);
-    sys_slist_find_and_remove(&sctx->ctx->isotp_send_ctx_list, &sctx->node);
+    isotp_fast_timeout_stop(&sctx->timeout);
+#ifdef CONFIG_ISOTP_FAST_STMIN_COUNTER
+    if (sctx->counter_chan >= 0) {
+        counter_cancel_channel_alarm(stmin_counter, sctx->counter_chan);
+        atomic_clear_bit(&stmin_counter_chans, sctx->counter_chan);
+    }
+#endif
+    if (sctx->buf != NULL) {
+        net_buf_unref(sctx->buf);
+    }
     k_mem_slab_free(&isotp_send_ctx_slab, sctx);
 }
 
 static inline void free_recv_ctx(struct isotp_fast_recv_ctx *rctx)
 {
     LOG_DBG("Freeing receive context %x", rctx->rx_addr.ext_id);
-    k_timer_stop(&rctx->timer);
-    sys_slist_find_and_remove(&rctx->ctx->isotp_recv_ctx_list, &rctx->node);
-    net_buf_unref(rctx->buffer);
+    isotp_fast_timeout_stop(&rctx->timeout);
+    sys_slist_find_and_remove(isotp_fast_recv_bucket(rctx->ctx, &rctx->rx_addr), &rctx->node);
+    if (rctx->buffer != NULL) {
+        net_buf_unref(rctx->buffer);
+    }
 #ifdef ISOTP_FAST_RECEIVE_QUEUE
-    k_msgq_purge(&rctx->recv_queue);
-    k_msgq_cleanup(&rctx->recv_queue);
+    struct net_buf *frag;
+    while ((frag = isotp_fast_rx_ring_get(&rctx->ring)) != NULL) {
+        net_buf_unref(frag);
+    }
+#endif
+#ifdef CONFIG_ISOTP_FAST_RX_BACKPRESSURE
+    atomic_add(&rx_buf_credits, rctx->reserved);
 #endif
     k_mem_slab_free(&isotp_recv_ctx_slab, rctx);
 }
@@ -123,27 +269,49 @@ static void free_recv_ctx_if_unowned(struct isotp_fast_recv_ctx *rctx)
     free_recv_ctx(rctx);
 }
 
+#ifndef CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER
+static struct net_buf *receive_alloc_buf(struct isotp_fast_recv_ctx *rctx)
+{
+#ifdef CONFIG_ISOTP_FAST_RX_BACKPRESSURE
+    if (rctx->reserved > 0) {
+        rctx->reserved--;
+    }
+    else if (rx_buf_credits_take(1) == 0) {
+        /* remaining buffers are reserved for other transfers */
+        return NULL;
+    }
+#endif
+
+    struct net_buf *buf = net_buf_alloc(&isotp_rx_pool, K_NO_WAIT);
+#ifdef CONFIG_ISOTP_FAST_RX_BACKPRESSURE
+    if (buf == NULL) {
+        atomic_inc(&rx_buf_credits);
+    }
+#endif
+    return buf;
+}
+#endif
+
 static int get_recv_ctx(struct isotp_fast_ctx *ctx, struct isotp_fast_addr rx_addr,
                         struct isotp_fast_recv_ctx **rctx)
 {
-    struct isotp_fast_recv_ctx *context;
-
-    SYS_SLIST_FOR_EACH_CONTAINER(&ctx->isotp_recv_ctx_list, context, node)
-    {
-        if (isotp_fast_addr_equal(&context->rx_addr, &rx_addr)) {
-            LOG_DBG("Found existing receive context %x", rx_addr.ext_id);
-            *rctx = context;
-            context->frag = net_buf_alloc(&isotp_rx_pool, K_NO_WAIT);
-            if (context->frag == NULL) {
-                LOG_ERR("No free buffers");
-                free_recv_ctx(*rctx);
-                return ISOTP_NO_NET_BUF_LEFT;
-            }
+    struct isotp_fast_recv_ctx *context = isotp_fast_find_recv_ctx(ctx, &rx_addr);
+
+    if (context != NULL) {
+        LOG_DBG("Found existing receive context %x", rx_addr.ext_id);
+        *rctx = context;
+#ifndef CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER
+        context->frag = receive_alloc_buf(context);
+        if (context->frag == NULL) {
+            LOG_ERR("No free buffers");
+            free_recv_ctx(*rctx);
+            return ISOTP_NO_NET_BUF_LEFT;
+        }
 #ifndef ISOTP_FAST_RECEIVE_QUEUE
-            net_buf_frag_add(context->buffer, context->frag);
+        net_buf_frag_add(context->buffer, context->frag);
 #endif
-            return 0;
-        }
+#endif /* CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER */
+        return 0;
     }
 
     int err = k_mem_slab_alloc(&isotp_recv_ctx_slab, (void **)&context, K_NO_WAIT);
@@ -151,12 +319,23 @@ static int get_recv_ctx(struct isotp_fast_ctx *ctx, struct isotp_fast_addr rx_ad
         LOG_ERR("No space for receive context - error %d.", err);
         return ISOTP_NO_CTX_LEFT;
     }
-    context->buffer = net_buf_alloc(&isotp_rx_pool, K_NO_WAIT);
+#ifdef CONFIG_ISOTP_FAST_RX_BACKPRESSURE
+    context->reserved = 0;
+#endif
+#ifdef ISOTP_FAST_RX_ADAPTIVE_BS
+    context->bs_adv = ctx->opts->bs;
+#endif
+#ifdef CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER
+    /* buffer is leased in process_ff_sf once the message length is known */
+    context->buffer = NULL;
+#else
+    context->buffer = receive_alloc_buf(context);
     if (!context->buffer) {
         k_mem_slab_free(&isotp_recv_ctx_slab, context);
         LOG_ERR("No net bufs.");
         return ISOTP_NO_NET_BUF_LEFT;
     }
+#endif
     context->frag = context->buffer;
     *rctx = context;
     context->ctx = ctx;
@@ -164,13 +343,15 @@ static int get_recv_ctx(struct isotp_fast_ctx *ctx, struct isotp_fast_addr rx_ad
     context->rx_addr = rx_addr;
     context->error = 0;
 #ifdef ISOTP_FAST_RECEIVE_QUEUE
-    k_msgq_init(&context->recv_queue, context->recv_queue_pool, sizeof(struct net_buf *),
-                CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT);
-    LOG_DBG("Queue of length %d created", k_msgq_num_free_get(&context->recv_queue));
+    isotp_fast_rx_ring_init(&context->ring);
+#endif
+#ifdef CONFIG_ISOTP_FAST_BLOCKING_RECEIVE
+    k_sem_init(&context->ring_sem, 0, 1);
+    atomic_clear(&context->ring_waiting);
 #endif
     k_work_init(&context->work, receive_work_handler);
-    k_timer_init(&context->timer, receive_timeout_handler, NULL);
-    sys_slist_append(&ctx->isotp_recv_ctx_list, &context->node);
+    isotp_fast_timeout_init(&context->timeout, receive_timeout_handler);
+    sys_slist_append(isotp_fast_recv_bucket(ctx, &rx_addr), &context->node);
     LOG_DBG("Created new receive context %x", rx_addr.ext_id);
 
     return 0;
@@ -226,18 +407,18 @@ static void send_report_error(struct isotp_fast_send_ctx *sctx, int8_t err)
     sctx->error = err;
 }
 
-static inline uint32_t receive_get_ff_length(uint8_t *data)
+static inline uint32_t receive_get_ff_length(uint8_t *data, int *index)
 {
     uint32_t len;
     uint8_t pci = data[0];
 
     len = ((pci & ISOTP_PCI_FF_DL_UPPER_MASK) << 8) | data[1];
+    *index += 2;
 
-    /* Jumbo packet (32 bit length)*/
-    /* TODO: this probably isn't supported at the moment, given that max length is 4095 */
+    /* Escape sequence: FF_DL of 0 followed by 32-bit length (ISO 15765-2:2016) */
     if (!len) {
-        len = UNALIGNED_GET((uint32_t *)data);
-        len = sys_be32_to_cpu(len);
+        len = sys_get_be32(&data[2]);
+        *index += 4;
     }
 
     return len;
@@ -266,7 +447,7 @@ static void receive_can_tx(const struct device *dev, int error, void *arg)
     if (error != 0) {
         LOG_ERR("Error sending FC frame (%d)", error);
         receive_report_error(rctx, ISOTP_N_ERROR);
-        k_work_submit(&rctx->work);
+        receive_submit(rctx);
     }
 }
 
@@ -286,7 +467,11 @@ static void receive_send_fc(struct isotp_fast_recv_ctx *rctx, uint8_t fs)
     __ASSERT_NO_MSG(!(fs & ISOTP_PCI_TYPE_MASK));
 
     *data++ = ISOTP_PCI_TYPE_FC | fs;
+#ifdef ISOTP_FAST_RX_ADAPTIVE_BS
+    *data++ = rctx->bs_adv;
+#else
     *data++ = rctx->ctx->opts->bs;
+#endif
     *data++ = rctx->ctx->opts->stmin;
     payload_len = data - frame.data;
     frame.dlc = can_bytes_to_dlc(payload_len);
@@ -315,10 +500,10 @@ static void notify_waiting_receiver(struct isotp_fast_recv_ctx *rctx)
             if (k_sem_count_get(&awaiter->sem) == 0) {
                 k_sem_give(&awaiter->sem);
             }
-            else if (rctx->error) {
-                /* if error state, we might already be waiting on the queue for the next
-                   message, so purge the queue to unblock the waiter so it will see the error */
-                k_msgq_purge(&rctx->recv_queue);
+            if (rctx->error) {
+                /* if error state, we might already be waiting on the ring for the next
+                   fragment, so wake up the waiter so it will see the error */
+                k_sem_give(&rctx->ring_sem);
             }
             return;
         }
@@ -328,14 +513,130 @@ static void notify_waiting_receiver(struct isotp_fast_recv_ctx *rctx)
 }
 #endif
 
+#ifndef CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER
+/**
+ * Checks if the buffers can hold the message announced in the FF.
+ */
+static bool receive_ff_fits(struct isotp_fast_recv_ctx *rctx)
+{
+#if defined(ISOTP_FAST_RECEIVE_QUEUE)
+    /* buffers are released while the message is received and the block size adapted */
+    return true;
+#elif defined(CONFIG_ISOTP_FAST_RX_BACKPRESSURE)
+    /* all buffers of the message are kept until it is complete, one is used by the FF */
+    return rctx->rem_len <= (ISOTP_FAST_RX_POOL_COUNT - 1) * (CAN_MAX_DLEN - 1);
+#else
+    return rctx->ctx->opts->bs != 0
+           || rctx->rem_len <= CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT * (CAN_MAX_DLEN - 1);
+#endif
+}
+#endif /* CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER */
+
+#ifdef CONFIG_ISOTP_FAST_RX_BACKPRESSURE
+/**
+ * Reserves buffers for the next block and determines the block size to advertise, which is
+ * reduced from the configured one if buffers are low.
+ *
+ * @returns true if at least one buffer could be reserved
+ */
+static bool receive_reserve_block(struct isotp_fast_recv_ctx *rctx)
+{
+    uint8_t bs = rctx->ctx->opts->bs;
+    uint32_t frames_left = DIV_ROUND_UP(rctx->rem_len, CAN_MAX_DLEN - 1);
+    uint32_t needed = bs ? MIN(bs, frames_left) : frames_left;
+    uint32_t limit = needed;
+
+#ifdef ISOTP_FAST_RECEIVE_QUEUE
+    /* frames stay in the ring until they are dispatched */
+    limit = MIN(limit, isotp_fast_rx_ring_free(&rctx->ring));
+#endif
+
+    /* return reservations left over from the previous block */
+    atomic_add(&rx_buf_credits, rctx->reserved);
+    rctx->reserved = rx_buf_credits_take(limit);
+    if (rctx->reserved == 0) {
+        return false;
+    }
+
+    if (rctx->reserved < needed) {
+        if (rctx->reserved > UINT8_MAX) {
+            atomic_add(&rx_buf_credits, rctx->reserved - UINT8_MAX);
+            rctx->reserved = UINT8_MAX;
+        }
+        bs = rctx->reserved;
+        LOG_DBG("Low on buffers, reducing BS to %d", bs);
+#ifdef CONFIG_ISOTP_FAST_RX_STATS
+        rctx->ctx->rx_stats.bs_reductions++;
+#endif
+    }
+
+    rctx->bs_adv = bs;
+    rctx->bs = bs;
+    rctx->wft = ISOTP_WFT_FIRST;
+    return true;
+}
+
+/**
+ * Keeps the sender waiting until buffers become available, sending FC.WAIT frames before its
+ * N_Bs timer expires.
+ */
+static void receive_wait_for_buffers(struct isotp_fast_recv_ctx *rctx)
+{
+    if (rctx->wft == ISOTP_WFT_FIRST || rctx->wait_ms >= ISOTP_ALLOC_TIMEOUT_MS) {
+        if (++rctx->wft >= CONFIG_ISOTP_WFTMAX) {
+            LOG_ERR("Sent %d wait frames. Giving up to alloc now", rctx->wft);
+            receive_report_error(rctx, ISOTP_N_BUFFER_OVERFLW);
+            receive_state_machine(rctx);
+            return;
+        }
+
+        LOG_DBG("Send wait frame number %d", rctx->wft);
+        receive_send_fc(rctx, ISOTP_PCI_FS_WAIT);
+#ifdef CONFIG_ISOTP_FAST_RX_STATS
+        rctx->ctx->rx_stats.wait_frames++;
+#endif
+        rctx->wait_ms = 0;
+    }
+
+    rctx->wait_ms += CONFIG_ISOTP_FAST_RX_BACKPRESSURE_RETRY_MS;
+    isotp_fast_timeout_start(&rctx->timeout, CONFIG_ISOTP_FAST_RX_BACKPRESSURE_RETRY_MS);
+}
+#elif defined(ISOTP_FAST_RECEIVE_QUEUE)
+/**
+ * Limits the block size to the free slots of the ring, so the sender never sends more frames
+ * than the ring can hold until they were dispatched.
+ *
+ * @returns false if the ring is full
+ */
+static bool receive_limit_block(struct isotp_fast_recv_ctx *rctx)
+{
+    uint8_t bs = rctx->ctx->opts->bs;
+    uint32_t frames_left = DIV_ROUND_UP(rctx->rem_len, CAN_MAX_DLEN - 1);
+    uint32_t slots = isotp_fast_rx_ring_free(&rctx->ring);
+
+    if (slots == 0) {
+        return false;
+    }
+
+    if ((bs == 0 || bs > slots) && frames_left > slots) {
+        bs = slots;
+        LOG_DBG("Receive ring filling up, reducing BS to %d", bs);
+    }
+
+    rctx->bs_adv = bs;
+    rctx->bs = bs;
+    rctx->wft = ISOTP_WFT_FIRST;
+    return true;
+}
+#endif /* CONFIG_ISOTP_FAST_RX_BACKPRESSURE */
+
 static void receive_state_machine(struct isotp_fast_recv_ctx *rctx)
 {
 #ifdef CONFIG_ISOTP_FAST_PER_FRAME_DISPATCH
     struct net_buf *frag;
-    while (k_msgq_get(&rctx->recv_queue, &frag, K_NO_WAIT) == 0) {
+    while ((frag = isotp_fast_rx_ring_get(&rctx->ring)) != NULL) {
         int *p_rem_len = net_buf_user_data(frag);
-        LOG_DBG("Remaining length %d (%d), enqueued %d", *p_rem_len, rctx->rem_len,
-                k_msgq_num_used_get(&rctx->recv_queue));
+        LOG_DBG("Remaining length %d (%d)", *p_rem_len, rctx->rem_len);
         rctx->ctx->recv_callback(frag, *p_rem_len, rctx->rx_addr, rctx->ctx->recv_cb_arg);
         net_buf_unref(frag);
     }
@@ -354,15 +655,14 @@ static void receive_state_machine(struct isotp_fast_recv_ctx *rctx)
 
         case ISOTP_RX_STATE_PROCESS_FF:
             LOG_DBG("SM process FF. Length: %d", rctx->rem_len + rctx->frag->len);
-            if (rctx->ctx->opts->bs == 0
-                && rctx->rem_len > CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT * (CAN_MAX_DLEN - 1))
-            {
-                LOG_ERR("Pkt length is %d but buffer has only %d bytes", rctx->rem_len,
-                        CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT * (CAN_MAX_DLEN - 1));
+#ifndef CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER
+            if (!receive_ff_fits(rctx)) {
+                LOG_ERR("Pkt length is %d but buffers are too small", rctx->rem_len);
                 receive_report_error(rctx, ISOTP_N_BUFFER_OVERFLW);
                 receive_state_machine(rctx);
                 break;
             }
+#endif /* CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER */
 #ifdef CONFIG_ISOTP_FAST_BLOCKING_RECEIVE
             notify_waiting_receiver(rctx);
 #endif
@@ -376,18 +676,30 @@ static void receive_state_machine(struct isotp_fast_recv_ctx *rctx)
             __fallthrough;
         case ISOTP_RX_STATE_TRY_ALLOC:
             LOG_DBG("SM try to allocate");
-            k_timer_stop(&rctx->timer);
+            isotp_fast_timeout_stop(&rctx->timeout);
 
 #ifdef CONFIG_ISOTP_FAST_BLOCKING_RECEIVE
             notify_waiting_receiver(rctx);
 #endif
+#ifdef CONFIG_ISOTP_FAST_RX_BACKPRESSURE
+            if (!receive_reserve_block(rctx)) {
+                receive_wait_for_buffers(rctx);
+                break;
+            }
+#elif defined(ISOTP_FAST_RECEIVE_QUEUE)
+            if (!receive_limit_block(rctx)) {
+                /* retried as soon as the consumer took frames, FC.WAIT is sent on timeout */
+                isotp_fast_timeout_start(&rctx->timeout, ISOTP_ALLOC_TIMEOUT_MS);
+                break;
+            }
+#endif
 
             rctx->state = ISOTP_RX_STATE_SEND_FC;
             __fallthrough;
         case ISOTP_RX_STATE_SEND_FC:
             LOG_DBG("SM send CTS FC frame");
             receive_send_fc(rctx, ISOTP_PCI_FS_CTS);
-            k_timer_start(&rctx->timer, K_MSEC(ISOTP_CR_TIMEOUT_MS), K_NO_WAIT);
+            isotp_fast_timeout_start(&rctx->timeout, ISOTP_CR_TIMEOUT_MS);
             rctx->state = ISOTP_RX_STATE_WAIT_CF;
             break;
 
@@ -395,7 +707,7 @@ static void receive_state_machine(struct isotp_fast_recv_ctx *rctx)
             if (++rctx->wft < CONFIG_ISOTP_WFTMAX) {
                 LOG_DBG("Send wait frame number %d", rctx->wft);
                 receive_send_fc(rctx, ISOTP_PCI_FS_WAIT);
-                k_timer_start(&rctx->timer, K_MSEC(ISOTP_ALLOC_TIMEOUT_MS), K_NO_WAIT);
+                isotp_fast_timeout_start(&rctx->timeout, ISOTP_ALLOC_TIMEOUT_MS);
                 rctx->state = ISOTP_RX_STATE_TRY_ALLOC;
                 break;
             }
@@ -405,7 +717,7 @@ static void receive_state_machine(struct isotp_fast_recv_ctx *rctx)
             __fallthrough;
         case ISOTP_RX_STATE_ERR:
             // LOG_DBG("SM ERR state. err nr: %d", ctx->error_nr);
-            k_timer_stop(&rctx->timer);
+            isotp_fast_timeout_stop(&rctx->timeout);
             if (rctx->ctx->recv_error_callback) {
                 rctx->ctx->recv_error_callback(rctx->error, rctx->rx_addr, rctx->ctx->recv_cb_arg);
             }
@@ -416,11 +728,10 @@ static void receive_state_machine(struct isotp_fast_recv_ctx *rctx)
                 receive_send_fc(rctx, ISOTP_PCI_FS_OVFLW);
             }
 
-            // net_buf_unref(ctx->buffer);
-            // ctx->buffer = NULL;
-            // ctx->state = ISOTP_RX_STATE_RECYCLE;
+            /* incomplete message must not be dispatched, so don't fall through to recycle */
+            rctx->state = ISOTP_RX_STATE_UNBOUND;
             free_recv_ctx_if_unowned(rctx);
-            __fallthrough;
+            break;
         case ISOTP_RX_STATE_RECYCLE:
 #ifndef ISOTP_FAST_RECEIVE_QUEUE
             LOG_DBG("Message complete; dispatching");
@@ -440,6 +751,44 @@ static void receive_state_machine(struct isotp_fast_recv_ctx *rctx)
     }
 }
 
+#ifdef ISOTP_FAST_RECEIVE_QUEUE
+/**
+ * Hands the current fragment over to the consumer. The ring can only overflow if the sender
+ * ignores the advertised block size, in which case the reception is aborted.
+ *
+ * @returns false if the fragment was dropped
+ */
+static bool receive_enqueue(struct isotp_fast_recv_ctx *rctx)
+{
+    int *p_rem_len = net_buf_user_data(rctx->frag);
+
+    *p_rem_len = rctx->rem_len;
+    if (rctx->frag == rctx->buffer) {
+        /* the first fragment is owned by the ring from now on */
+        rctx->buffer = NULL;
+    }
+
+    if (!isotp_fast_rx_ring_put(&rctx->ring, rctx->frag)) {
+        LOG_ERR("Receive ring full; dropping frame");
+        net_buf_unref(rctx->frag);
+        rctx->frag = NULL;
+#ifdef CONFIG_ISOTP_FAST_RX_STATS
+        rctx->ctx->rx_stats.dropped_no_buf++;
+#endif
+        receive_report_error(rctx, ISOTP_NO_BUF_DATA_LEFT);
+        return false;
+    }
+
+    LOG_DBG("Enqueued item; remaining length %d", *p_rem_len);
+#ifdef CONFIG_ISOTP_FAST_BLOCKING_RECEIVE
+    if (atomic_cas(&rctx->ring_waiting, 1, 0)) {
+        k_sem_give(&rctx->ring_sem);
+    }
+#endif
+    return true;
+}
+#endif /* ISOTP_FAST_RECEIVE_QUEUE */
+
 static void process_ff_sf(struct isotp_fast_recv_ctx *rctx, struct can_frame *frame)
 {
     int index = 0;
@@ -453,10 +802,19 @@ static void process_ff_sf(struct isotp_fast_recv_ctx *rctx, struct can_frame *fr
                 return;
             }
 
-            rctx->rem_len = receive_get_ff_length(frame->data);
+            rctx->rem_len = receive_get_ff_length(frame->data, &index);
+            if (index > 2 && rctx->rem_len <= ISOTP_FAST_FF_DL_12BIT_MAX) {
+                LOG_DBG("FF escape sequence used for short message. Ignore");
+                return;
+            }
+            if (rctx->rem_len > ISOTP_FAST_MAX_LEN) {
+                LOG_ERR("FF total length %d exceeds limit", rctx->rem_len);
+                receive_report_error(rctx, ISOTP_N_BUFFER_OVERFLW);
+                return;
+            }
+
             rctx->state = ISOTP_RX_STATE_PROCESS_FF;
             rctx->sn_expected = 1;
-            index += 2;
             payload_len = CAN_MAX_DLEN - index;
             LOG_DBG("FF total length %d, FF len %d", rctx->rem_len, payload_len);
             break;
@@ -479,15 +837,28 @@ static void process_ff_sf(struct isotp_fast_recv_ctx *rctx, struct can_frame *fr
             return;
     }
 
+#ifdef CONFIG_ISOTP_FAST_RX_LINEAR_BUFFER
+    /* net_buf sizes are limited to 16 bits */
+    rctx->buffer = NULL;
+    if (rctx->rem_len <= UINT16_MAX) {
+        rctx->buffer = net_buf_alloc_len(&isotp_rx_pool, rctx->rem_len, K_NO_WAIT);
+    }
+    if (rctx->buffer == NULL) {
+        LOG_ERR("No buffer for message of length %d", rctx->rem_len);
+        /* only a FF can be answered with an overflow FC */
+        receive_report_error(rctx, rctx->state == ISOTP_RX_STATE_PROCESS_FF
+                                       ? ISOTP_N_BUFFER_OVERFLW
+                                       : ISOTP_NO_NET_BUF_LEFT);
+        return;
+    }
+    rctx->frag = rctx->buffer;
+#endif
+
     LOG_DBG("Current buffer size %d; adding %d", rctx->buffer->len, payload_len);
     net_buf_add_mem(rctx->frag, &frame->data[index], payload_len);
     rctx->rem_len -= payload_len;
 #ifdef ISOTP_FAST_RECEIVE_QUEUE
-    int *p_rem_len = net_buf_user_data(rctx->frag);
-    *p_rem_len = rctx->rem_len;
-    k_msgq_put(&rctx->recv_queue, &rctx->frag, K_NO_WAIT);
-    LOG_DBG("Enqueued item; remaining length %d, queue size %d", *p_rem_len,
-            k_msgq_num_used_get(&rctx->recv_queue));
+    receive_enqueue(rctx);
 #endif
 }
 
@@ -500,16 +871,16 @@ static void process_cf(struct isotp_fast_recv_ctx *rctx, struct can_frame *frame
         LOG_DBG("Waiting for CF but got something else (%d)",
                 frame->data[index] >> ISOTP_PCI_TYPE_POS);
         receive_report_error(rctx, ISOTP_N_UNEXP_PDU);
-        k_work_submit(&rctx->work);
+        receive_submit(rctx);
         return;
     }
 
-    k_timer_start(&rctx->timer, K_MSEC(ISOTP_CR_TIMEOUT_MS), K_NO_WAIT);
+    isotp_fast_timeout_start(&rctx->timeout, ISOTP_CR_TIMEOUT_MS);
 
     if ((frame->data[index++] & ISOTP_PCI_SN_MASK) != rctx->sn_expected++) {
         LOG_ERR("Sequence number mismatch");
         receive_report_error(rctx, ISOTP_N_WRONG_SN);
-        k_work_submit(&rctx->work);
+        receive_submit(rctx);
         return;
     }
 
@@ -518,20 +889,25 @@ static void process_cf(struct isotp_fast_recv_ctx *rctx, struct can_frame *frame
     net_buf_add_mem(rctx->frag, &frame->data[index], data_len);
     rctx->rem_len -= data_len;
 #ifdef ISOTP_FAST_RECEIVE_QUEUE
-    int *p_rem_len = net_buf_user_data(rctx->frag);
-    *p_rem_len = rctx->rem_len;
-    k_msgq_put(&rctx->recv_queue, &rctx->frag, K_NO_WAIT); /* what if this fails? */
-    LOG_DBG("Enqueued item; remaining length %d, queue size %d", *p_rem_len,
-            k_msgq_num_used_get(&rctx->recv_queue));
+    if (!receive_enqueue(rctx)) {
+        receive_submit(rctx);
+        return;
+    }
 #endif
     LOG_DBG("Added %d bytes; %d bytes remaining", data_len, rctx->rem_len);
 
     if (rctx->rem_len == 0) {
         rctx->state = ISOTP_RX_STATE_RECYCLE;
-        k_work_submit(&rctx->work); // to dispatch complete message
+        receive_submit(rctx); // to dispatch complete message
         return;
     }
 
+#ifdef ISOTP_FAST_RX_ADAPTIVE_BS
+    if (rctx->bs_adv && !--rctx->bs) {
+        LOG_DBG("Block is complete. Reserve buffers for next block");
+        rctx->state = ISOTP_RX_STATE_TRY_ALLOC;
+    }
+#else
     if (rctx->ctx->opts->bs && !--rctx->bs) {
         LOG_DBG("Block is complete. Allocate new buffer");
         rctx->bs = rctx->ctx->opts->bs;
@@ -539,6 +915,7 @@ static void process_cf(struct isotp_fast_recv_ctx *rctx, struct can_frame *frame
         // rctx->ctx->recv_cb_arg);
         rctx->state = ISOTP_RX_STATE_TRY_ALLOC;
     }
+#endif
 }
 
 static void receive_work_handler(struct k_work *work)
@@ -548,9 +925,9 @@ static void receive_work_handler(struct k_work *work)
     receive_state_machine(rctx);
 }
 
-static void receive_timeout_handler(struct k_timer *timer)
+static void receive_timeout_handler(struct isotp_fast_timeout *timeout)
 {
-    struct isotp_fast_recv_ctx *rctx = CONTAINER_OF(timer, struct isotp_fast_recv_ctx, timer);
+    struct isotp_fast_recv_ctx *rctx = CONTAINER_OF(timeout, struct isotp_fast_recv_ctx, timeout);
 
     switch (rctx->state) {
         case ISOTP_RX_STATE_WAIT_CF:
@@ -559,14 +936,17 @@ static void receive_timeout_handler(struct k_timer *timer)
             break;
 
         case ISOTP_RX_STATE_TRY_ALLOC:
+#ifndef CONFIG_ISOTP_FAST_RX_BACKPRESSURE
+            /* with back-pressure, the reservation is retried before sending FC.WAIT */
             rctx->state = ISOTP_RX_STATE_SEND_WAIT;
+#endif
             break;
 
         default:
             break;
     }
 
-    k_work_submit(&rctx->work);
+    receive_submit(rctx);
 }
 
 static void receive_can_rx(struct isotp_fast_recv_ctx *rctx, struct can_frame *frame)
@@ -588,7 +968,7 @@ static void receive_can_rx(struct isotp_fast_recv_ctx *rctx, struct can_frame *f
             LOG_DBG("Got a frame in a state where it is unexpected.");
     }
 
-    k_work_submit(&rctx->work);
+    receive_submit(rctx);
 }
 
 static inline void prepare_frame(struct can_frame *frame, struct isotp_fast_ctx *ctx,
@@ -601,19 +981,124 @@ static inline void prepare_frame(struct can_frame *frame, struct isotp_fast_ctx
 #endif
 }
 
-static k_timeout_t stmin_to_timeout(uint8_t stmin)
+static uint32_t stmin_to_us(uint8_t stmin)
 {
     /* According to ISO 15765-2 stmin should be 127ms if value is corrupt */
     if (stmin > ISOTP_STMIN_MAX || (stmin > ISOTP_STMIN_MS_MAX && stmin < ISOTP_STMIN_US_BEGIN)) {
-        return K_MSEC(ISOTP_STMIN_MS_MAX);
+        return ISOTP_STMIN_MS_MAX * USEC_PER_MSEC;
     }
 
     if (stmin >= ISOTP_STMIN_US_BEGIN) {
-        return K_USEC((stmin + 1 - ISOTP_STMIN_US_BEGIN) * 100U);
+        return (stmin + 1 - ISOTP_STMIN_US_BEGIN) * 100U;
+    }
+
+    return stmin * USEC_PER_MSEC;
+}
+
+static k_timeout_t stmin_to_timeout(uint8_t stmin)
+{
+    return K_USEC(stmin_to_us(stmin));
+}
+
+#ifdef CONFIG_ISOTP_FAST_STMIN_COUNTER
+static int8_t stmin_counter_chan_alloc(void)
+{
+    if (!device_is_ready(stmin_counter)) {
+        return -1;
+    }
+
+    uint8_t num_chans = MIN(counter_get_num_of_channels(stmin_counter), 32);
+    for (uint8_t i = 0; i < num_chans; i++) {
+        if (!atomic_test_and_set_bit(&stmin_counter_chans, i)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+#endif
+
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+#ifdef CONFIG_ISOTP_FAST_STMIN_STATS
+static void stmin_stats_record(struct isotp_fast_send_ctx *sctx)
+{
+    uint32_t elapsed_ns = k_cyc_to_ns_floor64(k_cycle_get_32() - sctx->st_start);
+    int32_t dev_ns = elapsed_ns - stmin_to_us(sctx->stmin) * NSEC_PER_USEC;
+    k_spinlock_key_t key = k_spin_lock(&stmin_stats_lock);
+
+    if (stmin_stats.count == 0) {
+        stmin_stats.min_dev_ns = dev_ns;
+        stmin_stats.max_dev_ns = dev_ns;
+    }
+    else {
+        stmin_stats.min_dev_ns = MIN(stmin_stats.min_dev_ns, dev_ns);
+        stmin_stats.max_dev_ns = MAX(stmin_stats.max_dev_ns, dev_ns);
+    }
+    stmin_stats.count++;
+    stmin_stats_abs_dev_sum += dev_ns < 0 ? -dev_ns : dev_ns;
+
+    k_spin_unlock(&stmin_stats_lock, key);
+}
+#endif
+
+/**
+ * Continues the transfer after STmin elapsed. Called from the timer or counter alarm ISR.
+ */
+static void send_stmin_elapsed(struct isotp_fast_send_ctx *sctx)
+{
+    if (sctx->state != ISOTP_TX_WAIT_ST) {
+        return;
+    }
+
+#ifdef CONFIG_ISOTP_FAST_STMIN_STATS
+    stmin_stats_record(sctx);
+#endif
+    sctx->state = ISOTP_TX_SEND_CF;
+    send_cf_pipeline(sctx);
+}
+
+#ifdef CONFIG_ISOTP_FAST_STMIN_COUNTER
+static void send_stmin_alarm_handler(const struct device *dev, uint8_t chan_id, uint32_t ticks,
+                                     void *user_data)
+{
+    send_stmin_elapsed(user_data);
+}
+#endif
+
+/**
+ * Starts the separation time before the next CF, using the counter alarm channel of the
+ * context if available.
+ */
+static void send_stmin_start(struct isotp_fast_send_ctx *sctx)
+{
+    sctx->state = ISOTP_TX_WAIT_ST;
+#ifdef CONFIG_ISOTP_FAST_STMIN_STATS
+    sctx->st_start = k_cycle_get_32();
+#endif
+
+#ifdef CONFIG_ISOTP_FAST_STMIN_COUNTER
+    if (sctx->counter_chan >= 0) {
+        /* round up, as the frame must never be sent before STmin elapsed */
+        uint64_t ticks = DIV_ROUND_UP((uint64_t)stmin_to_us(sctx->stmin)
+                                          * counter_get_frequency(stmin_counter),
+                                      USEC_PER_SEC);
+        struct counter_alarm_cfg alarm = {
+            .callback = send_stmin_alarm_handler,
+            .ticks = MAX(ticks, 1),
+            .user_data = sctx,
+        };
+
+        if (ticks <= counter_get_top_value(stmin_counter)
+            && counter_set_channel_alarm(stmin_counter, sctx->counter_chan, &alarm) == 0)
+        {
+            return;
+        }
     }
+#endif
 
-    return K_MSEC(stmin);
+    k_timer_start(&sctx->timer, stmin_to_timeout(sctx->stmin), K_NO_WAIT);
 }
+#endif /* CONFIG_ISOTP_FAST_TX_PIPELINE */
 
 static void send_process_fc(struct isotp_fast_send_ctx *sctx, struct can_frame *frame)
 {
@@ -629,16 +1114,25 @@ static void send_process_fc(struct isotp_fast_send_ctx *sctx, struct can_frame *
         case ISOTP_PCI_FS_CTS:
             sctx->state = ISOTP_TX_SEND_CF;
             sctx->wft = 0;
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+            sctx->nas_deadline = 0;
+#else
             sctx->backlog = 0;
             k_sem_reset(&sctx->sem);
+#endif
             sctx->bs = *data++;
             sctx->stmin = *data++;
+#ifdef CONFIG_ISOTP_FAST_STMIN_COUNTER
+            if (sctx->stmin != 0 && sctx->counter_chan < 0) {
+                sctx->counter_chan = stmin_counter_chan_alloc();
+            }
+#endif
             LOG_DBG("Got CTS. BS: %d, STmin: %d", sctx->bs, sctx->stmin);
             break;
 
         case ISOTP_PCI_FS_WAIT:
             LOG_DBG("Got WAIT frame");
-            k_timer_start(&sctx->timer, K_MSEC(ISOTP_BS_TIMEOUT_MS), K_NO_WAIT);
+            isotp_fast_timeout_start(&sctx->timeout, ISOTP_BS_TIMEOUT_MS);
             if (sctx->wft >= CONFIG_ISOTP_WFTMAX) {
                 LOG_WRN("Got too many wait frames");
                 send_report_error(sctx, ISOTP_N_WFT_OVRN);
@@ -660,7 +1154,7 @@ static void send_process_fc(struct isotp_fast_send_ctx *sctx, struct can_frame *
 static void send_can_rx(struct isotp_fast_send_ctx *sctx, struct can_frame *frame)
 {
     if (sctx->state == ISOTP_TX_WAIT_FC) {
-        k_timer_stop(&sctx->timer);
+        isotp_fast_timeout_stop(&sctx->timeout);
         send_process_fc(sctx, frame);
     }
     else {
@@ -668,7 +1162,19 @@ static void send_can_rx(struct isotp_fast_send_ctx *sctx, struct can_frame *fram
         send_report_error(sctx, ISOTP_N_UNEXP_PDU);
     }
 
-    k_work_submit(&sctx->work);
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+    if (sctx->state == ISOTP_TX_SEND_CF) {
+        /* start the block right away instead of deferring it to the work queue */
+        send_cf_pipeline(sctx);
+        return;
+    }
+    if (atomic_get(&sctx->inflight) > 0) {
+        /* the context is released once the TX callbacks of the frames in flight ran */
+        return;
+    }
+#endif
+
+    send_submit(sctx);
 }
 
 static void can_rx_callback(const struct device *dev, struct can_frame *frame, void *arg)
@@ -686,8 +1192,10 @@ static void can_rx_callback(const struct device *dev, struct can_frame *frame, v
     if ((frame->data[index++] & ISOTP_PCI_TYPE_MASK) == ISOTP_PCI_TYPE_FC) {
         LOG_DBG("Got flow control frame from %x", frame->id);
         /* inbound flow control for a message we are currently transmitting */
-        struct isotp_fast_send_ctx *sctx;
-        if (get_send_ctx(ctx, reply_addr, &sctx) != 0) {
+        k_spinlock_key_t key = k_spin_lock(&send_ctx_lock);
+        struct isotp_fast_send_ctx *sctx = isotp_fast_find_send_ctx(ctx, &reply_addr);
+        k_spin_unlock(&send_ctx_lock, key);
+        if (sctx == NULL) {
             LOG_DBG("Ignoring flow control frame from %x", frame->id);
             return;
         }
@@ -695,17 +1203,82 @@ static void can_rx_callback(const struct device *dev, struct can_frame *frame, v
     }
     else {
         struct isotp_fast_recv_ctx *rctx;
-        if (get_recv_ctx(ctx, sender_addr, &rctx) != 0) {
+        int ret = get_recv_ctx(ctx, sender_addr, &rctx);
+        if (ret != 0) {
             LOG_ERR("RX buffer full");
+#ifdef CONFIG_ISOTP_FAST_RX_STATS
+            if (ret == ISOTP_NO_CTX_LEFT) {
+                ctx->rx_stats.dropped_no_ctx++;
+            }
+            else {
+                ctx->rx_stats.dropped_no_buf++;
+            }
+#endif
             return;
         }
         receive_can_rx(rctx, frame);
     }
 }
 
-static void send_can_tx_callback(const struct device *dev, int error, void *arg)
+#if CONFIG_ISOTP_FAST_RX_ADDR_COUNT > 0
+static void can_rx_functional_callback(const struct device *dev, struct can_frame *frame,
+                                       void *arg)
 {
-    struct isotp_fast_send_ctx *sctx = arg;
+    int index = 0;
+
+#ifdef CONFIG_ISOTP_FAST_EXTENDED_ADDRESSING
+    index++;
+#endif
+
+    /* functional addressing is restricted to single frames without flow control */
+    if ((frame->data[index] & ISOTP_PCI_TYPE_MASK) != ISOTP_PCI_TYPE_SF) {
+        LOG_DBG("Ignoring multi-frame PDU from %x on functional address", frame->id);
+        return;
+    }
+
+    can_rx_callback(dev, frame, arg);
+}
+#endif
+
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+static void send_can_tx_callback(const struct device *dev, int error, void *arg)
+{
+    struct isotp_fast_send_ctx *sctx = arg;
+
+    ARG_UNUSED(dev);
+
+    atomic_dec(&sctx->inflight);
+
+    if (error != 0 && sctx->state != ISOTP_TX_ERR) {
+        LOG_ERR("Error sending frame (%d)", error);
+        send_report_error(sctx, ISOTP_N_ERROR);
+    }
+
+    switch (sctx->state) {
+        case ISOTP_TX_SEND_CF:
+            if (sctx->stmin != 0 && sctx->rem_len > 0) {
+                /* STmin is the separation between the end of a frame and the start of the next */
+                send_stmin_start(sctx);
+                break;
+            }
+            send_cf_pipeline(sctx);
+            break;
+
+        case ISOTP_TX_ERR:
+            if (atomic_get(&sctx->inflight) == 0) {
+                send_submit(sctx);
+            }
+            break;
+
+        default:
+            /* FF confirmed or last CF of a block confirmed while waiting for the next FC */
+            break;
+    }
+}
+#else
+static void send_can_tx_callback(const struct device *dev, int error, void *arg)
+{
+    struct isotp_fast_send_ctx *sctx = arg;
 
     ARG_UNUSED(dev);
 
@@ -720,7 +1293,61 @@ static void send_can_tx_callback(const struct device *dev, int error, void *arg)
         sctx->state = ISOTP_TX_WAIT_FIN;
     }
 
-    k_work_submit(&sctx->work);
+    send_submit(sctx);
+}
+#endif /* CONFIG_ISOTP_FAST_TX_PIPELINE */
+
+/**
+ * Copies the next bytes of the message to be sent without consuming them.
+ */
+static void send_peek_data(struct isotp_fast_send_ctx *sctx, uint8_t *dst, size_t len)
+{
+    const uint8_t *src = sctx->data;
+    struct net_buf *frag = sctx->frag;
+
+    if (frag == NULL) {
+        memcpy(dst, src, len);
+        return;
+    }
+
+    while (len > 0) {
+        size_t avail = frag->data + frag->len - src;
+        if (avail == 0) {
+            frag = frag->frags;
+            src = frag->data;
+            continue;
+        }
+        size_t size = MIN(len, avail);
+        memcpy(dst, src, size);
+        dst += size;
+        src += size;
+        len -= size;
+    }
+}
+
+/**
+ * Consumes bytes of the message after they were handed over to the CAN driver.
+ */
+static void send_advance_data(struct isotp_fast_send_ctx *sctx, size_t len)
+{
+    sctx->rem_len -= len;
+
+    if (sctx->frag == NULL) {
+        sctx->data += len;
+        return;
+    }
+
+    while (len > 0) {
+        size_t avail = sctx->frag->data + sctx->frag->len - sctx->data;
+        if (avail == 0) {
+            sctx->frag = sctx->frag->frags;
+            sctx->data = sctx->frag->data;
+            continue;
+        }
+        size_t size = MIN(len, avail);
+        sctx->data += size;
+        len -= size;
+    }
 }
 
 static inline int send_ff(struct isotp_fast_send_ctx *sctx)
@@ -728,17 +1355,16 @@ static inline int send_ff(struct isotp_fast_send_ctx *sctx)
     struct can_frame frame;
     int index = 0;
     int ret;
-    uint16_t len = sctx->rem_len;
+    uint32_t len = sctx->rem_len;
 
     prepare_frame(&frame, sctx->ctx, sctx->tx_addr, &index);
 
-    if (len > 0xFFF) {
+    if (len > ISOTP_FAST_FF_DL_12BIT_MAX) {
+        /* escape sequence with 32-bit FF_DL */
         frame.data[index++] = ISOTP_PCI_TYPE_FF;
         frame.data[index++] = 0;
-        frame.data[index++] = (len >> 3 * 8) & 0xFF;
-        frame.data[index++] = (len >> 2 * 8) & 0xFF;
-        frame.data[index++] = (len >> 8) & 0xFF;
-        frame.data[index++] = len & 0xFF;
+        sys_put_be32(len, &frame.data[index]);
+        index += sizeof(uint32_t);
     }
     else {
         frame.data[index++] = ISOTP_PCI_TYPE_FF | (len >> 8);
@@ -749,17 +1375,24 @@ static inline int send_ff(struct isotp_fast_send_ctx *sctx)
      * although it's not part of the FF frame
      */
     sctx->sn = 1;
-    uint16_t size = MIN(CAN_MAX_DLEN - index, len);
-    memcpy(&frame.data[index], sctx->data, size);
-    sctx->rem_len -= size;
-    sctx->data += size;
+    uint32_t size = MIN(CAN_MAX_DLEN - index, len);
+    send_peek_data(sctx, &frame.data[index], size);
+    send_advance_data(sctx, size);
     frame.dlc = can_bytes_to_dlc(CAN_MAX_DLEN);
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+    atomic_inc(&sctx->inflight);
+#endif
     ret = can_send(sctx->ctx->can_dev, &frame, K_MSEC(ISOTP_A_TIMEOUT_MS), send_can_tx_callback,
                    sctx);
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+    if (ret != 0) {
+        atomic_dec(&sctx->inflight);
+    }
+#endif
     return ret;
 }
 
-static inline int send_cf(struct isotp_fast_send_ctx *sctx)
+static inline int send_cf(struct isotp_fast_send_ctx *sctx, k_timeout_t timeout)
 {
     struct can_frame frame;
     int index = 0;
@@ -772,37 +1405,243 @@ static inline int send_cf(struct isotp_fast_send_ctx *sctx)
     frame.data[index++] = ISOTP_PCI_TYPE_CF | sctx->sn;
 
     len = MIN(sctx->rem_len, CAN_MAX_DLEN - index);
-    memcpy(&frame.data[index], sctx->data, len);
-    sctx->rem_len -= len;
-    sctx->data += len;
+    send_peek_data(sctx, &frame.data[index], len);
 
     frame.dlc = can_bytes_to_dlc(len + index);
-    ret = can_send(sctx->ctx->can_dev, &frame, K_MSEC(ISOTP_A_TIMEOUT_MS), send_can_tx_callback,
-                   sctx);
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+    /* account for the frame before its TX callback can run */
+    atomic_inc(&sctx->inflight);
+#endif
+    ret = can_send(sctx->ctx->can_dev, &frame, timeout, send_can_tx_callback, sctx);
     if (ret == 0) {
+        /* only advance once the frame was accepted, so it can be retried otherwise */
+        send_advance_data(sctx, len);
         sctx->sn++;
         sctx->bs--;
+#ifndef CONFIG_ISOTP_FAST_TX_PIPELINE
         sctx->backlog++;
+#endif
+    }
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+    else {
+        atomic_dec(&sctx->inflight);
     }
+#endif
 
     ret = ret ? ret : sctx->rem_len;
     return ret;
 }
 
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+/**
+ * Queues consecutive frames until the pipeline is full, the block is complete or the message
+ * was sent entirely. Must only be called via send_cf_pipeline().
+ */
+static void send_cf_fill(struct isotp_fast_send_ctx *sctx)
+{
+    const atomic_val_t depth = sctx->stmin == 0 ? CONFIG_ISOTP_FAST_TX_PIPELINE_DEPTH : 1;
+    int ret;
+
+    while (sctx->state == ISOTP_TX_SEND_CF && sctx->rem_len > 0
+           && atomic_get(&sctx->inflight) < depth)
+    {
+        ret = send_cf(sctx, K_NO_WAIT);
+        if (ret == -EAGAIN) {
+            if (atomic_get(&sctx->inflight) > 0) {
+                /* refilled from the TX callback of the next confirmed frame */
+                break;
+            }
+            /* TX mailboxes occupied by other messages, so poll until one is free */
+            if (sctx->nas_deadline == 0) {
+                sctx->nas_deadline = k_uptime_get() + ISOTP_A_TIMEOUT_MS;
+            }
+            else if (k_uptime_get() >= sctx->nas_deadline) {
+                LOG_ERR("Failed to send CF");
+                send_report_error(sctx, ISOTP_N_TIMEOUT_A);
+                break;
+            }
+            k_timer_start(&sctx->timer, K_MSEC(1), K_NO_WAIT);
+            break;
+        }
+        else if (ret < 0) {
+            LOG_ERR("Failed to send CF");
+            send_report_error(sctx, ISOTP_N_ERROR);
+            break;
+        }
+
+        sctx->nas_deadline = 0;
+        if (sctx->ctx->opts->bs && !sctx->bs) {
+            isotp_fast_timeout_start(&sctx->timeout, ISOTP_BS_TIMEOUT_MS);
+            sctx->state = ISOTP_TX_WAIT_FC;
+            LOG_DBG("BS reached. Wait for FC again");
+            break;
+        }
+    }
+
+    if (atomic_get(&sctx->inflight) > 0) {
+        return;
+    }
+
+    if (sctx->state == ISOTP_TX_SEND_CF && sctx->rem_len == 0) {
+        sctx->state = ISOTP_TX_WAIT_FIN;
+        send_submit(sctx);
+    }
+    else if (sctx->state == ISOTP_TX_ERR) {
+        send_submit(sctx);
+    }
+}
+
+/**
+ * Refills the TX pipeline. Called from the work queue, the FC reception, the TX callback and
+ * the STmin timer, possibly preempting each other. Only the first caller fills the pipeline and
+ * repeats this for every request that arrived in the meantime, so that can_send() is never
+ * called concurrently for the same context and no lock is held while calling it.
+ */
+static void send_cf_pipeline(struct isotp_fast_send_ctx *sctx)
+{
+    if (atomic_inc(&sctx->fill_req) != 0) {
+        return;
+    }
+
+    do {
+        send_cf_fill(sctx);
+    } while (atomic_dec(&sctx->fill_req) != 1);
+}
+#endif /* CONFIG_ISOTP_FAST_TX_PIPELINE */
+
+static int send_sf(struct isotp_fast_ctx *ctx, const uint8_t *data, size_t len,
+                   const struct isotp_fast_addr *target_addr)
+{
+    struct can_frame frame;
+    int index = 0;
+
+    prepare_frame(&frame, ctx, *target_addr, &index);
+#ifdef CONFIG_CAN_FD_MODE
+    if (len > ISOTP_4BIT_SF_MAX_CAN_DL - 1) {
+        frame.data[index++] = ISOTP_PCI_TYPE_SF;
+        frame.data[index++] = (uint8_t)len;
+    }
+    else {
+        frame.data[index++] = ISOTP_PCI_TYPE_SF | (uint8_t)len;
+    }
+#else
+    frame.data[index++] = (uint8_t)len;
+#endif
+    frame.dlc = can_bytes_to_dlc(len + index);
+    memcpy(&frame.data[index], data, len);
+
+    return can_send(ctx->can_dev, &frame, K_MSEC(ISOTP_A_TIMEOUT_MS), NULL, NULL);
+}
+
+#if CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH > 0
+/**
+ * Queues a message behind the ongoing transfer. Must be called with send_ctx_lock held.
+ */
+static int send_enqueue(struct isotp_fast_send_ctx *sctx, const uint8_t *data,
+                        struct net_buf *buf, uint32_t len, void *cb_arg)
+{
+    struct isotp_fast_send_req *req;
+
+    if (sctx->queued >= CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH) {
+        return -EBUSY;
+    }
+
+    if (k_mem_slab_alloc(&isotp_send_req_slab, (void **)&req, K_NO_WAIT) != 0) {
+        return -ENOBUFS;
+    }
+
+    req->data = data;
+    req->buf = buf;
+    req->len = len;
+    req->cb_arg = cb_arg;
+    sys_slist_append(&sctx->queue, &req->node);
+    sctx->queued++;
+
+    return 0;
+}
+
+/**
+ * Takes the next queued message. If there is none, the context is removed from its bucket
+ * in the same critical section, so that new messages get a new context instead of being
+ * queued in this one.
+ */
+static struct isotp_fast_send_req *send_dequeue(struct isotp_fast_send_ctx *sctx)
+{
+    k_spinlock_key_t key = k_spin_lock(&send_ctx_lock);
+    sys_snode_t *node = sys_slist_get(&sctx->queue);
+
+    if (node != NULL) {
+        sctx->queued--;
+    }
+    else {
+        sys_slist_find_and_remove(isotp_fast_send_bucket(sctx->ctx, &sctx->tx_addr), &sctx->node);
+    }
+    k_spin_unlock(&send_ctx_lock, key);
+
+    return node != NULL ? CONTAINER_OF(node, struct isotp_fast_send_req, node) : NULL;
+}
+#endif /* CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH > 0 */
+
+/**
+ * Reports the result of the current message and starts the next message queued for the
+ * recipient or frees the context if there is none.
+ *
+ * The next message is taken (or the context released) before the sent callback is invoked,
+ * so that a message sent from within the callback is never rejected because of the
+ * finished transfer.
+ */
+static void send_complete(struct isotp_fast_send_ctx *sctx, int result)
+{
+    struct isotp_fast_ctx *ctx = sctx->ctx;
+    void *cb_arg = sctx->cb_arg;
+#if CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH > 0
+    struct isotp_fast_send_req *req;
+
+    k_timer_stop(&sctx->timer);
+    isotp_fast_timeout_stop(&sctx->timeout);
+
+    while ((req = send_dequeue(sctx)) != NULL) {
+        send_ctx_load(sctx, req->data, req->buf, req->len, req->cb_arg);
+        k_mem_slab_free(&isotp_send_req_slab, req);
+        ctx->sent_callback(result, cb_arg);
+
+        if (sctx->rem_len > CAN_MAX_DLEN - ISOTP_FAST_SF_LEN_BYTE) {
+            LOG_DBG("Starting queued message for recipient %x", sctx->tx_addr.ext_id);
+            send_submit(sctx);
+            return;
+        }
+
+        /* short messages queued behind a transfer are sent as a single frame right away */
+        uint8_t data[CAN_MAX_DLEN];
+        send_peek_data(sctx, data, sctx->rem_len);
+        result = send_sf(ctx, data, sctx->rem_len, &sctx->tx_addr);
+        cb_arg = sctx->cb_arg;
+    }
+#endif
+    free_send_ctx(sctx);
+    ctx->sent_callback(result, cb_arg);
+}
+
 static void send_state_machine(struct isotp_fast_send_ctx *sctx)
 {
+#ifndef CONFIG_ISOTP_FAST_TX_PIPELINE
     int ret;
+#endif
     switch (sctx->state) {
         case ISOTP_TX_SEND_FF:
             send_ff(sctx);
-            k_timer_start(&sctx->timer, K_MSEC(ISOTP_BS_TIMEOUT_MS), K_NO_WAIT);
+            isotp_fast_timeout_start(&sctx->timeout, ISOTP_BS_TIMEOUT_MS);
             sctx->state = ISOTP_TX_WAIT_FC;
             break;
 
         case ISOTP_TX_SEND_CF:
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+            send_cf_pipeline(sctx);
+            break;
+#else
             k_timer_stop(&sctx->timer);
             do {
-                ret = send_cf(sctx);
+                ret = send_cf(sctx, K_MSEC(ISOTP_A_TIMEOUT_MS));
                 if (!ret) {
                     sctx->state = ISOTP_TX_WAIT_BACKLOG;
                     break;
@@ -815,7 +1654,7 @@ static void send_state_machine(struct isotp_fast_send_ctx *sctx)
                 }
 
                 if (sctx->ctx->opts->bs && !sctx->bs) {
-                    k_timer_start(&sctx->timer, K_MSEC(ISOTP_BS_TIMEOUT_MS), K_NO_WAIT);
+                    isotp_fast_timeout_start(&sctx->timeout, ISOTP_BS_TIMEOUT_MS);
                     sctx->state = ISOTP_TX_WAIT_FC;
                     LOG_DBG("BS reached. Wait for FC again");
                     break;
@@ -829,6 +1668,7 @@ static void send_state_machine(struct isotp_fast_send_ctx *sctx)
                 k_sem_take(&sctx->sem, K_FOREVER);
             } while (ret > 0);
             break;
+#endif /* CONFIG_ISOTP_FAST_TX_PIPELINE */
 
         case ISOTP_TX_WAIT_ST:
             k_timer_start(&sctx->timer, stmin_to_timeout(sctx->stmin), K_NO_WAIT);
@@ -838,9 +1678,8 @@ static void send_state_machine(struct isotp_fast_send_ctx *sctx)
 
         case ISOTP_TX_ERR:
             LOG_DBG("SM error");
-            sctx->ctx->sent_callback(sctx->error, sctx->cb_arg);
             sctx->state = ISOTP_TX_STATE_RESET;
-            free_send_ctx(sctx);
+            send_complete(sctx, sctx->error);
             break;
 
             /*
@@ -852,10 +1691,10 @@ static void send_state_machine(struct isotp_fast_send_ctx *sctx)
         case ISOTP_TX_WAIT_FIN:
             LOG_DBG("SM finish");
             k_timer_stop(&sctx->timer);
+            isotp_fast_timeout_stop(&sctx->timeout);
 
-            sctx->ctx->sent_callback(ISOTP_N_OK, sctx->cb_arg);
             sctx->state = ISOTP_TX_STATE_RESET;
-            free_send_ctx(sctx);
+            send_complete(sctx, ISOTP_N_OK);
             break;
 
         default:
@@ -874,12 +1713,34 @@ static void send_timeout_handler(struct k_timer *timer)
 {
     struct isotp_fast_send_ctx *sctx = CONTAINER_OF(timer, struct isotp_fast_send_ctx, timer);
 
-    if (sctx->state != ISOTP_TX_SEND_CF) {
-        LOG_ERR("Timed out waiting for FC frame");
-        send_report_error(sctx, ISOTP_N_TIMEOUT_BS);
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+    switch (sctx->state) {
+        case ISOTP_TX_WAIT_ST:
+            send_stmin_elapsed(sctx);
+            return;
+        case ISOTP_TX_SEND_CF:
+            /* retry after all TX mailboxes were busy */
+            send_cf_pipeline(sctx);
+            return;
+        default:
+            break;
+    }
+#endif
+
+    send_submit(sctx);
+}
+
+static void send_bs_timeout_handler(struct isotp_fast_timeout *timeout)
+{
+    struct isotp_fast_send_ctx *sctx = CONTAINER_OF(timeout, struct isotp_fast_send_ctx, timeout);
+
+    if (sctx->state != ISOTP_TX_WAIT_FC) {
+        return;
     }
 
-    k_work_submit(&sctx->work);
+    LOG_ERR("Timed out waiting for FC frame");
+    send_report_error(sctx, ISOTP_N_TIMEOUT_BS);
+    send_submit(sctx);
 }
 
 static inline void prepare_filter(struct can_filter *filter, uint32_t rx_addr,
@@ -923,11 +1784,16 @@ int isotp_fast_bind(struct isotp_fast_ctx *ctx, const struct device *can_dev,
                     isotp_fast_recv_error_callback_t recv_error_callback,
                     isotp_fast_send_callback_t sent_callback)
 {
-    sys_slist_init(&ctx->isotp_send_ctx_list);
-    sys_slist_init(&ctx->isotp_recv_ctx_list);
+    for (int i = 0; i < CONFIG_ISOTP_FAST_CTX_HASH_BUCKETS; i++) {
+        sys_slist_init(&ctx->isotp_send_ctx_buckets[i]);
+        sys_slist_init(&ctx->isotp_recv_ctx_buckets[i]);
+    }
 #ifdef CONFIG_ISOTP_FAST_BLOCKING_RECEIVE
     sys_slist_init(&ctx->wait_recv_list);
 #endif
+#if CONFIG_ISOTP_FAST_RX_ADDR_COUNT > 0
+    ctx->rx_addr_count = 0;
+#endif
 
     ctx->can_dev = can_dev;
     ctx->opts = opts;
@@ -936,6 +1802,16 @@ int isotp_fast_bind(struct isotp_fast_ctx *ctx, const struct device *can_dev,
     ctx->recv_error_callback = recv_error_callback;
     ctx->sent_callback = sent_callback;
     ctx->rx_addr = rx_addr;
+#ifdef CONFIG_ISOTP_FAST_RX_STATS
+    memset(&ctx->rx_stats, 0, sizeof(ctx->rx_stats));
+#endif
+
+#ifdef CONFIG_ISOTP_FAST_STMIN_COUNTER
+    if (device_is_ready(stmin_counter)) {
+        /* the counter is shared by all contexts, so it may already be running */
+        counter_start(stmin_counter);
+    }
+#endif
 
     struct can_filter filter;
     prepare_filter(&filter, rx_addr.ext_id, opts);
@@ -946,6 +1822,38 @@ int isotp_fast_bind(struct isotp_fast_ctx *ctx, const struct device *can_dev,
     return ISOTP_N_OK;
 }
 
+#if CONFIG_ISOTP_FAST_RX_ADDR_COUNT > 0
+int isotp_fast_add_rx_addr(struct isotp_fast_ctx *ctx, const struct isotp_fast_addr rx_addr,
+                           uint32_t mask, bool functional)
+{
+    struct can_filter filter = {
+        .id = rx_addr.ext_id,
+        .mask = mask,
+        .flags = CAN_FILTER_IDE,
+    };
+    int filter_id;
+
+    if (ctx->rx_addr_count >= CONFIG_ISOTP_FAST_RX_ADDR_COUNT) {
+        return ISOTP_NO_FREE_FILTER;
+    }
+
+    filter_id = can_add_rx_filter(ctx->can_dev,
+                                  functional ? can_rx_functional_callback : can_rx_callback, ctx,
+                                  &filter);
+    if (filter_id < 0) {
+        LOG_ERR("Failed to add filter for %x:%x (%d)", filter.id, filter.mask, filter_id);
+        return ISOTP_NO_FREE_FILTER;
+    }
+
+    ctx->rx_addr_filter_ids[ctx->rx_addr_count++] = filter_id;
+
+    LOG_INF("Added %s address %x:%x", functional ? "functional" : "physical", filter.id,
+            filter.mask);
+
+    return ISOTP_N_OK;
+}
+#endif
+
 #ifdef CONFIG_ISOTP_FAST_BLOCKING_RECEIVE
 static void free_recv_await_ctx(struct isotp_fast_ctx *ctx, struct isotp_fast_recv_await_ctx *actx)
 {
@@ -955,6 +1863,38 @@ static void free_recv_await_ctx(struct isotp_fast_ctx *ctx, struct isotp_fast_re
     }
     k_mem_slab_free(&isotp_recv_await_ctx_slab, actx);
 }
+
+/**
+ * Waits for the next fragment in the ring of a reception. The producer only signals the
+ * semaphore if the receiver announced that it is waiting, so frames arriving while the
+ * receiver is busy do not cause any kernel calls.
+ *
+ * @returns ISOTP_N_OK, ISOTP_RECV_TIMEOUT or the error of the reception
+ */
+static int receive_await_frag(struct isotp_fast_recv_ctx *rctx, k_timeout_t timeout,
+                              struct net_buf **frag)
+{
+    while ((*frag = isotp_fast_rx_ring_get(&rctx->ring)) == NULL) {
+        if (rctx->error != 0) {
+            return rctx->error;
+        }
+
+        atomic_set(&rctx->ring_waiting, 1);
+        /* check again in case a fragment was added before the flag was set */
+        *frag = isotp_fast_rx_ring_get(&rctx->ring);
+        if (*frag != NULL) {
+            atomic_clear(&rctx->ring_waiting);
+            break;
+        }
+
+        if (k_sem_take(&rctx->ring_sem, timeout) != 0) {
+            atomic_clear(&rctx->ring_waiting);
+            return ISOTP_RECV_TIMEOUT;
+        }
+    }
+
+    return ISOTP_N_OK;
+}
 #endif
 
 int isotp_fast_unbind(struct isotp_fast_ctx *ctx)
@@ -963,6 +1903,13 @@ int isotp_fast_unbind(struct isotp_fast_ctx *ctx)
         can_remove_rx_filter(ctx->can_dev, ctx->filter_id);
     }
 
+#if CONFIG_ISOTP_FAST_RX_ADDR_COUNT > 0
+    for (int i = 0; i < ctx->rx_addr_count; i++) {
+        can_remove_rx_filter(ctx->can_dev, ctx->rx_addr_filter_ids[i]);
+    }
+    ctx->rx_addr_count = 0;
+#endif
+
 #ifdef CONFIG_ISOTP_FAST_BLOCKING_RECEIVE
     struct isotp_fast_recv_await_ctx *actx;
     struct isotp_fast_recv_await_ctx *next;
@@ -1002,20 +1949,26 @@ int isotp_fast_recv(struct isotp_fast_ctx *ctx, struct can_filter sender, uint8_
         k_sem_init(&actx->sem, 0, 1);
         sys_slist_append(&ctx->wait_recv_list, &actx->node);
 
-        /* try to find matching receive context in case there is already one pending */
+        /*
+         * try to find matching receive context in case there is already one pending (sender is
+         * masked, so all buckets have to be searched)
+         */
         struct isotp_fast_recv_ctx *rctx;
         bool wait = true;
-        SYS_SLIST_FOR_EACH_CONTAINER(&ctx->isotp_recv_ctx_list, rctx, node)
-        {
-            // TODO: handle extended addressing
-            if ((sender.id & sender.mask) == (rctx->rx_addr.ext_id & sender.mask) && !rctx->pending)
+        for (int i = 0; i < CONFIG_ISOTP_FAST_CTX_HASH_BUCKETS && wait; i++) {
+            SYS_SLIST_FOR_EACH_CONTAINER(&ctx->isotp_recv_ctx_buckets[i], rctx, node)
             {
-                LOG_DBG("Matched await context %x:%x to sender %x", sender.id, sender.mask,
-                        rctx->rx_addr.ext_id);
-                actx->rctx = rctx;
-                rctx->pending = true;
-                wait = false;
-                break;
+                // TODO: handle extended addressing
+                if ((sender.id & sender.mask) == (rctx->rx_addr.ext_id & sender.mask)
+                    && !rctx->pending)
+                {
+                    LOG_DBG("Matched await context %x:%x to sender %x", sender.id, sender.mask,
+                            rctx->rx_addr.ext_id);
+                    actx->rctx = rctx;
+                    rctx->pending = true;
+                    wait = false;
+                    break;
+                }
             }
         }
 
@@ -1039,27 +1992,25 @@ int isotp_fast_recv(struct isotp_fast_ctx *ctx, struct can_filter sender, uint8_
         return ret;
     }
 
+    struct isotp_fast_recv_ctx *rctx = actx->rctx;
     struct net_buf *frag;
     int pos = 0;
     int rem_len = 0;
-    while ((ret = k_msgq_get(&actx->rctx->recv_queue, &frag, timeout)) == 0) {
-        if (actx->rctx->error != 0) {
-            LOG_DBG("Error %d occurred", actx->rctx->error);
-            ret = actx->rctx->error;
-            free_recv_await_ctx(ctx, actx);
-            return ret;
-        }
+    while ((ret = receive_await_frag(rctx, timeout, &frag)) == ISOTP_N_OK) {
         if (pos == 0) {
             LOG_DBG("New messages received");
         }
         rem_len = *(int *)net_buf_user_data(frag);
-        LOG_DBG("Remaining length %d, enqueued %d", rem_len,
-                k_msgq_num_used_get(&actx->rctx->recv_queue));
+        LOG_DBG("Remaining length %d", rem_len);
         int len = MIN(frag->len, size - pos);
         memcpy(buf, frag->data, len);
         net_buf_unref(frag);
         pos += len;
         buf += len;
+        if (rctx->state == ISOTP_RX_STATE_TRY_ALLOC) {
+            /* the sender is waiting for ring slots to be freed */
+            receive_submit(rctx);
+        }
         if (size - pos < (CAN_MAX_DLEN - 1) && rem_len > (CAN_MAX_DLEN - 1)) {
             /* user recv buffer full */
             LOG_DBG("Buffer full; returning");
@@ -1069,67 +2020,154 @@ int isotp_fast_recv(struct isotp_fast_ctx *ctx, struct can_filter sender, uint8_
             break;
         }
     }
-    actx->rctx->pending = false;
-    if (rem_len == 0) {
+    if (ret != ISOTP_N_OK) {
+        LOG_DBG("Receive failed while waiting on more packets (%d)", ret);
         free_recv_await_ctx(ctx, actx);
+        return ret;
     }
-    if (ret == -EAGAIN) {
+    rctx->pending = false;
+    if (rem_len == 0) {
         free_recv_await_ctx(ctx, actx);
-        LOG_DBG("Timed out waiting on more packets");
-        return ISOTP_RECV_TIMEOUT;
     }
     return pos;
 }
 #endif /* CONFIG_ISOTP_FAST_BLOCKING_RECEIVE */
 
-int isotp_fast_send(struct isotp_fast_ctx *ctx, const uint8_t *data, size_t len,
-                    const struct isotp_fast_addr target_addr, void *cb_arg)
+/**
+ * Sends a message either from a linear buffer or from an owned buffer chain. Messages fitting
+ * into a single frame are sent synchronously unless a transfer to the same recipient is
+ * ongoing, in which case the message is queued to preserve the order.
+ */
+static int send_msg(struct isotp_fast_ctx *ctx, const uint8_t *data, struct net_buf *buf,
+                    size_t len, const struct isotp_fast_addr target_addr, void *cb_arg)
 {
-    if (len <= (CAN_MAX_DLEN - ISOTP_FAST_SF_LEN_BYTE)) {
-        struct can_frame frame;
-        int index = 0;
-        prepare_frame(&frame, ctx, target_addr, &index);
-#ifdef CONFIG_CAN_FD_MODE
-        if (len > ISOTP_4BIT_SF_MAX_CAN_DL - 1) {
-            frame.data[index++] = ISOTP_PCI_TYPE_SF;
-            frame.data[index++] = (uint8_t)len;
-        }
-        else {
-            frame.data[index++] = ISOTP_PCI_TYPE_SF | (uint8_t)len;
-        }
+    struct isotp_fast_send_ctx *sctx;
+    k_spinlock_key_t key;
+    int ret;
+
+    if (len > ISOTP_FAST_MAX_LEN) {
+        ret = ISOTP_N_BUFFER_OVERFLW;
+        goto err;
+    }
+
+    key = k_spin_lock(&send_ctx_lock);
+
+    sctx = isotp_fast_find_send_ctx(ctx, &target_addr);
+    if (sctx != NULL) {
+#if CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH > 0
+        ret = send_enqueue(sctx, data, buf, len, cb_arg);
 #else
-        frame.data[index++] = (uint8_t)len;
+        ret = -EBUSY;
 #endif
-        frame.dlc = can_bytes_to_dlc(len + index);
-        memcpy(&frame.data[index], data, len);
-        int ret = can_send(ctx->can_dev, &frame, K_MSEC(ISOTP_A_TIMEOUT_MS), NULL, NULL);
-        ctx->sent_callback(ret, cb_arg);
-        return ret;
+        k_spin_unlock(&send_ctx_lock, key);
+        if (ret != 0) {
+            LOG_DBG("Cannot queue message for recipient %x (%d)", target_addr.ext_id, ret);
+            goto err;
+        }
+        return ISOTP_N_OK;
     }
-    else {
-        if (len > ISOTP_FAST_MAX_LEN) {
-            return ISOTP_N_BUFFER_OVERFLW;
+
+    if (len > (CAN_MAX_DLEN - ISOTP_FAST_SF_LEN_BYTE)) {
+        ret = alloc_send_ctx(ctx, target_addr, &sctx);
+        if (ret == 0) {
+            send_ctx_load(sctx, data, buf, len, cb_arg);
+            sys_slist_append(isotp_fast_send_bucket(ctx, &target_addr), &sctx->node);
         }
-        struct isotp_fast_send_ctx *context;
-        int ret = get_send_ctx(ctx, target_addr, &context);
-        if (ret) {
-            return ISOTP_NO_NET_BUF_LEFT;
+        k_spin_unlock(&send_ctx_lock, key);
+        if (ret != 0) {
+            ret = ISOTP_NO_NET_BUF_LEFT;
+            goto err;
         }
-        context->data = data;
-        context->rem_len = len;
-        context->cb_arg = cb_arg;
 
-        k_work_submit(&context->work);
+        send_submit(sctx);
+        return ISOTP_N_OK;
     }
-    return ISOTP_N_OK;
+
+    k_spin_unlock(&send_ctx_lock, key);
+
+    uint8_t sf_data[CAN_MAX_DLEN];
+    if (buf != NULL) {
+        net_buf_linearize(sf_data, sizeof(sf_data), buf, 0, len);
+        net_buf_unref(buf);
+        data = sf_data;
+    }
+    ret = send_sf(ctx, data, len, &target_addr);
+    ctx->sent_callback(ret, cb_arg);
+    return ret;
+
+err:
+    if (buf != NULL) {
+        net_buf_unref(buf);
+    }
+    return ret;
+}
+
+int isotp_fast_send(struct isotp_fast_ctx *ctx, const uint8_t *data, size_t len,
+                    const struct isotp_fast_addr target_addr, void *cb_arg)
+{
+    return send_msg(ctx, data, NULL, len, target_addr, cb_arg);
+}
+
+int isotp_fast_send_buf(struct isotp_fast_ctx *ctx, struct net_buf *buf,
+                        const struct isotp_fast_addr target_addr, void *cb_arg)
+{
+    return send_msg(ctx, NULL, buf, net_buf_frags_len(buf), target_addr, cb_arg);
+}
+
+int isotp_fast_send_functional(struct isotp_fast_ctx *ctx, const uint8_t *data, size_t len,
+                               const struct isotp_fast_addr target_addr, void *cb_arg)
+{
+    int ret;
+
+    /* no flow control is possible with several receivers */
+    if (len > (CAN_MAX_DLEN - ISOTP_FAST_SF_LEN_BYTE)) {
+        return ISOTP_N_BUFFER_OVERFLW;
+    }
+
+    ret = send_sf(ctx, data, len, &target_addr);
+    ctx->sent_callback(ret, cb_arg);
+    return ret;
+}
+
+#ifdef CONFIG_ISOTP_FAST_RX_STATS
+void isotp_fast_get_rx_stats(const struct isotp_fast_ctx *ctx, struct isotp_fast_rx_stats *stats)
+{
+    *stats = ctx->rx_stats;
+}
+#endif
+
+#ifdef CONFIG_ISOTP_FAST_STMIN_STATS
+void isotp_fast_stmin_stats_get(struct isotp_fast_stmin_stats *stats)
+{
+    k_spinlock_key_t key = k_spin_lock(&stmin_stats_lock);
+
+    *stats = stmin_stats;
+    if (stmin_stats.count > 0) {
+        stats->mean_abs_dev_ns = stmin_stats_abs_dev_sum / stmin_stats.count;
+    }
+
+    k_spin_unlock(&stmin_stats_lock, key);
+}
+
+void isotp_fast_stmin_stats_reset(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&stmin_stats_lock);
+
+    memset(&stmin_stats, 0, sizeof(stmin_stats));
+    stmin_stats_abs_dev_sum = 0;
+
+    k_spin_unlock(&stmin_stats_lock, key);
 }
+#endif /* CONFIG_ISOTP_FAST_STMIN_STATS */
 
 #ifdef CONFIG_ISOTP_FAST_FIXED_ADDRESSING
 int isotp_fast_send_fixed(struct isotp_fast_ctx *ctx, const uint8_t *data, size_t len,
                           const uint8_t target_addr, void *cb_arg)
 {
+    /* address of a frame received from the target, to derive the reply address from */
     struct isotp_fast_addr rx_addr = ctx->rx_addr;
-    rx_addr.ext_id &= target_addr;
+    rx_addr.ext_id = (rx_addr.ext_id & ~ISOTP_FIXED_ADDR_SA_MASK)
+                     | (target_addr << ISOTP_FIXED_ADDR_SA_POS);
     struct isotp_fast_addr tx_addr = isotp_fast_get_tx_addr_fixed(&rx_addr);
     return isotp_fast_send(ctx, data, len, tx_addr, cb_arg);
 }
@@ -1146,3 +2184,20 @@ struct isotp_fast_addr isotp_fast_get_tx_addr_fixed(const struct isotp_fast_addr
     };
 }
 #endif
+
+#ifdef CONFIG_ISOTP_FAST_WORKQUEUE
+static int isotp_fast_init(void)
+{
+    k_work_queue_init(&isotp_fast_workq);
+    k_work_queue_start(&isotp_fast_workq, isotp_fast_workq_stack,
+                       K_THREAD_STACK_SIZEOF(isotp_fast_workq_stack),
+                       CONFIG_ISOTP_FAST_WORKQUEUE_PRIORITY, NULL);
+
+    k_thread_name_set(&isotp_fast_workq.thread, "isotp_fast");
+
+    return 0;
+}
+
+/* must be started before contexts are bound during application init */
+SYS_INIT(isotp_fast_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+#endif
@@ -6,6 +6,7 @@
 
 #include "isotp_internal.h"
 #include <canbus/isotp_fast.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/sys/slist.h>
 
 #ifdef CONFIG_ISOTP_FAST_PER_FRAME_DISPATCH
@@ -15,31 +16,72 @@
 #define ISOTP_FAST_RECEIVE_QUEUE
 #endif
 
+/* the advertised block size is adapted to the free receive buffers or ring slots */
+#if defined(CONFIG_ISOTP_FAST_RX_BACKPRESSURE) || defined(ISOTP_FAST_RECEIVE_QUEUE)
+#define ISOTP_FAST_RX_ADAPTIVE_BS
+#endif
+
 #ifdef CONFIG_CAN_FD_MODE
 #define ISOTP_FAST_SF_LEN_BYTE 2
 #else
 #define ISOTP_FAST_SF_LEN_BYTE 1
 #endif
 
-#define ISOTP_FAST_MAX_LEN 4095
+/* max. length encoded in the 12-bit FF_DL, larger messages use the 32-bit escape sequence */
+#define ISOTP_FAST_FF_DL_12BIT_MAX 4095
+
+#define ISOTP_FAST_MAX_LEN CONFIG_ISOTP_FAST_MAX_MSG_LEN
 
 #define ISOTP_4BIT_SF_MAX_CAN_DL 8
 
+#ifdef ISOTP_FAST_RECEIVE_QUEUE
+/**
+ * Single-producer/single-consumer ring of received fragments. Fragments are added from the CAN
+ * RX callback and taken by the receive work item (per-frame dispatch) or the thread blocking
+ * in isotp_fast_recv(), so no lock is needed. The indices run freely and are masked on access.
+ */
+struct isotp_fast_rx_ring
+{
+    atomic_t head; /**< next slot to write, only modified by the producer */
+    atomic_t tail; /**< next slot to read, only modified by the consumer */
+    struct net_buf *bufs[CONFIG_ISOTP_FAST_RX_RING_SIZE];
+};
+#endif
+
+#if CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH > 0
+/**
+ * Message waiting for the transfer of a previous message to the same
+ * recipient to finish.
+ */
+struct isotp_fast_send_req
+{
+    sys_snode_t node;     /**< node in the queue of the send context */
+    const uint8_t *data;  /**< source message buffer */
+    struct net_buf *buf;  /**< owned source buffer chain, or NULL */
+    uint32_t len;         /**< length of the message */
+    void *cb_arg;         /**< supplied to sent_callback */
+};
+#endif
+
 /**
  * Internal send context. Used to manage the transmission of a single
- * message greater than 1 CAN frame in size.
+ * message greater than 1 CAN frame in size, followed by further messages
+ * queued for the same recipient.
  */
 struct isotp_fast_send_ctx
 {
-    sys_snode_t node;               /**< linked list node in @ref isotp_send_ctx_list */
+    sys_snode_t node;               /**< node in @ref isotp_send_ctx_buckets */
     struct isotp_fast_ctx *ctx;     /**< pointer to bound context */
     struct isotp_fast_addr tx_addr; /**< Address used on sent message frames */
     struct k_work work;
-    struct k_timer timer;          /**< handles timeouts */
-    struct k_sem sem;              /**< used to ensure CF frames are sent in order */
-    const uint8_t *data;           /**< source message buffer */
-    uint16_t rem_len : 12;         /**< length of buffer; max len 4095 */
-    enum isotp_tx_state state : 8; /**< current state of context */
+    struct k_timer timer;              /**< paces consecutive frames according to STmin */
+    struct isotp_fast_timeout timeout; /**< N_Bs timeout while waiting for FC frames */
+    struct k_sem sem;                  /**< used to ensure CF frames are sent in order */
+    const uint8_t *data;               /**< source message buffer */
+    struct net_buf *buf;               /**< owned source buffer chain, or NULL */
+    struct net_buf *frag;              /**< fragment of @ref buf containing @ref data */
+    uint32_t rem_len;                  /**< remaining length of buffer */
+    enum isotp_tx_state state : 8;     /**< current state of context */
     int8_t error;
     void *cb_arg; /**< supplied to sent_callback */
     uint8_t wft;
@@ -47,6 +89,21 @@ struct isotp_fast_send_ctx
     uint8_t sn : 4; /**< sequence number; overflows at 4 bits per spec */
     uint8_t backlog;
     uint8_t stmin;
+#ifdef CONFIG_ISOTP_FAST_TX_PIPELINE
+    atomic_t inflight;    /**< frames handed to the CAN controller but not yet confirmed */
+    atomic_t fill_req;    /**< pending requests to refill the pipeline, serialises refills */
+    int64_t nas_deadline; /**< uptime in ms to give up waiting for a TX mailbox, 0 if unset */
+#endif
+#ifdef CONFIG_ISOTP_FAST_STMIN_COUNTER
+    int8_t counter_chan; /**< alarm channel used for STmin, or -1 if none is assigned */
+#endif
+#ifdef CONFIG_ISOTP_FAST_STMIN_STATS
+    uint32_t st_start; /**< cycle count at the start of the current separation time */
+#endif
+#if CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH > 0
+    sys_slist_t queue; /**< messages to be sent after the current one */
+    uint8_t queued;    /**< number of messages in @ref queue */
+#endif
 };
 
 /**
@@ -55,18 +112,21 @@ struct isotp_fast_send_ctx
  */
 struct isotp_fast_recv_ctx
 {
-    sys_snode_t node;               /**< linked list node in @ref isotp_recv_ctx_list */
+    sys_snode_t node;               /**< node in @ref isotp_recv_ctx_buckets */
     struct isotp_fast_ctx *ctx;     /**< pointer to bound context */
     struct isotp_fast_addr rx_addr; /**< Address on received frames */
     struct k_work work;
-    struct k_timer timer;   /**< handles timeouts */
-    struct net_buf *buffer; /**< head node of buffer */
-    struct net_buf *frag;   /**< current fragment */
+    struct isotp_fast_timeout timeout; /**< handles timeouts */
+    struct net_buf *buffer;            /**< head node of buffer */
+    struct net_buf *frag;              /**< current fragment */
 #ifdef ISOTP_FAST_RECEIVE_QUEUE
-    struct k_msgq recv_queue;
-    uint8_t recv_queue_pool[sizeof(struct net_buf *) * CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT];
+    struct isotp_fast_rx_ring ring; /**< fragments not yet dispatched */
 #endif
-    uint16_t rem_len : 12;         /**< remaining length of incoming message */
+#ifdef CONFIG_ISOTP_FAST_BLOCKING_RECEIVE
+    struct k_sem ring_sem; /**< wakes up the blocked receiver */
+    atomic_t ring_waiting; /**< set while the receiver waits for the ring to fill */
+#endif
+    uint32_t rem_len;              /**< remaining length of incoming message */
     enum isotp_rx_state state : 8; /**< current state of context */
     int8_t error;
     uint8_t wft;
@@ -75,6 +135,13 @@ struct isotp_fast_recv_ctx
 #ifdef ISOTP_FAST_RECEIVE_QUEUE
     bool pending;
 #endif
+#ifdef CONFIG_ISOTP_FAST_RX_BACKPRESSURE
+    uint32_t reserved; /**< buffers reserved for the remaining frames of the current block */
+    uint16_t wait_ms;  /**< time since the last FC.WAIT frame */
+#endif
+#ifdef ISOTP_FAST_RX_ADAPTIVE_BS
+    uint8_t bs_adv; /**< block size advertised in the last CTS frame */
+#endif
 };
 
 #ifdef CONFIG_ISOTP_FAST_BLOCKING_RECEIVE
@@ -87,6 +154,146 @@ struct isotp_fast_recv_await_ctx
 };
 #endif
 
+#ifdef ISOTP_FAST_RECEIVE_QUEUE
+#define ISOTP_FAST_RX_RING_MASK (CONFIG_ISOTP_FAST_RX_RING_SIZE - 1)
+
+static inline void isotp_fast_rx_ring_init(struct isotp_fast_rx_ring *ring)
+{
+    atomic_set(&ring->head, 0);
+    atomic_set(&ring->tail, 0);
+}
+
+/**
+ * Number of slots which can be filled by the producer without overflowing the ring.
+ */
+static inline uint32_t isotp_fast_rx_ring_free(struct isotp_fast_rx_ring *ring)
+{
+    return CONFIG_ISOTP_FAST_RX_RING_SIZE
+           - (uint32_t)(atomic_get(&ring->head) - atomic_get(&ring->tail));
+}
+
+/**
+ * Adds a fragment to the ring. Must only be called by the producer.
+ *
+ * @returns false if the ring is full
+ */
+static inline bool isotp_fast_rx_ring_put(struct isotp_fast_rx_ring *ring, struct net_buf *buf)
+{
+    atomic_val_t head = atomic_get(&ring->head);
+
+    if ((uint32_t)(head - atomic_get(&ring->tail)) >= CONFIG_ISOTP_FAST_RX_RING_SIZE) {
+        return false;
+    }
+
+    ring->bufs[head & ISOTP_FAST_RX_RING_MASK] = buf;
+    /* publish the slot only after it was written */
+    atomic_set(&ring->head, head + 1);
+    return true;
+}
+
+/**
+ * Takes the oldest fragment from the ring. Must only be called by the consumer.
+ *
+ * @returns the fragment or NULL if the ring is empty
+ */
+static inline struct net_buf *isotp_fast_rx_ring_get(struct isotp_fast_rx_ring *ring)
+{
+    atomic_val_t tail = atomic_get(&ring->tail);
+
+    if (tail == atomic_get(&ring->head)) {
+        return NULL;
+    }
+
+    struct net_buf *buf = ring->bufs[tail & ISOTP_FAST_RX_RING_MASK];
+    /* release the slot only after it was read */
+    atomic_set(&ring->tail, tail + 1);
+    return buf;
+}
+#endif /* ISOTP_FAST_RECEIVE_QUEUE */
+
+/**
+ * Determines whether two @ref isotp_fast_addr structures are equal.
+ */
+static inline bool isotp_fast_addr_equal(const struct isotp_fast_addr *left,
+                                         const struct isotp_fast_addr *right)
+{
+#ifdef CONFIG_ISOTP_FAST_EXTENDED_ADDRESSING
+    return left->ext_id == right->ext_id && left->ext_addr == right->ext_addr;
+#else
+    return left->ext_id == right->ext_id;
+#endif
+}
+
+/**
+ * Maps an address to a bucket of the context hash tables.
+ *
+ * All bytes of the CAN ID are folded into the hash, so the byte that differs between peers
+ * (e.g. the source address of received frames or the target address of sent frames in fixed
+ * or custom addressing mode) always spreads the contexts over the buckets.
+ */
+static inline uint32_t isotp_fast_addr_hash(const struct isotp_fast_addr *addr)
+{
+    uint32_t id = addr->ext_id;
+    uint32_t hash = id ^ (id >> 8) ^ (id >> 16) ^ (id >> 24);
+
+#ifdef CONFIG_ISOTP_FAST_EXTENDED_ADDRESSING
+    hash ^= addr->ext_addr;
+#endif
+    return (hash & 0xFF) % CONFIG_ISOTP_FAST_CTX_HASH_BUCKETS;
+}
+
+static inline sys_slist_t *isotp_fast_send_bucket(struct isotp_fast_ctx *ctx,
+                                                  const struct isotp_fast_addr *tx_addr)
+{
+    return &ctx->isotp_send_ctx_buckets[isotp_fast_addr_hash(tx_addr)];
+}
+
+static inline sys_slist_t *isotp_fast_recv_bucket(struct isotp_fast_ctx *ctx,
+                                                  const struct isotp_fast_addr *rx_addr)
+{
+    return &ctx->isotp_recv_ctx_buckets[isotp_fast_addr_hash(rx_addr)];
+}
+
+/**
+ * Looks up the in-flight send context for the given recipient.
+ *
+ * @returns the context or NULL if there is no transmission to this recipient
+ */
+static inline struct isotp_fast_send_ctx *
+isotp_fast_find_send_ctx(struct isotp_fast_ctx *ctx, const struct isotp_fast_addr *tx_addr)
+{
+    struct isotp_fast_send_ctx *sctx;
+
+    SYS_SLIST_FOR_EACH_CONTAINER(isotp_fast_send_bucket(ctx, tx_addr), sctx, node)
+    {
+        if (isotp_fast_addr_equal(&sctx->tx_addr, tx_addr)) {
+            return sctx;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Looks up the in-flight receive context for the given sender.
+ *
+ * @returns the context or NULL if there is no reception from this sender
+ */
+static inline struct isotp_fast_recv_ctx *
+isotp_fast_find_recv_ctx(struct isotp_fast_ctx *ctx, const struct isotp_fast_addr *rx_addr)
+{
+    struct isotp_fast_recv_ctx *rctx;
+
+    SYS_SLIST_FOR_EACH_CONTAINER(isotp_fast_recv_bucket(ctx, rx_addr), rctx, node)
+    {
+        if (isotp_fast_addr_equal(&rctx->rx_addr, rx_addr)) {
+            return rctx;
+        }
+    }
+
+    return NULL;
+}
+
 #ifdef CONFIG_ISOTP_FAST_FIXED_ADDRESSING
 
 /**
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) The ThingSet Project Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <canbus/isotp_fast.h>
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/dlist.h>
+
+/*
+ * Two-level hashed timer wheel. Timeouts due within WHEEL_SLOTS ticks are kept in level 0 in
+ * the slot of their expiry tick. Later ones are kept in level 1, where each slot covers a block
+ * of WHEEL_SLOTS ticks, and are moved to level 0 when the wheel enters their block. Timeouts
+ * beyond the range of level 1 are put back into the same slot until their block is reached.
+ *
+ * Starting, restarting and stopping a timeout are constant time operations, so restarting the
+ * N_Cr timeout for every received frame is cheap compared to reprogramming a kernel timer. The
+ * kernel timer only runs while timeouts are pending.
+ */
+
+#define WHEEL_BITS  4
+#define WHEEL_SLOTS BIT(WHEEL_BITS)
+#define WHEEL_MASK  (WHEEL_SLOTS - 1)
+
+static void wheel_tick(struct k_timer *timer);
+
+static K_TIMER_DEFINE(wheel_timer, wheel_tick, NULL);
+
+/* protects the slots, as timeouts are started from interrupt and thread context */
+static struct k_spinlock wheel_lock;
+
+static sys_dlist_t wheel_slots[2][WHEEL_SLOTS];
+
+/* current tick */
+static uint32_t wheel_now;
+
+/* number of pending timeouts */
+static uint32_t wheel_armed;
+
+static void wheel_insert(struct isotp_fast_timeout *timeout)
+{
+    uint32_t delta = timeout->expiry - wheel_now;
+    sys_dlist_t *slot;
+
+    if (delta < WHEEL_SLOTS) {
+        slot = &wheel_slots[0][timeout->expiry & WHEEL_MASK];
+    }
+    else {
+        slot = &wheel_slots[1][(timeout->expiry >> WHEEL_BITS) & WHEEL_MASK];
+    }
+
+    sys_dlist_append(slot, &timeout->node);
+}
+
+static void wheel_cascade(void)
+{
+    sys_dlist_t *slot = &wheel_slots[1][(wheel_now >> WHEEL_BITS) & WHEEL_MASK];
+    sys_dlist_t pending;
+    sys_dnode_t *node;
+
+    /* detach the slot first, as timeouts still too far ahead are added to it again */
+    sys_dlist_init(&pending);
+    while ((node = sys_dlist_get(slot)) != NULL) {
+        sys_dlist_append(&pending, node);
+    }
+
+    while ((node = sys_dlist_get(&pending)) != NULL) {
+        wheel_insert(CONTAINER_OF(node, struct isotp_fast_timeout, node));
+    }
+}
+
+static void wheel_tick(struct k_timer *timer)
+{
+    k_spinlock_key_t key = k_spin_lock(&wheel_lock);
+    sys_dnode_t *node;
+
+    wheel_now++;
+    if ((wheel_now & WHEEL_MASK) == 0) {
+        wheel_cascade();
+    }
+
+    /* timeouts started by the handlers expire at least one tick later, so not in this slot */
+    while ((node = sys_dlist_get(&wheel_slots[0][wheel_now & WHEEL_MASK])) != NULL) {
+        struct isotp_fast_timeout *timeout = CONTAINER_OF(node, struct isotp_fast_timeout, node);
+
+        wheel_armed--;
+        k_spin_unlock(&wheel_lock, key);
+        timeout->handler(timeout);
+        key = k_spin_lock(&wheel_lock);
+    }
+
+    if (wheel_armed == 0) {
+        k_timer_stop(&wheel_timer);
+    }
+
+    k_spin_unlock(&wheel_lock, key);
+}
+
+void isotp_fast_timeout_init(struct isotp_fast_timeout *timeout,
+                             isotp_fast_timeout_handler_t handler)
+{
+    sys_dnode_init(&timeout->node);
+    timeout->handler = handler;
+}
+
+void isotp_fast_timeout_start(struct isotp_fast_timeout *timeout, uint32_t ms)
+{
+    /* the current tick may end right away, so one more is needed to never expire early */
+    uint32_t ticks = DIV_ROUND_UP(ms, CONFIG_ISOTP_FAST_TIMER_WHEEL_TICK_MS) + 1;
+    k_spinlock_key_t key = k_spin_lock(&wheel_lock);
+
+    if (sys_dnode_is_linked(&timeout->node)) {
+        sys_dlist_remove(&timeout->node);
+    }
+    else if (wheel_armed++ == 0) {
+        k_timer_start(&wheel_timer, K_MSEC(CONFIG_ISOTP_FAST_TIMER_WHEEL_TICK_MS),
+                      K_MSEC(CONFIG_ISOTP_FAST_TIMER_WHEEL_TICK_MS));
+    }
+
+    timeout->expiry = wheel_now + ticks;
+    wheel_insert(timeout);
+
+    k_spin_unlock(&wheel_lock, key);
+}
+
+void isotp_fast_timeout_stop(struct isotp_fast_timeout *timeout)
+{
+    k_spinlock_key_t key = k_spin_lock(&wheel_lock);
+
+    if (sys_dnode_is_linked(&timeout->node)) {
+        sys_dlist_remove(&timeout->node);
+        if (--wheel_armed == 0) {
+            k_timer_stop(&wheel_timer);
+        }
+    }
+
+    k_spin_unlock(&wheel_lock, key);
+}
+
+static int isotp_fast_timeout_sys_init(void)
+{
+    for (int level = 0; level < ARRAY_SIZE(wheel_slots); level++) {
+        for (int i = 0; i < WHEEL_SLOTS; i++) {
+            sys_dlist_init(&wheel_slots[level][i]);
+        }
+    }
+
+    return 0;
+}
+
+/* timeouts are only started once contexts were bound during application init */
+SYS_INIT(isotp_fast_timeout_sys_init, PRE_KERNEL_1, 0);
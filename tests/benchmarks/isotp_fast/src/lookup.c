@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) The ThingSet Project Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "isotp_fast_internal.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+#define MAX_PEERS         64
+#define LOOKUP_ITERATIONS 1000
+
+/* fixed addressing with target address 0xAA and varying source address */
+#define PEER_ADDR(i) (0x18DAAA00 | ((i) + 1))
+
+/* context list as used before the hash table was introduced, for comparison */
+struct linear_entry
+{
+    sys_snode_t node;
+    struct isotp_fast_addr rx_addr;
+};
+
+static struct isotp_fast_ctx ctx;
+static struct isotp_fast_recv_ctx rctx[MAX_PEERS];
+static struct linear_entry linear_entries[MAX_PEERS];
+static sys_slist_t linear_list;
+
+static void populate(int num_peers)
+{
+    for (int i = 0; i < CONFIG_ISOTP_FAST_CTX_HASH_BUCKETS; i++) {
+        sys_slist_init(&ctx.isotp_recv_ctx_buckets[i]);
+    }
+    sys_slist_init(&linear_list);
+
+    for (int i = 0; i < num_peers; i++) {
+        rctx[i].ctx = &ctx;
+        rctx[i].rx_addr.ext_id = PEER_ADDR(i);
+        sys_slist_append(isotp_fast_recv_bucket(&ctx, &rctx[i].rx_addr), &rctx[i].node);
+
+        linear_entries[i].rx_addr.ext_id = PEER_ADDR(i);
+        sys_slist_append(&linear_list, &linear_entries[i].node);
+    }
+}
+
+static struct linear_entry *find_linear(const struct isotp_fast_addr *rx_addr)
+{
+    struct linear_entry *entry;
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&linear_list, entry, node)
+    {
+        if (isotp_fast_addr_equal(&entry->rx_addr, rx_addr)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/* returns average time per lookup in ns */
+static uint32_t measure_lookup(int num_peers, bool hashed)
+{
+    volatile void *found;
+    uint32_t start = k_cycle_get_32();
+
+    for (int n = 0; n < LOOKUP_ITERATIONS; n++) {
+        for (int i = 0; i < num_peers; i++) {
+            struct isotp_fast_addr addr = { .ext_id = PEER_ADDR(i) };
+            if (hashed) {
+                found = isotp_fast_find_recv_ctx(&ctx, &addr);
+            }
+            else {
+                found = find_linear(&addr);
+            }
+        }
+    }
+
+    uint32_t cycles = k_cycle_get_32() - start;
+    ARG_UNUSED(found);
+
+    return k_cyc_to_ns_floor64(cycles) / (LOOKUP_ITERATIONS * num_peers);
+}
+
+ZTEST(isotp_fast_lookup, test_lookup_correctness)
+{
+    struct isotp_fast_addr unknown = { .ext_id = PEER_ADDR(MAX_PEERS) };
+
+    populate(MAX_PEERS);
+
+    for (int i = 0; i < MAX_PEERS; i++) {
+        zassert_equal_ptr(isotp_fast_find_recv_ctx(&ctx, &rctx[i].rx_addr), &rctx[i],
+                          "Wrong context for peer %d", i);
+    }
+    zassert_is_null(isotp_fast_find_recv_ctx(&ctx, &unknown), "Found context for unknown peer");
+}
+
+ZTEST(isotp_fast_lookup, test_lookup_scaling)
+{
+    static const int peer_counts[] = { 1, 4, 16, 32, MAX_PEERS };
+
+    TC_PRINT("%d hash buckets, %d lookups per peer\n", CONFIG_ISOTP_FAST_CTX_HASH_BUCKETS,
+             LOOKUP_ITERATIONS);
+
+    for (int i = 0; i < ARRAY_SIZE(peer_counts); i++) {
+        populate(peer_counts[i]);
+        uint32_t hashed_ns = measure_lookup(peer_counts[i], true);
+        uint32_t linear_ns = measure_lookup(peer_counts[i], false);
+        TC_PRINT("peers: %2d, hashed: %4u ns, linear list: %4u ns per lookup\n", peer_counts[i],
+                 hashed_ns, linear_ns);
+    }
+}
+
+ZTEST_SUITE(isotp_fast_lookup, NULL, NULL, NULL, NULL, NULL);
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) The ThingSet Project Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <canbus/isotp_fast.h>
+
+#include <zephyr/drivers/can.h>
+#include <zephyr/kernel.h>
+#include <zephyr/net/buf.h>
+#include <zephyr/ztest.h>
+
+/*
+ * Sweeps message size, block size, STmin and number of concurrent peers. Each peer sends its
+ * next message as soon as the previous one was received completely.
+ *
+ * Results are printed as one JSON object per line (prefixed with "{\"bench\"") so they can be
+ * extracted from the test log and compared across releases.
+ */
+
+#define MAX_PEERS          4
+#define MAX_MSGS_PER_PEER  32
+#define BYTES_PER_PEER     16384
+#define MAX_MSG_LEN        4096
+#define POINT_TIMEOUT_MS   30000
+#define RECEIVER_NODE_ADDR 0x10
+#define PEER_NODE_ADDR(i)  (0x20 + (i))
+
+/* fixed addressing with 29-bit IDs: TA in bits 8-15, SA in bits 0-7 */
+#define FIXED_ID(ta, sa)                                                                           \
+    (0x18DA0000 | ((ta) << ISOTP_FIXED_ADDR_TA_POS) | ((sa) << ISOTP_FIXED_ADDR_SA_POS))
+
+static const struct device *const can_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_canbus));
+
+static const uint16_t msg_sizes[] = { 8, 64, 512, 1024, MAX_MSG_LEN };
+static const uint8_t block_sizes[] = { 0, 8 };
+static const uint8_t stmins[] = { 0, 1 };
+static const uint8_t peer_counts[] = { 1, 2, MAX_PEERS };
+
+static struct isotp_fast_opts opts = {
+    .addressing_mode = ISOTP_FAST_ADDRESSING_MODE_FIXED,
+#ifdef CONFIG_CAN_FD_MODE
+    .flags = ISOTP_MSG_FDF,
+#endif
+};
+
+static struct isotp_fast_ctx receiver;
+static struct isotp_fast_ctx peers[MAX_PEERS];
+
+static uint8_t tx_data[MAX_MSG_LEN];
+
+static int counter_filter_id;
+
+static K_SEM_DEFINE(point_done_sem, 0, 1);
+static atomic_t peers_active;
+static atomic_t errors;
+static atomic_t frame_count;
+
+static size_t msg_len;
+static int msgs_per_peer;
+static int sent_count[MAX_PEERS];
+static uint32_t send_start[MAX_PEERS];
+static uint32_t latencies[MAX_PEERS * MAX_MSGS_PER_PEER];
+static int latency_count;
+static int pool_peak;
+
+static void sample_pool_usage(void)
+{
+#ifdef CONFIG_NET_BUF_POOL_USAGE
+    int used = 0;
+
+    STRUCT_SECTION_FOREACH(net_buf_pool, pool)
+    {
+        used += pool->buf_count - atomic_get(&pool->avail_count);
+    }
+    pool_peak = MAX(pool_peak, used);
+#endif
+}
+
+/* counts all frames on the bus, including flow control frames */
+static void frame_counter_callback(const struct device *dev, struct can_frame *frame, void *arg)
+{
+    atomic_inc(&frame_count);
+    sample_pool_usage();
+}
+
+static void point_abort(void)
+{
+    atomic_inc(&errors);
+    k_sem_give(&point_done_sem);
+}
+
+static void send_next(int peer)
+{
+    send_start[peer] = k_cycle_get_32();
+    int ret = isotp_fast_send_fixed(&peers[peer], tx_data, msg_len, RECEIVER_NODE_ADDR, NULL);
+    if (ret != ISOTP_N_OK) {
+        point_abort();
+    }
+}
+
+static void recv_handler(struct net_buf *buffer, int rem_len, struct isotp_fast_addr addr,
+                         void *arg)
+{
+    int peer = (addr.ext_id & ISOTP_FIXED_ADDR_SA_MASK) - PEER_NODE_ADDR(0);
+
+    sample_pool_usage();
+
+    if (peer < 0 || peer >= MAX_PEERS || net_buf_frags_len(buffer) != msg_len) {
+        point_abort();
+        return;
+    }
+
+    latencies[latency_count++] = k_cycle_get_32() - send_start[peer];
+
+    if (++sent_count[peer] < msgs_per_peer) {
+        send_next(peer);
+    }
+    else if (atomic_dec(&peers_active) == 1) {
+        k_sem_give(&point_done_sem);
+    }
+}
+
+static void recv_error_handler(int8_t error, struct isotp_fast_addr addr, void *arg)
+{
+    point_abort();
+}
+
+static void sent_handler(int result, void *arg)
+{
+    if (result != ISOTP_N_OK) {
+        point_abort();
+    }
+}
+
+static uint32_t percentile_us(int percent)
+{
+    int index = MIN(latency_count * percent / 100, latency_count - 1);
+
+    return k_cyc_to_us_floor32(latencies[index]);
+}
+
+static void sort_latencies(void)
+{
+    for (int i = 1; i < latency_count; i++) {
+        uint32_t val = latencies[i];
+        int j = i - 1;
+        while (j >= 0 && latencies[j] > val) {
+            latencies[j + 1] = latencies[j];
+            j--;
+        }
+        latencies[j + 1] = val;
+    }
+}
+
+static void run_point(size_t len, uint8_t bs, uint8_t stmin, int num_peers)
+{
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+    k_thread_runtime_stats_t rt_start, rt_end;
+#endif
+    uint64_t cycles_per_frame = 0;
+    int ret;
+
+    opts.bs = bs;
+    opts.stmin = stmin;
+    msg_len = len;
+    msgs_per_peer = CLAMP(BYTES_PER_PEER / len, 4, MAX_MSGS_PER_PEER);
+
+    ret = isotp_fast_bind(&receiver, can_dev,
+                          (struct isotp_fast_addr){ .ext_id = FIXED_ID(RECEIVER_NODE_ADDR, 0) },
+                          &opts, recv_handler, NULL, recv_error_handler, sent_handler);
+    zassert_equal(ret, ISOTP_N_OK, "Binding receiver failed (%d)", ret);
+
+    for (int i = 0; i < num_peers; i++) {
+        ret = isotp_fast_bind(&peers[i], can_dev,
+                              (struct isotp_fast_addr){ .ext_id = FIXED_ID(PEER_NODE_ADDR(i), 0) },
+                              &opts, recv_handler, NULL, recv_error_handler, sent_handler);
+        zassert_equal(ret, ISOTP_N_OK, "Binding peer %d failed (%d)", i, ret);
+        sent_count[i] = 0;
+    }
+
+    k_sem_reset(&point_done_sem);
+    atomic_set(&peers_active, num_peers);
+    atomic_set(&errors, 0);
+    atomic_set(&frame_count, 0);
+    latency_count = 0;
+    pool_peak = 0;
+
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+    k_thread_runtime_stats_all_get(&rt_start);
+#endif
+    uint32_t start = k_cycle_get_32();
+
+    for (int i = 0; i < num_peers; i++) {
+        send_next(i);
+    }
+
+    ret = k_sem_take(&point_done_sem, K_MSEC(POINT_TIMEOUT_MS));
+    uint32_t duration_us = MAX(k_cyc_to_us_floor64(k_cycle_get_32() - start), 1);
+
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+    k_thread_runtime_stats_all_get(&rt_end);
+#endif
+
+    /* let the senders finish their last transfer before the contexts are unbound */
+    k_sleep(K_MSEC(10));
+
+    for (int i = 0; i < num_peers; i++) {
+        isotp_fast_unbind(&peers[i]);
+    }
+    isotp_fast_unbind(&receiver);
+
+    zassert_equal(ret, 0, "Timeout for size %zu, bs %u, stmin %u, peers %d", len, bs, stmin,
+                  num_peers);
+    zassert_equal(atomic_get(&errors), 0, "Errors for size %zu, bs %u, stmin %u, peers %d", len,
+                  bs, stmin, num_peers);
+
+    uint32_t frames = atomic_get(&frame_count);
+    uint64_t total_bytes = (uint64_t)len * msgs_per_peer * num_peers;
+
+#ifdef CONFIG_THREAD_RUNTIME_STATS
+    cycles_per_frame = (rt_end.total_cycles - rt_start.total_cycles) / MAX(frames, 1);
+#endif
+
+    sort_latencies();
+
+    TC_PRINT("{\"bench\":\"isotp_fast\",\"fd\":%d,\"pipeline\":%d,\"size\":%zu,\"bs\":%u,"
+             "\"stmin\":%u,\"peers\":%d,\"msgs\":%d,\"bytes_per_s\":%u,\"frames_per_s\":%u,"
+             "\"lat_p50_us\":%u,\"lat_p90_us\":%u,\"lat_p99_us\":%u,\"lat_max_us\":%u,"
+             "\"pool_peak\":%d,\"cycles_per_frame\":%u}\n",
+             IS_ENABLED(CONFIG_CAN_FD_MODE), IS_ENABLED(CONFIG_ISOTP_FAST_TX_PIPELINE), len, bs,
+             stmin, num_peers, msgs_per_peer * num_peers,
+             (uint32_t)(total_bytes * USEC_PER_SEC / duration_us),
+             (uint32_t)((uint64_t)frames * USEC_PER_SEC / duration_us), percentile_us(50),
+             percentile_us(90), percentile_us(99), percentile_us(100), pool_peak,
+             (uint32_t)cycles_per_frame);
+}
+
+static void *sweep_setup(void)
+{
+    can_mode_t mode = CAN_MODE_LOOPBACK;
+
+#ifdef CONFIG_CAN_FD_MODE
+    mode |= CAN_MODE_FD;
+#endif
+
+    zassert_true(device_is_ready(can_dev), "CAN device not ready");
+    zassert_equal(can_set_mode(can_dev, mode), 0, "Failed to set loopback mode");
+
+    for (int i = 0; i < sizeof(tx_data); i++) {
+        tx_data[i] = i & 0xFF;
+    }
+
+    return NULL;
+}
+
+static void sweep_before(void *fixture)
+{
+    const struct can_filter all_frames = {
+        .id = 0,
+        .mask = 0,
+        .flags = CAN_FILTER_IDE,
+    };
+
+    zassert_equal(can_start(can_dev), 0, "Failed to start CAN controller");
+
+    counter_filter_id = can_add_rx_filter(can_dev, frame_counter_callback, NULL, &all_frames);
+    zassert_true(counter_filter_id >= 0, "Failed to add frame counter filter");
+}
+
+static void sweep_after(void *fixture)
+{
+    can_remove_rx_filter(can_dev, counter_filter_id);
+    can_stop(can_dev);
+}
+
+ZTEST(isotp_fast_sweep, test_sweep)
+{
+    for (int s = 0; s < ARRAY_SIZE(msg_sizes); s++) {
+        for (int b = 0; b < ARRAY_SIZE(block_sizes); b++) {
+            for (int t = 0; t < ARRAY_SIZE(stmins); t++) {
+                for (int p = 0; p < ARRAY_SIZE(peer_counts); p++) {
+                    run_point(msg_sizes[s], block_sizes[b], stmins[t], peer_counts[p]);
+                }
+            }
+        }
+    }
+}
+
+ZTEST_SUITE(isotp_fast_sweep, NULL, sweep_setup, sweep_before, sweep_after, NULL);
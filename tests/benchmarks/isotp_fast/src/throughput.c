@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) The ThingSet Project Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <canbus/isotp_fast.h>
+
+#include <zephyr/drivers/can.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+#define MSG_LEN             4000
+#define TRANSFERS           10
+#define PROBE_INTERVAL_MS   1
+#define TRANSFER_TIMEOUT_MS 5000
+
+/* sender has node address 0x01, receiver 0x02 (fixed addressing) */
+#define SENDER_RX_ID   0x18DA0100
+#define RECEIVER_RX_ID 0x18DA0200
+#define RECEIVER_ADDR  0x02
+
+static const struct device *const can_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_canbus));
+
+/* no block size and STmin, so the sender is only limited by its send engine */
+static const struct isotp_fast_opts opts = {
+    .bs = 0,
+    .stmin = 0,
+    .addressing_mode = ISOTP_FAST_ADDRESSING_MODE_FIXED,
+};
+
+static struct isotp_fast_ctx sender;
+static struct isotp_fast_ctx receiver;
+
+static uint8_t tx_data[MSG_LEN];
+
+static K_SEM_DEFINE(sent_sem, 0, 1);
+static K_SEM_DEFINE(recv_sem, 0, 1);
+static volatile int sent_result;
+static volatile size_t recv_len;
+
+/* the probe measures how long the system work queue is unavailable during a transfer */
+static struct k_work probe_work;
+static struct k_timer probe_timer;
+static uint32_t probe_submitted;
+static uint32_t probe_max_latency;
+
+static void probe_work_handler(struct k_work *work)
+{
+    uint32_t latency = k_cycle_get_32() - probe_submitted;
+
+    probe_max_latency = MAX(probe_max_latency, latency);
+}
+
+static void probe_timer_handler(struct k_timer *timer)
+{
+    if (!k_work_is_pending(&probe_work)) {
+        probe_submitted = k_cycle_get_32();
+        k_work_submit(&probe_work);
+    }
+}
+
+static void recv_handler(struct net_buf *buffer, int rem_len, struct isotp_fast_addr addr,
+                         void *arg)
+{
+    recv_len = net_buf_frags_len(buffer);
+    k_sem_give(&recv_sem);
+}
+
+static void recv_error_handler(int8_t error, struct isotp_fast_addr addr, void *arg)
+{
+    recv_len = 0;
+    k_sem_give(&recv_sem);
+}
+
+static void sent_handler(int result, void *arg)
+{
+    sent_result = result;
+    k_sem_give(&sent_sem);
+}
+
+static void *throughput_setup(void)
+{
+    zassert_true(device_is_ready(can_dev), "CAN device not ready");
+    zassert_equal(can_set_mode(can_dev, CAN_MODE_LOOPBACK), 0, "Failed to set loopback mode");
+
+    for (int i = 0; i < sizeof(tx_data); i++) {
+        tx_data[i] = i & 0xFF;
+    }
+
+    k_work_init(&probe_work, probe_work_handler);
+    k_timer_init(&probe_timer, probe_timer_handler, NULL);
+
+    return NULL;
+}
+
+static void throughput_before(void *fixture)
+{
+    zassert_equal(can_start(can_dev), 0, "Failed to start CAN controller");
+
+    isotp_fast_bind(&sender, can_dev, (struct isotp_fast_addr){ .ext_id = SENDER_RX_ID }, &opts,
+                    recv_handler, NULL, recv_error_handler, sent_handler);
+    isotp_fast_bind(&receiver, can_dev, (struct isotp_fast_addr){ .ext_id = RECEIVER_RX_ID },
+                    &opts, recv_handler, NULL, recv_error_handler, sent_handler);
+}
+
+static void throughput_after(void *fixture)
+{
+    isotp_fast_unbind(&sender);
+    isotp_fast_unbind(&receiver);
+    can_stop(can_dev);
+}
+
+ZTEST(isotp_fast_throughput, test_throughput)
+{
+    uint64_t total_cycles = 0;
+    int ret;
+
+    probe_max_latency = 0;
+    k_timer_start(&probe_timer, K_MSEC(PROBE_INTERVAL_MS), K_MSEC(PROBE_INTERVAL_MS));
+
+    for (int i = 0; i < TRANSFERS; i++) {
+        k_sem_reset(&sent_sem);
+        k_sem_reset(&recv_sem);
+
+        uint32_t start = k_cycle_get_32();
+        ret = isotp_fast_send_fixed(&sender, tx_data, sizeof(tx_data), RECEIVER_ADDR, NULL);
+        zassert_equal(ret, ISOTP_N_OK, "Send failed (%d)", ret);
+
+        ret = k_sem_take(&recv_sem, K_MSEC(TRANSFER_TIMEOUT_MS));
+        total_cycles += k_cycle_get_32() - start;
+        zassert_equal(ret, 0, "Message not received");
+        zassert_equal(recv_len, sizeof(tx_data), "Received %zu bytes", recv_len);
+
+        ret = k_sem_take(&sent_sem, K_MSEC(TRANSFER_TIMEOUT_MS));
+        zassert_equal(ret, 0, "Send not completed");
+        zassert_equal(sent_result, ISOTP_N_OK, "Send failed (%d)", sent_result);
+    }
+
+    k_timer_stop(&probe_timer);
+
+    uint32_t total_us = MAX(k_cyc_to_us_floor64(total_cycles), 1);
+    uint32_t rate = (uint64_t)TRANSFERS * MSG_LEN * USEC_PER_SEC / total_us;
+
+    TC_PRINT("engine: %s (%s work queue), %d x %d bytes in %u us: %u bytes/s, "
+             "max. system work queue latency: %u us\n",
+             IS_ENABLED(CONFIG_ISOTP_FAST_TX_PIPELINE) ? "pipelined" : "blocking",
+             IS_ENABLED(CONFIG_ISOTP_FAST_WORKQUEUE) ? "dedicated" : "system", TRANSFERS, MSG_LEN,
+             total_us, rate, (uint32_t)k_cyc_to_us_floor64(probe_max_latency));
+}
+
+ZTEST_SUITE(isotp_fast_throughput, NULL, throughput_setup, throughput_before, throughput_after,
+            NULL);
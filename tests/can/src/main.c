@@ -28,7 +28,7 @@ static uint8_t item_value_buf[8];
 static size_t item_value_len;
 
 static struct k_sem report_rx_sem;
-static uint8_t report_buf[100];
+static uint8_t report_buf[200];
 static size_t report_len;
 
 /* test data objects */
@@ -108,6 +108,61 @@ ZTEST(thingset_can, test_receive_item_from_node)
     zassert_equal(item_value_buf[0], 0xF6);
 }
 
+ZTEST(thingset_can, test_receive_subscribed_items)
+{
+    struct can_frame rx_frame = {
+        .flags = CAN_FRAME_IDE,
+        .data = { 0xF6 },
+        .dlc = 1,
+    };
+    /* ID of data item, source address and whether it is expected to be received */
+    const struct
+    {
+        uint16_t data_id;
+        uint8_t source_addr;
+        bool received;
+    } items[] = {
+        { 0x1234, 0x02, true },  { 0x1235, 0x02, false }, { 0x1234, 0x03, false },
+        { 0x5000, 0x03, true },  { 0x50FF, 0x04, true },  { 0x5100, 0x04, false },
+        { 0x4FFF, 0x04, false },
+    };
+    int err;
+
+    err = thingset_can_subscribe_items(0x02, 0x1234, 0x1234);
+    zassert_equal(err, 0, "subscription failed: %d", err);
+    err = thingset_can_subscribe_items(THINGSET_CAN_ADDR_BROADCAST, 0x5000, 0x50FF);
+    zassert_equal(err, 0, "subscription failed: %d", err);
+
+    for (int i = 0; i < ARRAY_SIZE(items); i++) {
+        k_sem_reset(&item_rx_sem);
+
+        rx_frame.id = THINGSET_CAN_TYPE_SF_REPORT | THINGSET_CAN_PRIO_REPORT_LOW
+                      | THINGSET_CAN_DATA_ID_SET(items[i].data_id)
+                      | THINGSET_CAN_SOURCE_SET(items[i].source_addr);
+        err = can_send(can_dev, &rx_frame, K_MSEC(10), NULL, NULL);
+        zassert_equal(err, 0, "can_send failed: %d", err);
+
+        err = k_sem_take(&item_rx_sem, TEST_RECEIVE_TIMEOUT);
+        if (items[i].received) {
+            zassert_equal(err, 0, "item %x from %x not received", items[i].data_id,
+                          items[i].source_addr);
+            zassert_equal(item_data_id, items[i].data_id, "wrong data object ID");
+        }
+        else {
+            zassert_not_equal(err, 0, "item %x from %x received", items[i].data_id,
+                              items[i].source_addr);
+        }
+    }
+
+    /* restore reception of all items for the other tests */
+    err = thingset_can_unsubscribe_items(0x02, 0x1234, 0x1234);
+    zassert_equal(err, 0, "unsubscription failed: %d", err);
+    err = thingset_can_unsubscribe_items(THINGSET_CAN_ADDR_BROADCAST, 0x5000, 0x50FF);
+    zassert_equal(err, 0, "unsubscription failed: %d", err);
+    err = thingset_can_unsubscribe_items(0x02, 0x1234, 0x1234);
+    zassert_equal(err, -ENOENT, "unsubscription of unknown range succeeded");
+}
+
 ZTEST(thingset_can, test_receive_packetized_report)
 {
     /* "hello world" */
@@ -144,7 +199,123 @@ ZTEST(thingset_can, test_receive_packetized_report)
     zassert_mem_equal(report_buf, report_exp, sizeof(report_exp));
 }
 
-CAN_MSGQ_DEFINE(report_packets_msgq, 10);
+ZTEST(thingset_can, test_receive_chunked_report)
+{
+    struct thingset_can_report_rx_stats stats_before, stats;
+    struct can_frame frame = {
+        .flags = CAN_FRAME_IDE,
+        .dlc = 8,
+    };
+    uint8_t report_exp[96];
+    int num_frames = sizeof(report_exp) / 8;
+    int err;
+
+    for (int i = 0; i < sizeof(report_exp); i++) {
+        report_exp[i] = i;
+    }
+
+    thingset_can_get_report_rx_stats(&stats_before);
+    k_sem_reset(&report_rx_sem);
+
+    /* report exceeds a single chunk of the reassembly pool */
+    for (int i = 0; i < num_frames; i++) {
+        uint32_t mf_type = (i == 0)                ? THINGSET_CAN_MF_TYPE_FIRST
+                           : (i == num_frames - 1) ? THINGSET_CAN_MF_TYPE_LAST
+                                                   : THINGSET_CAN_MF_TYPE_CONSEC;
+        frame.id = 0x1D000003 | mf_type | THINGSET_CAN_SEQ_NO_SET(i & 0xF);
+        memcpy(frame.data, &report_exp[i * 8], 8);
+        err = can_send(can_dev, &frame, K_MSEC(10), NULL, NULL);
+        zassert_equal(err, 0, "can_send failed: %d", err);
+    }
+
+    err = k_sem_take(&report_rx_sem, TEST_RECEIVE_TIMEOUT);
+    zassert_equal(err, 0, "receive timeout");
+    zassert_equal(report_len, sizeof(report_exp), "wrong report len %d (expected %d)", report_len,
+                  sizeof(report_exp));
+    zassert_mem_equal(report_buf, report_exp, sizeof(report_exp));
+
+    /* consecutive frame without first frame from another node */
+    frame.id = 0x1D001104;
+    err = can_send(can_dev, &frame, K_MSEC(10), NULL, NULL);
+    zassert_equal(err, 0, "can_send failed: %d", err);
+
+    err = k_sem_take(&report_rx_sem, TEST_RECEIVE_TIMEOUT);
+    zassert_not_equal(err, 0, "incomplete report dispatched");
+
+    thingset_can_get_report_rx_stats(&stats);
+    zassert_equal(stats.dropped_seq, stats_before.dropped_seq + 1);
+    zassert_equal(stats.dropped_no_buf, stats_before.dropped_no_buf);
+    zassert_equal(stats.dropped_too_large, stats_before.dropped_too_large);
+}
+
+static void send_report_frames(uint8_t source_addr, const uint8_t *data, int first, int count,
+                               int total)
+{
+    struct can_frame frame = {
+        .flags = CAN_FRAME_IDE,
+        .dlc = 8,
+    };
+    int err;
+
+    for (int i = first; i < first + count; i++) {
+        uint32_t mf_type = (i == 0)           ? THINGSET_CAN_MF_TYPE_FIRST
+                           : (i == total - 1) ? THINGSET_CAN_MF_TYPE_LAST
+                                              : THINGSET_CAN_MF_TYPE_CONSEC;
+        frame.id = 0x1D000000 | mf_type | THINGSET_CAN_SEQ_NO_SET(i & 0xF)
+                   | THINGSET_CAN_SOURCE_SET(source_addr);
+        memcpy(frame.data, &data[i * 8], 8);
+        err = can_send(can_dev, &frame, K_MSEC(10), NULL, NULL);
+        zassert_equal(err, 0, "can_send failed: %d", err);
+    }
+}
+
+ZTEST(thingset_can, test_receive_report_evict_stale)
+{
+    const int chunk_frames = CONFIG_THINGSET_CAN_REPORT_RX_BUFFER_SIZE / 8;
+    /* the active report fills two chunks and needs a third one for its last frame */
+    const int active_frames = 2 * chunk_frames + 1;
+    /* the stale report occupies all remaining chunks */
+    const int stale_frames = (CONFIG_THINGSET_CAN_REPORT_RX_NUM_BUFFERS - 2) * chunk_frames;
+    struct thingset_can_report_rx_stats stats_before, stats;
+    static uint8_t report_exp[(2 * CONFIG_THINGSET_CAN_REPORT_RX_BUFFER_SIZE) + 8];
+    int err;
+
+    for (int i = 0; i < sizeof(report_exp); i++) {
+        report_exp[i] = i;
+    }
+
+    thingset_can_get_report_rx_stats(&stats_before);
+    k_sem_reset(&report_rx_sem);
+
+    send_report_frames(0x05, report_exp, 0, active_frames - 1, active_frames);
+    send_report_frames(0x06, report_exp, 0, stale_frames, stale_frames + 1);
+
+    /* both senders pause until their reassemblies are considered stale */
+    k_sleep(K_MSEC(CONFIG_THINGSET_CAN_REPORT_RX_TIMEOUT + 50));
+
+    /* the pool is exhausted, so the chunk for the last frame is taken from the other sender */
+    send_report_frames(0x05, report_exp, active_frames - 1, 1, active_frames);
+
+    err = k_sem_take(&report_rx_sem, TEST_RECEIVE_TIMEOUT);
+    zassert_equal(err, 0, "active report not received");
+    zassert_equal(report_len, sizeof(report_exp), "wrong report len %d (expected %d)", report_len,
+                  sizeof(report_exp));
+    zassert_mem_equal(report_buf, report_exp, sizeof(report_exp));
+
+    thingset_can_get_report_rx_stats(&stats);
+    zassert_equal(stats.evicted, stats_before.evicted + 1, "stale report not evicted");
+    zassert_equal(stats.dropped_no_buf, stats_before.dropped_no_buf);
+
+    /* the evicted report cannot be continued */
+    send_report_frames(0x06, report_exp, stale_frames, 1, stale_frames + 1);
+    err = k_sem_take(&report_rx_sem, TEST_RECEIVE_TIMEOUT);
+    zassert_not_equal(err, 0, "evicted report dispatched");
+
+    thingset_can_get_report_rx_stats(&stats);
+    zassert_equal(stats.dropped_seq, stats_before.dropped_seq + 1);
+}
+
+CAN_MSGQ_DEFINE(report_packets_msgq, 32);
 
 ZTEST(thingset_can, test_send_packetized_report)
 {
@@ -190,6 +361,110 @@ ZTEST(thingset_can, test_send_packetized_report)
     can_remove_rx_filter(can_dev, filter_id);
 }
 
+#ifdef CONFIG_THINGSET_CAN_REPORT_TX_QUEUE
+ZTEST(thingset_can, test_send_queued_reports)
+{
+    const size_t report_len = strlen("#Test {\"wFloat\":1234.6,\"wString\":\"Hello World!\"}");
+    const int num_reports = 3;
+    struct can_filter rx_filter = {
+        .id = 0x1D000000,
+        .mask = 0x1F000000,
+        .flags = CAN_FILTER_IDE,
+    };
+    struct can_frame rx_frame;
+    int err;
+
+    k_msgq_purge(&report_packets_msgq);
+
+    int filter_id = can_add_rx_filter_msgq(can_dev, &report_packets_msgq, &rx_filter);
+    zassert_false(filter_id < 0, "adding rx filter failed: %d", filter_id);
+
+    struct thingset_can *ctx = thingset_can_get_inst();
+    ctx->msg_no = 0;
+
+    /* reports are queued without waiting for the previous one to be sent */
+    for (int i = 0; i < num_reports; i++) {
+        err = thingset_can_send_report("Test", THINGSET_TXT_NAMES_VALUES);
+        zassert_equal(err, 0, "sending report %d failed: %d", i, err);
+    }
+
+    for (uint32_t msg_no = 0; msg_no < num_reports; msg_no++) {
+        for (uint32_t seq = 0; seq * CAN_MAX_DLEN < report_len; seq++) {
+            err = k_msgq_get(&report_packets_msgq, &rx_frame, K_MSEC(100));
+            zassert_equal(err, 0, "receiving CAN frame %d of msg %d timed out", seq, msg_no);
+            zassert_equal(THINGSET_CAN_MSG_NO_GET(rx_frame.id), msg_no & 0x3,
+                          "CAN ID 0x%x for seq %d of msg %d not correct", rx_frame.id, seq, msg_no);
+            zassert_equal(THINGSET_CAN_SEQ_NO_GET(rx_frame.id), seq,
+                          "CAN ID 0x%x for seq %d of msg %d not correct", rx_frame.id, seq, msg_no);
+        }
+    }
+
+    can_remove_rx_filter(can_dev, filter_id);
+}
+#endif
+
+#ifdef CONFIG_THINGSET_CAN_CONTROL_ON_CHANGE
+CAN_MSGQ_DEFINE(control_frames_msgq, 4);
+
+ZTEST(thingset_can, test_send_control_on_change)
+{
+    const int period = CONFIG_THINGSET_CAN_CONTROL_REPORTING_PERIOD;
+    const uint16_t max_interval = 5 * period;
+    struct can_filter rx_filter = {
+        .id = THINGSET_CAN_TYPE_SF_REPORT | THINGSET_CAN_PRIO_REPORT_LOW
+              | THINGSET_CAN_DATA_ID_SET(0x201) | THINGSET_CAN_SOURCE_SET(0x01),
+        .mask = CAN_EXT_ID_MASK,
+        .flags = CAN_FILTER_IDE,
+    };
+    struct can_frame rx_frame;
+    uint8_t initial_data[CAN_MAX_DLEN];
+    float initial = test_float;
+    int err;
+
+    err = thingset_can_set_control_params(0x201, 1.0F, 0, max_interval);
+    zassert_equal(err, 0, "setting control params failed: %d", err);
+    err = thingset_can_set_control_params(0x202, 1.0F, 0, max_interval);
+    zassert_equal(err, -ENOENT, "item exceeding a single frame is in the control plan");
+
+    k_msgq_purge(&control_frames_msgq);
+
+    int filter_id = can_add_rx_filter_msgq(can_dev, &control_frames_msgq, &rx_filter);
+    zassert_false(filter_id < 0, "adding rx filter failed: %d", filter_id);
+
+    live_reporting_enable = true;
+
+    /* the first report is sent regardless of the deadband */
+    err = k_msgq_get(&control_frames_msgq, &rx_frame, K_MSEC(2 * period));
+    zassert_equal(err, 0, "initial control frame not sent");
+    memcpy(initial_data, rx_frame.data, sizeof(initial_data));
+
+    /* change within deadband is suppressed */
+    test_float = initial + 0.5F;
+    err = k_msgq_get(&control_frames_msgq, &rx_frame, K_MSEC(3 * period));
+    zassert_not_equal(err, 0, "change within deadband was published");
+
+    /* change exceeding the deadband is published with the next period */
+    test_float = initial + 2.0F;
+    err = k_msgq_get(&control_frames_msgq, &rx_frame, K_MSEC(2 * period));
+    zassert_equal(err, 0, "change exceeding deadband not published");
+    zassert_true(memcmp(rx_frame.data, initial_data, sizeof(initial_data)) != 0,
+                 "changed value not published");
+
+    /* unchanged value is refreshed after max. interval, but not earlier */
+    err = k_msgq_get(&control_frames_msgq, &rx_frame, K_MSEC(max_interval - period));
+    zassert_not_equal(err, 0, "unchanged value published before max. interval");
+    err = k_msgq_get(&control_frames_msgq, &rx_frame, K_MSEC(3 * period));
+    zassert_equal(err, 0, "unchanged value not published after max. interval");
+
+    live_reporting_enable = false;
+    can_remove_rx_filter(can_dev, filter_id);
+
+    /* restore default parameters and value for the other tests */
+    thingset_can_update_control_plan();
+    test_float = initial;
+}
+#endif
+
 static void request_rx_cb(const struct device *dev, struct can_frame *frame, void *user_data)
 {
     k_sem_give(&request_tx_sem);
@@ -218,6 +493,60 @@ ZTEST(thingset_can, test_send_request_to_node)
     can_remove_rx_filter(can_dev, filter_id);
 }
 
+static struct k_sem transaction_sem;
+static atomic_t transaction_results[2];
+
+static void transaction_callback(uint8_t *data, size_t len, int send_err, int recv_err,
+                                 uint8_t source_addr, void *arg)
+{
+    atomic_t *result = arg;
+
+    atomic_set(result, (data != NULL) ? source_addr : recv_err);
+    k_sem_give(&transaction_sem);
+}
+
+ZTEST(thingset_can, test_concurrent_requests)
+{
+    uint8_t req_buf[] = { 0x01, 0x00 }; /* simple single-frame request via ISO-TP */
+    /* single-frame response from node 0xDD to this node (0x01) */
+    struct can_frame resp_frame = {
+        .id = 0x180001DD,
+        .flags = CAN_FRAME_IDE,
+        .data = { 0x02, 0x85, 0xF6 },
+        .dlc = 3,
+    };
+    int err;
+
+    k_sem_init(&transaction_sem, 0, 2);
+    atomic_set(&transaction_results[0], 0);
+    atomic_set(&transaction_results[1], 0);
+
+    /* both requests are pending at the same time, so the second one must not block */
+    int64_t start = k_uptime_get();
+    err = thingset_can_send(req_buf, sizeof(req_buf), 0xCC, 0x0, transaction_callback,
+                            &transaction_results[0], K_MSEC(200));
+    zassert_equal(err, 0, "sending request to 0xCC failed: %d", err);
+    err = thingset_can_send(req_buf, sizeof(req_buf), 0xDD, 0x0, transaction_callback,
+                            &transaction_results[1], K_MSEC(200));
+    zassert_equal(err, 0, "sending request to 0xDD failed: %d", err);
+    zassert_true(k_uptime_get() - start < 100, "second request was blocked");
+
+    err = can_send(can_dev, &resp_frame, K_MSEC(100), NULL, NULL);
+    zassert_equal(err, 0, "sending response failed: %d", err);
+
+    err = k_sem_take(&transaction_sem, TEST_RECEIVE_TIMEOUT);
+    zassert_equal(err, 0, "response callback not invoked");
+    zassert_equal(atomic_get(&transaction_results[1]), 0xDD, "unexpected result for 0xDD");
+
+    /* the remaining request is cancelled before it times out */
+    zassert_equal(thingset_can_cancel_request(0xCC, 0x0), 0, "cancel failed");
+    zassert_equal(thingset_can_cancel_request(0xCC, 0x0), -ENOENT, "cancelled twice");
+
+    err = k_sem_take(&transaction_sem, K_MSEC(300));
+    zassert_not_equal(err, 0, "callback of cancelled request invoked");
+    zassert_equal(atomic_get(&transaction_results[0]), 0, "unexpected result for 0xCC");
+}
+
 ZTEST(thingset_can, test_request_response)
 {
     k_sem_reset(&request_tx_sem);
@@ -255,6 +584,118 @@ ZTEST(thingset_can, test_request_response)
     isotp_fast_unbind(&client_ctx);
 }
 
+ZTEST(thingset_can, test_broadcast_request_response)
+{
+    k_sem_reset(&request_tx_sem);
+    k_sem_reset(&response_rx_sem);
+
+    struct isotp_fast_ctx client_ctx = {
+        .get_tx_addr_callback = get_tx_addr_callback,
+    };
+    struct isotp_fast_opts opts = {
+        .bs = 0,
+        .stmin = 0,
+        .flags = 0,
+        .addressing_mode = ISOTP_FAST_ADDRESSING_MODE_CUSTOM,
+    };
+    struct isotp_fast_addr rx_addr = { .ext_id = 0x1800cc00 };
+    int err = isotp_fast_bind(&client_ctx, can_dev, rx_addr, &opts, isotp_fast_recv_cb, NULL, NULL,
+                              isotp_fast_sent_cb);
+    zassert_equal(err, 0, "bind fail");
+
+    /* GET CAN node address from all nodes */
+    uint8_t msg[] = { 0x01, 0x19, TS_ID_NET_CAN_NODE_ADDR >> 8, TS_ID_NET_CAN_NODE_ADDR & 0xFF };
+    struct isotp_fast_addr tx_addr = { .ext_id = 0x1800ffcc };
+    err = isotp_fast_send_functional(&client_ctx, msg, sizeof(msg), tx_addr, NULL);
+    zassert_equal(err, 0, "send fail");
+    k_sem_take(&request_tx_sem, TEST_RECEIVE_TIMEOUT);
+
+    err = k_sem_take(&response_rx_sem, TEST_RECEIVE_TIMEOUT);
+    zassert_equal(err, 0, "receive timeout");
+
+    /* the only node on the bus responds from its node address 0x01 */
+    uint8_t resp_exp[] = { 0x85, 0xF6, 0x01 };
+    zassert_equal(response_len, 3, "unexpected response length %d", response_len);
+    zassert_mem_equal(response, resp_exp, sizeof(resp_exp), "unexpected response");
+    free(response);
+    isotp_fast_unbind(&client_ctx);
+}
+
+static struct k_sem broadcast_sem;
+static ATOMIC_DEFINE(broadcast_sources, THINGSET_CAN_ADDR_BROADCAST + 1);
+static atomic_t broadcast_finished;
+static atomic_t broadcast_late_responses;
+static int broadcast_err;
+
+static void broadcast_callback(uint8_t *data, size_t len, int send_err, int recv_err,
+                               uint8_t source_addr, void *arg)
+{
+    if (data != NULL) {
+        if (atomic_get(&broadcast_finished) > 0) {
+            atomic_inc(&broadcast_late_responses);
+        }
+        atomic_set_bit(broadcast_sources, source_addr);
+    }
+    else {
+        broadcast_err = (send_err != 0) ? send_err : recv_err;
+        atomic_inc(&broadcast_finished);
+        k_sem_give(&broadcast_sem);
+    }
+}
+
+ZTEST(thingset_can, test_send_broadcast)
+{
+    /* GET CAN node address from all nodes */
+    uint8_t req_buf[] = { 0x01, 0x19, TS_ID_NET_CAN_NODE_ADDR >> 8, TS_ID_NET_CAN_NODE_ADDR & 0xFF };
+    /* single-frame responses from other nodes to this node (0x01) */
+    struct can_frame resp_frame = {
+        .flags = CAN_FRAME_IDE,
+        .data = { 0x02, 0x85, 0xF6 },
+        .dlc = 3,
+    };
+    const uint8_t responders[] = { 0xDD, 0xEE };
+    int err;
+
+    k_sem_init(&broadcast_sem, 0, 1);
+    for (int i = 0; i < ARRAY_SIZE(broadcast_sources); i++) {
+        atomic_clear(&broadcast_sources[i]);
+    }
+    atomic_clear(&broadcast_finished);
+    atomic_clear(&broadcast_late_responses);
+
+    err = thingset_can_send_broadcast(req_buf, sizeof(req_buf), 0x0, broadcast_callback, NULL,
+                                      K_MSEC(200));
+    zassert_equal(err, 0, "sending broadcast request failed: %d", err);
+
+    for (int i = 0; i < ARRAY_SIZE(responders); i++) {
+        resp_frame.id = 0x18000100 | responders[i];
+        err = can_send(can_dev, &resp_frame, K_MSEC(100), NULL, NULL);
+        zassert_equal(err, 0, "sending response failed: %d", err);
+    }
+
+    /* responses are collected until the timeout expires */
+    err = k_sem_take(&broadcast_sem, K_MSEC(100));
+    zassert_not_equal(err, 0, "collection finished before the timeout");
+
+    err = k_sem_take(&broadcast_sem, K_MSEC(200));
+    zassert_equal(err, 0, "final callback not invoked");
+    zassert_equal(broadcast_err, -ETIMEDOUT, "unexpected final error %d", broadcast_err);
+    for (int i = 0; i < ARRAY_SIZE(responders); i++) {
+        zassert_true(atomic_test_bit(broadcast_sources, responders[i]),
+                     "response from 0x%X not delivered", responders[i]);
+    }
+
+    /* responses after the end of the collection are not delivered anymore */
+    resp_frame.id = 0x18000100 | responders[0];
+    err = can_send(can_dev, &resp_frame, K_MSEC(100), NULL, NULL);
+    zassert_equal(err, 0, "sending response failed: %d", err);
+    k_sleep(K_MSEC(50));
+
+    zassert_equal(atomic_get(&broadcast_late_responses), 0, "response delivered after timeout");
+    zassert_equal(atomic_get(&broadcast_finished), 1, "final callback invoked %d times",
+                  (int)atomic_get(&broadcast_finished));
+}
+
 static void *thingset_can_setup(void)
 {
     int err;
@@ -259,6 +259,31 @@ ZTEST(isotp_fast_conformance, test_send_sf_fixed)
     check_frame_series(&des_frame, 1, &frame_msgq);
 }
 
+ZTEST(isotp_fast_conformance, test_send_sf_fixed_target)
+{
+    int ret;
+    struct frame_desired des_frame;
+
+#ifdef CONFIG_CAN_FD_MODE
+    des_frame.data[0] = (SF_PCI_TYPE << PCI_TYPE_POS);
+    des_frame.data[1] = DATA_SIZE_SF;
+#else
+    des_frame.data[0] = SF_PCI_BYTE_1;
+#endif
+    memcpy(&des_frame.data[SF_LEN_BYTE], random_data, DATA_SIZE_SF);
+    des_frame.length = CAN_MAX_DLEN;
+
+    /* exact match: target address in TA field, own address (TA of rx_addr) in SA field */
+    filter_id = add_rx_msgq((tx_can_id & ~0xFF00) | (EXT_ADDR << 8), CAN_EXT_ID_MASK);
+    zassert_true((filter_id >= 0), "Negative filter number [%d]", filter_id);
+
+    ret = isotp_fast_send_fixed(&ctx, random_data, DATA_SIZE_SF, EXT_ADDR,
+                                INT_TO_POINTER(ISOTP_N_OK));
+    zassert_equal(ret, 0, "Send returned %d", ret);
+
+    check_frame_series(&des_frame, 1, &frame_msgq);
+}
+
 ZTEST(isotp_fast_conformance, test_receive_sf_fixed)
 {
     struct frame_desired single_frame;
@@ -321,6 +346,126 @@ ZTEST(isotp_fast_conformance, test_send_data)
     check_frame_series(des_frames, ARRAY_SIZE(des_frames), &frame_msgq);
 }
 
+#if CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH > 0
+ZTEST(isotp_fast_conformance, test_send_queued)
+{
+    struct frame_desired fc_frame, ff_frame;
+    struct frame_desired frames[ARRAY_SIZE(des_frames) + CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH];
+    int ret;
+
+    ff_frame.data[0] = FF_PCI_BYTE_1(DATA_SEND_LENGTH);
+    ff_frame.data[1] = FF_PCI_BYTE_2(DATA_SEND_LENGTH);
+    memcpy(&ff_frame.data[2], random_data, DATA_SIZE_FF);
+    ff_frame.length = CAN_DL;
+
+    fc_frame.data[0] = FC_PCI_BYTE_1(FC_PCI_CTS);
+    fc_frame.data[1] = FC_PCI_BYTE_2(0);
+    fc_frame.data[2] = FC_PCI_BYTE_3(0);
+    fc_frame.length = DATA_SIZE_FC;
+
+    prepare_cf_frames(des_frames, ARRAY_SIZE(des_frames), random_data + DATA_SIZE_FF,
+                      DATA_SEND_LENGTH - DATA_SIZE_FF);
+    memcpy(frames, des_frames, sizeof(des_frames));
+
+    /* queued single frames follow the consecutive frames in order */
+    for (int i = 0; i < CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH; i++) {
+        struct frame_desired *sf_frame = &frames[ARRAY_SIZE(des_frames) + i];
+#ifdef CONFIG_CAN_FD_MODE
+        sf_frame->data[0] = (SF_PCI_TYPE << PCI_TYPE_POS);
+        sf_frame->data[1] = DATA_SIZE_SF;
+#else
+        sf_frame->data[0] = SF_PCI_BYTE_1;
+#endif
+        memcpy(&sf_frame->data[SF_LEN_BYTE], random_data + i, DATA_SIZE_SF);
+        sf_frame->length = CAN_MAX_DLEN;
+    }
+
+    filter_id = add_rx_msgq(tx_can_id, CAN_EXT_ID_MASK);
+    zassert_true((filter_id >= 0), "Negative filter number [%d]", filter_id);
+
+    send_test_data(random_data, DATA_SEND_LENGTH);
+
+    for (int i = 0; i < CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH; i++) {
+        ret = isotp_fast_send(&ctx, random_data + i, DATA_SIZE_SF, tx_addr,
+                              INT_TO_POINTER(ISOTP_N_OK));
+        zassert_equal(ret, 0, "Queueing message %d returned %d", i, ret);
+    }
+
+    ret = isotp_fast_send(&ctx, random_data, DATA_SIZE_SF, tx_addr, INT_TO_POINTER(ISOTP_N_OK));
+    zassert_equal(ret, -EBUSY, "Sending to full queue returned %d", ret);
+
+    check_frame_series(&ff_frame, 1, &frame_msgq);
+
+    send_frame_series(&fc_frame, 1, rx_can_id);
+
+    check_frame_series(frames, ARRAY_SIZE(frames), &frame_msgq);
+}
+#endif /* CONFIG_ISOTP_FAST_TX_QUEUE_DEPTH > 0 */
+
+/* header, payload and trailer split at offsets not aligned to the frame boundaries */
+#define SEND_BUF_FRAG_1 5
+#define SEND_BUF_FRAG_2 100
+
+NET_BUF_POOL_DEFINE(send_buf_pool, 3, DATA_SEND_LENGTH, 0, NULL);
+
+ZTEST(isotp_fast_conformance, test_send_data_buf)
+{
+    struct frame_desired fc_frame, ff_frame;
+    struct net_buf *buf, *frag;
+    int ret;
+
+    ff_frame.data[0] = FF_PCI_BYTE_1(DATA_SEND_LENGTH);
+    ff_frame.data[1] = FF_PCI_BYTE_2(DATA_SEND_LENGTH);
+    memcpy(&ff_frame.data[2], random_data, DATA_SIZE_FF);
+    ff_frame.length = CAN_DL;
+
+    fc_frame.data[0] = FC_PCI_BYTE_1(FC_PCI_CTS);
+    fc_frame.data[1] = FC_PCI_BYTE_2(0);
+    fc_frame.data[2] = FC_PCI_BYTE_3(0);
+    fc_frame.length = DATA_SIZE_FC;
+
+    prepare_cf_frames(des_frames, ARRAY_SIZE(des_frames), random_data + DATA_SIZE_FF,
+                      DATA_SEND_LENGTH - DATA_SIZE_FF);
+
+    buf = net_buf_alloc(&send_buf_pool, K_NO_WAIT);
+    zassert_not_null(buf, "No buffer");
+    net_buf_add_mem(buf, random_data, SEND_BUF_FRAG_1);
+    frag = net_buf_alloc(&send_buf_pool, K_NO_WAIT);
+    zassert_not_null(frag, "No buffer");
+    net_buf_add_mem(frag, random_data + SEND_BUF_FRAG_1, SEND_BUF_FRAG_2);
+    net_buf_frag_add(buf, frag);
+    frag = net_buf_alloc(&send_buf_pool, K_NO_WAIT);
+    zassert_not_null(frag, "No buffer");
+    net_buf_add_mem(frag, random_data + SEND_BUF_FRAG_1 + SEND_BUF_FRAG_2,
+                    DATA_SEND_LENGTH - SEND_BUF_FRAG_1 - SEND_BUF_FRAG_2);
+    net_buf_frag_add(buf, frag);
+
+    filter_id = add_rx_msgq(tx_can_id, CAN_EXT_ID_MASK);
+    zassert_true((filter_id >= 0), "Negative filter number [%d]", filter_id);
+
+    k_sem_reset(&send_compl_sem);
+    ret = isotp_fast_send_buf(&ctx, buf, tx_addr, INT_TO_POINTER(ISOTP_N_OK));
+    zassert_equal(ret, 0, "Send returned %d", ret);
+
+    check_frame_series(&ff_frame, 1, &frame_msgq);
+
+    send_frame_series(&fc_frame, 1, rx_can_id);
+
+    check_frame_series(des_frames, ARRAY_SIZE(des_frames), &frame_msgq);
+
+    ret = k_sem_take(&send_compl_sem, K_MSEC(200));
+    zassert_equal(ret, 0, "Send complete callback not called");
+
+    /* all fragments must have been released after the transfer */
+    buf = NULL;
+    for (int i = 0; i < 3; i++) {
+        frag = net_buf_alloc(&send_buf_pool, K_MSEC(100));
+        zassert_not_null(frag, "Buffer %d not released", i);
+        buf = buf ? net_buf_frag_add(buf, frag) : frag;
+    }
+    net_buf_unref(buf);
+}
+
 /* hiding this whole test to avoid compiler errors */
 #ifndef CONFIG_CAN_FD_MODE
 ZTEST(isotp_fast_conformance, test_send_data_blocks)
@@ -605,6 +750,51 @@ ZTEST(isotp_fast_conformance, test_stmin)
     zassert_true(time_diff >= STMIN_VAL_2, "STmin too short (%dms)", time_diff);
 }
 
+#ifdef CONFIG_ISOTP_FAST_STMIN_STATS
+ZTEST(isotp_fast_conformance, test_stmin_us)
+{
+    int ret;
+    struct frame_desired fc_frame, ff_frame;
+    struct can_frame raw_frame;
+    struct isotp_fast_stmin_stats stats;
+
+    ff_frame.data[0] = FF_PCI_BYTE_1(DATA_SIZE_FF + DATA_SIZE_CF * 4);
+    ff_frame.data[1] = FF_PCI_BYTE_2(DATA_SIZE_FF + DATA_SIZE_CF * 4);
+    memcpy(&ff_frame.data[2], random_data, DATA_SIZE_FF);
+    ff_frame.length = DATA_SIZE_FF + 2;
+
+    fc_frame.data[0] = FC_PCI_BYTE_1(FC_PCI_CTS);
+    fc_frame.data[1] = FC_PCI_BYTE_2(0);
+    fc_frame.data[2] = FC_PCI_BYTE_3(STMIN_VAL_US);
+    fc_frame.length = DATA_SIZE_FC;
+
+    filter_id = add_rx_msgq(tx_can_id, CAN_EXT_ID_MASK);
+    zassert_true((filter_id >= 0), "Negative filter number [%d]", filter_id);
+
+    isotp_fast_stmin_stats_reset();
+    k_sem_reset(&send_compl_sem);
+    send_test_data(random_data, DATA_SIZE_FF + DATA_SIZE_CF * 4);
+
+    check_frame_series(&ff_frame, 1, &frame_msgq);
+
+    send_frame_series(&fc_frame, 1, rx_can_id);
+
+    for (int i = 0; i < 4; i++) {
+        ret = k_msgq_get(&frame_msgq, &raw_frame, K_MSEC(100));
+        zassert_equal(ret, 0, "Expected to get CF %d. [%d]", i, ret);
+    }
+
+    ret = k_sem_take(&send_compl_sem, K_MSEC(100));
+    zassert_equal(ret, 0, "Send complete callback not called");
+
+    isotp_fast_stmin_stats_get(&stats);
+    TC_PRINT("STmin deviation: min %d ns, max %d ns, mean abs. %u ns\n", stats.min_dev_ns,
+             stats.max_dev_ns, stats.mean_abs_dev_ns);
+    zassert_equal(stats.count, 3, "Expected 3 separation times but got %u", stats.count);
+    zassert_true(stats.min_dev_ns >= 0, "STmin too short (%d ns)", stats.min_dev_ns);
+}
+#endif /* CONFIG_ISOTP_FAST_STMIN_STATS */
+
 ZTEST(isotp_fast_conformance, test_receiver_fc_errors)
 {
     int ret;
@@ -675,12 +865,6 @@ ZTEST(isotp_fast_conformance, test_sender_fc_errors)
     zassert_equal(ret, 0, "Send complete callback not called");
 
     /* buffer overflow */
-    can_remove_rx_filter(can_dev, filter_id);
-
-    ret = isotp_fast_send(&ctx, random_data, 5 * 1024, tx_addr, NULL);
-    zassert_equal(ret, ISOTP_N_BUFFER_OVERFLW, "Expected overflow but got %d", ret);
-    filter_id = add_rx_msgq(tx_can_id, CAN_EXT_ID_MASK);
-
     k_sem_reset(&send_compl_sem);
     ret = isotp_fast_send(&ctx, random_data, DATA_SEND_LENGTH, tx_addr,
                           INT_TO_POINTER(ISOTP_N_BUFFER_OVERFLW));
@@ -706,6 +890,294 @@ ZTEST(isotp_fast_conformance, test_sender_fc_errors)
     zassert_equal(ret, 0, "Send complete callback not called");
 }
 
+ZTEST(isotp_fast_conformance, test_send_data_escape_ff)
+{
+    int ret;
+    struct frame_desired ff_frame, fc_frame;
+
+    ff_frame.data[0] = FF_PCI_BYTE_1(0);
+    ff_frame.data[1] = FF_PCI_BYTE_2(0);
+    sys_put_be32(DATA_SEND_LENGTH_ESC, &ff_frame.data[2]);
+    memcpy(&ff_frame.data[6], random_data, DATA_SIZE_FF_ESC);
+    ff_frame.length = DATA_SIZE_FF_ESC + 6;
+
+    fc_frame.data[0] = FC_PCI_BYTE_1(FC_PCI_OVFLW);
+    fc_frame.data[1] = FC_PCI_BYTE_2(fc_opts.bs);
+    fc_frame.data[2] = FC_PCI_BYTE_3(fc_opts.stmin);
+    fc_frame.length = DATA_SIZE_FC;
+
+    filter_id = add_rx_msgq(tx_can_id, CAN_EXT_ID_MASK);
+    zassert_true((filter_id >= 0), "Negative filter number [%d]", filter_id);
+
+    k_sem_reset(&send_compl_sem);
+    ret = isotp_fast_send(&ctx, random_data, DATA_SEND_LENGTH_ESC, tx_addr,
+                          INT_TO_POINTER(ISOTP_N_BUFFER_OVERFLW));
+    zassert_equal(ret, ISOTP_N_OK, "Send returned %d", ret);
+
+    check_frame_series(&ff_frame, 1, &frame_msgq);
+
+    /* abort the transfer, as the test data only covers the beginning of the message */
+    send_frame_series(&fc_frame, 1, rx_can_id);
+    ret = k_sem_take(&send_compl_sem, K_MSEC(200));
+    zassert_equal(ret, 0, "Send complete callback not called");
+}
+
+ZTEST(isotp_fast_conformance, test_receive_data_escape_ff)
+{
+    int ret;
+    struct frame_desired ff_frame, fc_frame, cf_frame;
+
+    ff_frame.data[0] = FF_PCI_BYTE_1(0);
+    ff_frame.data[1] = FF_PCI_BYTE_2(0);
+    sys_put_be32(DATA_SEND_LENGTH_ESC, &ff_frame.data[2]);
+    memcpy(&ff_frame.data[6], random_data, DATA_SIZE_FF_ESC);
+    ff_frame.length = DATA_SIZE_FF_ESC + 6;
+
+    fc_frame.data[0] = FC_PCI_BYTE_1(FC_PCI_CTS);
+    fc_frame.data[1] = FC_PCI_BYTE_2(fc_opts.bs);
+    fc_frame.data[2] = FC_PCI_BYTE_3(fc_opts.stmin);
+    fc_frame.length = DATA_SIZE_FC;
+
+    filter_id = add_rx_msgq(tx_can_id, CAN_EXT_ID_MASK);
+    zassert_true((filter_id >= 0), "Negative filter number [%d]", filter_id);
+
+    send_frame_series(&ff_frame, 1, rx_can_id);
+    check_frame_series(&fc_frame, 1, &frame_msgq);
+
+    uint8_t tiny_buf[CAN_MAX_DLEN];
+    ret = blocking_recv(tiny_buf, sizeof(tiny_buf), K_MSEC(200));
+    zassert_equal(ret, DATA_SIZE_FF_ESC, "Expected FF data length but got %d", ret);
+    ret = check_data(tiny_buf, random_data, DATA_SIZE_FF_ESC);
+    zassert_equal(ret, 0, "Data differ");
+
+    /* abort the transfer with a wrong sequence number (should be 1) */
+    cf_frame.data[0] = CF_PCI_BYTE_1 | 2;
+    memcpy(&cf_frame.data[1], random_data + DATA_SIZE_FF_ESC, DATA_SIZE_CF);
+    cf_frame.length = CAN_DL;
+    send_frame_series(&cf_frame, 1, rx_can_id);
+
+    ret = blocking_recv(data_buf, sizeof(data_buf), K_MSEC(200));
+    zassert_equal(ret, ISOTP_N_WRONG_SN, "Expected wrong SN but got %d", ret);
+}
+
+ZTEST(isotp_fast_conformance, test_max_msg_len)
+{
+    int ret;
+    struct frame_desired ff_frame, fc_frame;
+
+    filter_id = add_rx_msgq(tx_can_id, CAN_EXT_ID_MASK);
+    zassert_true((filter_id >= 0), "Negative filter number [%d]", filter_id);
+
+    /* data is not accessed, as the length is checked first */
+    ret = isotp_fast_send(&ctx, random_data, CONFIG_ISOTP_FAST_MAX_MSG_LEN + 1, tx_addr,
+                          INT_TO_POINTER(ISOTP_N_BUFFER_OVERFLW));
+    zassert_equal(ret, ISOTP_N_BUFFER_OVERFLW, "Send returned %d", ret);
+
+    check_frame_series(NULL, 0, &frame_msgq);
+
+    ff_frame.data[0] = FF_PCI_BYTE_1(0);
+    ff_frame.data[1] = FF_PCI_BYTE_2(0);
+    sys_put_be32(CONFIG_ISOTP_FAST_MAX_MSG_LEN + 1, &ff_frame.data[2]);
+    memcpy(&ff_frame.data[6], random_data, DATA_SIZE_FF_ESC);
+    ff_frame.length = DATA_SIZE_FF_ESC + 6;
+
+    fc_frame.data[0] = FC_PCI_BYTE_1(FC_PCI_OVFLW);
+    fc_frame.data[1] = FC_PCI_BYTE_2(fc_opts.bs);
+    fc_frame.data[2] = FC_PCI_BYTE_3(fc_opts.stmin);
+    fc_frame.length = DATA_SIZE_FC;
+
+    send_frame_series(&ff_frame, 1, rx_can_id);
+    check_frame_series(&fc_frame, 1, &frame_msgq);
+}
+
+#if defined(CONFIG_ISOTP_FAST_RX_BACKPRESSURE) && defined(CONFIG_ISOTP_FAST_BLOCKING_RECEIVE)
+static void check_fc(uint8_t fs, uint8_t bs)
+{
+    struct can_frame frame;
+    int ret;
+
+    ret = k_msgq_get(&frame_msgq, &frame, K_MSEC(100));
+    zassert_equal(ret, 0, "Expected FC frame [%d]", ret);
+    zassert_equal(frame.data[0], FC_PCI_BYTE_1(fs), "Expected FS %d but got PCI byte 0x%02x", fs,
+                  frame.data[0]);
+    if (fs == FC_PCI_CTS) {
+        zassert_equal(frame.data[1], bs, "Expected BS %d but got %d", bs, frame.data[1]);
+    }
+}
+
+ZTEST(isotp_fast_conformance, test_receive_backpressure)
+{
+    const int num_cf = CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT + 10;
+    const size_t len = DATA_SIZE_FF + DATA_SIZE_CF * num_cf;
+    struct frame_desired ff_frame, cf_frame;
+    struct isotp_fast_rx_stats stats;
+    int queued = 1; /* FF */
+    int sn = 1;
+    int ret;
+
+    if (sizeof(random_data) < len) {
+        ztest_test_skip();
+    }
+
+    ff_frame.data[0] = FF_PCI_BYTE_1(len);
+    ff_frame.data[1] = FF_PCI_BYTE_2(len);
+    memcpy(&ff_frame.data[2], random_data, DATA_SIZE_FF);
+    ff_frame.length = DATA_SIZE_FF + 2;
+
+    filter_id = add_rx_msgq(tx_can_id, CAN_EXT_ID_MASK);
+    zassert_true((filter_id >= 0), "Negative filter number [%d]", filter_id);
+
+    send_frame_series(&ff_frame, 1, rx_can_id);
+
+    /* nothing is read, so the BS is reduced once the receive queue runs full, then WAIT is sent */
+    while (queued < CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT) {
+        int bs = MIN(fc_opts.bs, CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT - queued);
+
+        check_fc(FC_PCI_CTS, bs);
+        for (int i = 0; i < bs; i++, sn++) {
+            cf_frame.data[0] = CF_PCI_BYTE_1 | (sn & 0x0F);
+            memcpy(&cf_frame.data[1], random_data + DATA_SIZE_FF + (sn - 1) * DATA_SIZE_CF,
+                   DATA_SIZE_CF);
+            cf_frame.length = CAN_DL;
+            send_frame_series(&cf_frame, 1, rx_can_id);
+        }
+        queued += bs;
+    }
+    check_fc(FC_PCI_WAIT, 0);
+
+    isotp_fast_get_rx_stats(&ctx, &stats);
+    zassert_equal(stats.wait_frames, 1, "Expected 1 WAIT frame but got %u", stats.wait_frames);
+    zassert_equal(stats.bs_reductions,
+                  (CONFIG_ISOTP_FAST_RX_MAX_PACKET_COUNT - 1) % fc_opts.bs != 0 ? 1 : 0,
+                  "Unexpected number of BS reductions (%u)", stats.bs_reductions);
+
+    /* reading frees buffers, so the transfer continues */
+    ret = blocking_recv(data_buf, sizeof(data_buf), K_MSEC(100));
+    zassert_true(ret > 0, "Expected data but got %d", ret);
+    ret = check_data(data_buf, random_data, ret);
+    zassert_equal(ret, 0, "Data differ");
+
+    check_fc(FC_PCI_CTS, fc_opts.bs);
+
+    /* abort the transfer with a wrong sequence number */
+    cf_frame.data[0] = CF_PCI_BYTE_1 | ((sn + 1) & 0x0F);
+    send_frame_series(&cf_frame, 1, rx_can_id);
+
+    ret = blocking_recv(data_buf, sizeof(data_buf), K_MSEC(200));
+    zassert_equal(ret, ISOTP_N_WRONG_SN, "Expected wrong SN but got %d", ret);
+}
+#endif
+
+#if defined(CONFIG_ISOTP_FAST_BLOCKING_RECEIVE) && !defined(CONFIG_ISOTP_FAST_RX_BACKPRESSURE)
+#define RING_TEST_NUM_CF (CONFIG_ISOTP_FAST_RX_RING_SIZE + 10)
+#define RING_TEST_LEN    (DATA_SIZE_FF + DATA_SIZE_CF * RING_TEST_NUM_CF)
+
+/*
+ * Starts a reception which is not read, so the receive ring runs full. The advertised block size
+ * must never exceed the free ring slots, and FC.WAIT is sent once no slots are left.
+ *
+ * @returns sequence number of the next CF
+ */
+static int fill_receive_ring(void)
+{
+    struct frame_desired ff_frame, cf_frame;
+    struct can_frame frame;
+    int queued = 1; /* FF */
+    int sn = 1;
+    int ret;
+
+    zassert_true(sizeof(random_data) >= RING_TEST_LEN, "Test data size too small");
+
+    ff_frame.data[0] = FF_PCI_BYTE_1(RING_TEST_LEN);
+    ff_frame.data[1] = FF_PCI_BYTE_2(RING_TEST_LEN);
+    memcpy(&ff_frame.data[2], random_data, DATA_SIZE_FF);
+    ff_frame.length = DATA_SIZE_FF + 2;
+
+    filter_id = add_rx_msgq(tx_can_id, CAN_EXT_ID_MASK);
+    zassert_true((filter_id >= 0), "Negative filter number [%d]", filter_id);
+
+    send_frame_series(&ff_frame, 1, rx_can_id);
+
+    while (true) {
+        ret = k_msgq_get(&frame_msgq, &frame, K_MSEC(CONFIG_ISOTP_A_TIMEOUT));
+        zassert_equal(ret, 0, "Expected FC frame [%d]", ret);
+        if (frame.data[0] == FC_PCI_BYTE_1(FC_PCI_WAIT)) {
+            break;
+        }
+        zassert_equal(frame.data[0], FC_PCI_BYTE_1(FC_PCI_CTS),
+                      "Expected CTS but got PCI byte 0x%02x", frame.data[0]);
+
+        int bs = frame.data[1];
+        zassert_true(bs > 0 && queued + bs <= CONFIG_ISOTP_FAST_RX_RING_SIZE,
+                     "BS %d exceeds free ring slots (%d queued)", bs, queued);
+        for (int i = 0; i < bs; i++, sn++) {
+            cf_frame.data[0] = CF_PCI_BYTE_1 | (sn & 0x0F);
+            memcpy(&cf_frame.data[1], random_data + DATA_SIZE_FF + (sn - 1) * DATA_SIZE_CF,
+                   DATA_SIZE_CF);
+            cf_frame.length = CAN_DL;
+            send_frame_series(&cf_frame, 1, rx_can_id);
+        }
+        queued += bs;
+    }
+
+    zassert_equal(queued, CONFIG_ISOTP_FAST_RX_RING_SIZE, "WAIT sent with only %d frames queued",
+                  queued);
+
+    return sn;
+}
+
+ZTEST(isotp_fast_conformance, test_receive_ring_wait)
+{
+    struct frame_desired cf_frame;
+    struct can_frame frame;
+    int sn;
+    int ret;
+
+    sn = fill_receive_ring();
+
+    /* reading frees ring slots, so the transfer continues */
+    ret = blocking_recv(data_buf, sizeof(data_buf), K_MSEC(100));
+    zassert_true(ret > 0, "Expected data but got %d", ret);
+    ret = check_data(data_buf, random_data, ret);
+    zassert_equal(ret, 0, "Data differ");
+
+    ret = k_msgq_get(&frame_msgq, &frame, K_MSEC(100));
+    zassert_equal(ret, 0, "Expected FC frame [%d]", ret);
+    zassert_equal(frame.data[0], FC_PCI_BYTE_1(FC_PCI_CTS), "Expected CTS but got PCI byte 0x%02x",
+                  frame.data[0]);
+
+    /* abort the transfer with a wrong sequence number */
+    cf_frame.data[0] = CF_PCI_BYTE_1 | ((sn + 1) & 0x0F);
+    memcpy(&cf_frame.data[1], random_data, DATA_SIZE_CF);
+    cf_frame.length = CAN_DL;
+    send_frame_series(&cf_frame, 1, rx_can_id);
+
+    ret = blocking_recv(data_buf, sizeof(data_buf), K_MSEC(200));
+    zassert_equal(ret, ISOTP_N_WRONG_SN, "Expected wrong SN but got %d", ret);
+}
+
+ZTEST(isotp_fast_conformance, test_receive_ring_overflow)
+{
+    struct can_frame frame;
+    int ret;
+
+    fill_receive_ring();
+
+    /* nothing is read, so the receiver gives up after the max. number of WAIT frames */
+    for (int i = 1; i < CONFIG_ISOTP_WFTMAX; i++) {
+        ret = k_msgq_get(&frame_msgq, &frame, K_MSEC(CONFIG_ISOTP_A_TIMEOUT));
+        zassert_equal(ret, 0, "Expected FC frame [%d]", ret);
+        zassert_equal(frame.data[0], FC_PCI_BYTE_1(FC_PCI_WAIT),
+                      "Expected WAIT but got PCI byte 0x%02x", frame.data[0]);
+    }
+
+    ret = k_msgq_get(&frame_msgq, &frame, K_MSEC(CONFIG_ISOTP_A_TIMEOUT));
+    zassert_equal(ret, 0, "Expected FC frame [%d]", ret);
+    zassert_equal(frame.data[0], FC_PCI_BYTE_1(FC_PCI_OVFLW),
+                  "Expected overflow but got PCI byte 0x%02x", frame.data[0]);
+}
+#endif
+
 #ifdef CONFIG_CAN_FD_MODE
 ZTEST(isotp_fast_conformance, test_sf_length)
 {
@@ -770,6 +1242,228 @@ ZTEST(isotp_fast_conformance, test_send_length_63)
 }
 #endif
 
+#if CONFIG_ISOTP_FAST_RX_ADDR_COUNT > 0
+ZTEST(isotp_fast_conformance, test_functional_addressing)
+{
+    /* 29-bit functional address with TA 0x33 as used by ISO 15765-4 */
+    const uint32_t func_rx_can_id = 0x18DB3302;
+    const uint32_t func_tx_can_id = 0x18DB3301;
+    struct frame_desired single_frame, ff_frame;
+    struct can_frame frame;
+    int ret;
+
+#ifdef CONFIG_CAN_FD_MODE
+    single_frame.data[0] = (SF_PCI_TYPE << PCI_TYPE_POS);
+    single_frame.data[1] = DATA_SIZE_SF;
+#else
+    single_frame.data[0] = SF_PCI_BYTE_1;
+#endif
+    memcpy(&single_frame.data[SF_LEN_BYTE], random_data, DATA_SIZE_SF);
+    single_frame.length = CAN_MAX_DLEN;
+
+    ret = isotp_fast_add_rx_addr(&ctx, (struct isotp_fast_addr){ .ext_id = func_rx_can_id },
+                                 CAN_EXT_ID_MASK, true);
+    zassert_equal(ret, ISOTP_N_OK, "Adding functional address failed (%d)", ret);
+
+    /* unused addresses occupying the remaining slots */
+    for (int i = 1; i < CONFIG_ISOTP_FAST_RX_ADDR_COUNT; i++) {
+        ret = isotp_fast_add_rx_addr(&ctx, (struct isotp_fast_addr){ .ext_id = func_rx_can_id + i },
+                                     CAN_EXT_ID_MASK, false);
+        zassert_equal(ret, ISOTP_N_OK, "Adding address %d failed (%d)", i, ret);
+    }
+
+    ret = isotp_fast_add_rx_addr(&ctx, (struct isotp_fast_addr){ .ext_id = func_tx_can_id },
+                                 CAN_EXT_ID_MASK, true);
+    zassert_equal(ret, ISOTP_NO_FREE_FILTER, "Expected no free filter, got %d", ret);
+
+    send_frame_series(&single_frame, 1, func_rx_can_id);
+
+    get_sf(&ctx, DATA_SIZE_SF);
+
+    /* multi-frame messages must neither be received nor answered with flow control */
+    filter_id = add_rx_msgq(tx_can_id, CAN_EXT_ID_MASK);
+
+    ff_frame.data[0] = FF_PCI_BYTE_1(DATA_SEND_LENGTH);
+    ff_frame.data[1] = FF_PCI_BYTE_2(DATA_SEND_LENGTH);
+    memcpy(&ff_frame.data[2], random_data, DATA_SIZE_FF);
+    ff_frame.length = CAN_DL;
+
+    send_frame_series(&ff_frame, 1, func_rx_can_id);
+
+    get_sf_ignore(&ctx);
+    ret = k_msgq_get(&frame_msgq, &frame, K_NO_WAIT);
+    zassert_equal(ret, -ENOMSG, "Unexpected flow control frame");
+
+    can_remove_rx_filter(can_dev, filter_id);
+
+    /* sending is restricted to single frames as well */
+    filter_id = add_rx_msgq(func_tx_can_id, CAN_EXT_ID_MASK);
+
+    ret = isotp_fast_send_functional(&ctx, random_data, DATA_SIZE_SF,
+                                     (struct isotp_fast_addr){ .ext_id = func_tx_can_id },
+                                     INT_TO_POINTER(ISOTP_N_OK));
+    zassert_equal(ret, ISOTP_N_OK, "Send returned %d", ret);
+
+    check_frame_series(&single_frame, 1, &frame_msgq);
+
+    ret = isotp_fast_send_functional(&ctx, random_data, DATA_SEND_LENGTH,
+                                     (struct isotp_fast_addr){ .ext_id = func_tx_can_id }, NULL);
+    zassert_equal(ret, ISOTP_N_BUFFER_OVERFLW, "Send returned %d", ret);
+}
+#endif
+
+struct wheel_test_timeout
+{
+    struct isotp_fast_timeout timeout;
+    uint32_t start;
+    uint32_t elapsed;
+};
+
+static void wheel_test_handler(struct isotp_fast_timeout *timeout)
+{
+    struct wheel_test_timeout *wt = CONTAINER_OF(timeout, struct wheel_test_timeout, timeout);
+
+    wt->elapsed = k_uptime_get_32() - wt->start;
+}
+
+ZTEST(isotp_fast_conformance, test_timeout_wheel)
+{
+    /* short, level 1 and beyond the range of level 1 (with the default tick) */
+    const uint32_t durations[] = { 10, 300, 2000 };
+    struct wheel_test_timeout wt[ARRAY_SIZE(durations)];
+    struct wheel_test_timeout stopped;
+
+    for (int i = 0; i < ARRAY_SIZE(wt); i++) {
+        isotp_fast_timeout_init(&wt[i].timeout, wheel_test_handler);
+        wt[i].elapsed = 0;
+    }
+    isotp_fast_timeout_init(&stopped.timeout, wheel_test_handler);
+    stopped.elapsed = 0;
+
+    for (int i = 0; i < ARRAY_SIZE(wt); i++) {
+        wt[i].start = k_uptime_get_32();
+        isotp_fast_timeout_start(&wt[i].timeout, durations[i]);
+    }
+    stopped.start = k_uptime_get_32();
+    isotp_fast_timeout_start(&stopped.timeout, 50);
+
+    /* restarting postpones the expiry */
+    k_sleep(K_MSEC(5));
+    wt[0].start = k_uptime_get_32();
+    isotp_fast_timeout_start(&wt[0].timeout, durations[0]);
+    isotp_fast_timeout_stop(&stopped.timeout);
+
+    k_sleep(K_MSEC(durations[ARRAY_SIZE(durations) - 1] + 2 * CONFIG_ISOTP_FAST_TIMER_WHEEL_TICK_MS
+                   + 10));
+
+    for (int i = 0; i < ARRAY_SIZE(wt); i++) {
+        zassert_true(wt[i].elapsed >= durations[i], "Timeout %d too early (%d ms)", i,
+                     wt[i].elapsed);
+        zassert_true(wt[i].elapsed <= durations[i] + 2 * CONFIG_ISOTP_FAST_TIMER_WHEEL_TICK_MS + 5,
+                     "Timeout %d too late (%d ms)", i, wt[i].elapsed);
+    }
+    zassert_equal(stopped.elapsed, 0, "Stopped timeout expired");
+}
+
+#if defined(CONFIG_ISOTP_FAST_TX_PIPELINE)                                                       \
+    && DT_NODE_HAS_COMPAT(DT_CHOSEN(zephyr_canbus), zephyr_can_loopback)
+#define FILLER_CAN_ID 0x123
+
+static K_SEM_DEFINE(mailbox_release_sem, 0, 1);
+static atomic_t mailboxes_blocked;
+
+static void filler_tx_callback(const struct device *dev, int error, void *user_data)
+{}
+
+static void fill_mailboxes(void)
+{
+    struct can_frame frame = { .id = FILLER_CAN_ID, .dlc = 0 };
+
+    while (can_send(can_dev, &frame, K_NO_WAIT, filler_tx_callback, NULL) == 0) {
+    }
+}
+
+/* runs in the loopback thread before the ISO-TP context sees the FC */
+static void fc_fill_callback(const struct device *dev, struct can_frame *frame, void *user_data)
+{
+    if (atomic_get(&mailboxes_blocked)) {
+        fill_mailboxes();
+    }
+}
+
+/* replaces the dequeued filler frame and stalls the loopback thread until released */
+static void filler_rx_callback(const struct device *dev, struct can_frame *frame,
+                               void *user_data)
+{
+    if (atomic_get(&mailboxes_blocked)) {
+        fill_mailboxes();
+        k_sem_take(&mailbox_release_sem, K_FOREVER);
+    }
+}
+
+ZTEST(isotp_fast_conformance, test_send_mailboxes_busy)
+{
+    int ret, fc_filter_id, filler_filter_id;
+    uint32_t start_time, time_diff;
+    struct frame_desired ff_frame, fc_frame;
+    struct can_filter fc_filter = {
+        .flags = CAN_FILTER_IDE,
+        .id = rx_can_id,
+        .mask = CAN_EXT_ID_MASK,
+    };
+    struct can_filter filler_filter = {
+        .id = FILLER_CAN_ID,
+        .mask = CAN_STD_ID_MASK,
+    };
+
+    ff_frame.data[0] = FF_PCI_BYTE_1(DATA_SEND_LENGTH);
+    ff_frame.data[1] = FF_PCI_BYTE_2(DATA_SEND_LENGTH);
+    memcpy(&ff_frame.data[2], random_data, DATA_SIZE_FF);
+    ff_frame.length = CAN_DL;
+
+    fc_frame.data[0] = FC_PCI_BYTE_1(FC_PCI_CTS);
+    fc_frame.data[1] = FC_PCI_BYTE_2(0);
+    fc_frame.data[2] = FC_PCI_BYTE_3(0);
+    fc_frame.length = DATA_SIZE_FC;
+
+    /* re-bind so that the FC filter of the test is called before the one of the context */
+    isotp_fast_unbind(&ctx);
+    fc_filter_id = can_add_rx_filter(can_dev, fc_fill_callback, NULL, &fc_filter);
+    zassert_true((fc_filter_id >= 0), "Negative filter number [%d]", fc_filter_id);
+    filler_filter_id = can_add_rx_filter(can_dev, filler_rx_callback, NULL, &filler_filter);
+    zassert_true((filler_filter_id >= 0), "Negative filter number [%d]", filler_filter_id);
+    isotp_fast_bind(&ctx, can_dev, rx_addr, &fc_opts, isotp_fast_recv_handler, NULL,
+                    isotp_fast_recv_error_handler, isotp_fast_sent_handler);
+
+    filter_id = add_rx_msgq(tx_can_id, CAN_EXT_ID_MASK);
+    zassert_true((filter_id >= 0), "Negative filter number [%d]", filter_id);
+
+    k_sem_reset(&send_compl_sem);
+    ret = isotp_fast_send(&ctx, random_data, DATA_SEND_LENGTH, tx_addr,
+                          INT_TO_POINTER(ISOTP_N_TIMEOUT_A));
+    zassert_equal(ret, ISOTP_N_OK, "Send returned %d", ret);
+
+    check_frame_series(&ff_frame, 1, &frame_msgq);
+
+    /* no CF can be queued after the FC, so the sender has to give up after N_As */
+    atomic_set(&mailboxes_blocked, 1);
+    send_frame_series(&fc_frame, 1, rx_can_id);
+
+    start_time = k_uptime_get_32();
+    ret = k_sem_take(&send_compl_sem, K_MSEC(CONFIG_ISOTP_A_TIMEOUT + 100));
+    time_diff = k_uptime_get_32() - start_time;
+
+    atomic_set(&mailboxes_blocked, 0);
+    k_sem_give(&mailbox_release_sem);
+    k_msleep(10);
+    can_remove_rx_filter(can_dev, fc_filter_id);
+    can_remove_rx_filter(can_dev, filler_filter_id);
+
+    zassert_equal(ret, 0, "Timeout too late");
+    zassert_true(time_diff + 1 >= CONFIG_ISOTP_A_TIMEOUT, "Timeout too early (%dms)", time_diff);
+}
+#endif
+
 void *isotp_fast_conformance_setup(void)
 {
     int ret;
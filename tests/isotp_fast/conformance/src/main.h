@@ -9,6 +9,7 @@
 #include <canbus/isotp_fast.h>
 #include <strings.h>
 #include <zephyr/drivers/can.h>
+#include <zephyr/sys/byteorder.h>
 #include <zephyr/sys/util.h>
 #include <zephyr/ztest.h>
 
@@ -22,8 +23,10 @@
 #define DATA_SIZE_CF          (CAN_MAX_DLEN - 1)
 #define DATA_SIZE_SF_EXT      (CAN_MAX_DLEN - 2)
 #define DATA_SIZE_FF          (CAN_MAX_DLEN - 2)
+#define DATA_SIZE_FF_ESC      (CAN_MAX_DLEN - 6)
 #define CAN_DL                CAN_MAX_DLEN
 #define DATA_SEND_LENGTH      272
+#define DATA_SEND_LENGTH_ESC  (5 * 1024)
 #define SF_PCI_TYPE           0
 #define SF_PCI_BYTE_1         ((SF_PCI_TYPE << PCI_TYPE_POS) | DATA_SIZE_SF)
 #define SF_PCI_BYTE_2_EXT     ((SF_PCI_TYPE << PCI_TYPE_POS) | DATA_SIZE_SF_EXT)
@@ -44,6 +47,7 @@
 #define STMIN_VAL_1           5
 #define STMIN_VAL_2           50
 #define STMIN_UPPER_TOLERANCE 5
+#define STMIN_VAL_US          0xF5 /* 500 us */
 
 #if defined(CONFIG_ISOTP_ENABLE_TX_PADDING) || defined(CONFIG_ISOTP_ENABLE_TX_PADDING)
 #define DATA_SIZE_FC CAN_DL
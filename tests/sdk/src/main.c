@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) The ThingSet Project Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include <thingset.h>
+#include <thingset/sdk.h>
+
+/* live reports are published once per second */
+#define TEST_REPORT_TIMEOUT K_MSEC(1500)
+
+static struct k_sem report_sem;
+static const uint8_t *report_ptr;
+static char report_str[200];
+
+/* test data objects */
+static float test_float = 1234.56F;
+static int32_t test_int = 42;
+
+THINGSET_ADD_GROUP(THINGSET_ID_ROOT, 0x200, "Test", THINGSET_NO_CALLBACK);
+THINGSET_ADD_ITEM_FLOAT(0x200, 0x201, "wFloat", &test_float, 1, THINGSET_ANY_RW, TS_SUBSET_LIVE);
+THINGSET_ADD_ITEM_INT32(0x200, 0x202, "sInt", &test_int, THINGSET_ANY_RW, TS_SUBSET_NVM);
+
+static void report_callback(const uint8_t *buf, size_t len, void *user_data)
+{
+    if (len < sizeof(report_str)) {
+        /* the address tells whether the report was served from the cache */
+        report_ptr = buf;
+        memcpy(report_str, buf, len);
+        report_str[len] = '\0';
+        k_sem_give(&report_sem);
+    }
+}
+
+static struct thingset_sdk_report_sink report_sink = {
+    .callback = report_callback,
+    .format = THINGSET_TXT_NAMES_VALUES,
+};
+
+static void update_float(float value)
+{
+    char req[50];
+    uint8_t rsp[50];
+
+    int req_len = snprintf(req, sizeof(req), "=Test {\"wFloat\":%.1f}", (double)value);
+    int rsp_len = thingset_sdk_process_message((uint8_t *)req, req_len, rsp, sizeof(rsp));
+    zassert_true(rsp_len > 0, "processing update failed: %d", rsp_len);
+    zassert_mem_equal(rsp, ":84", 3, "update not successful");
+}
+
+static const struct thingset_data_object *get_object(const char *path)
+{
+    int index;
+
+    return thingset_get_object_by_path(&ts, path, strlen(path), &index);
+}
+
+#ifndef CONFIG_THINGSET_REPORT_CACHE_SUPPRESS_UNCHANGED
+
+/* @returns address of the cached live report */
+static const uint8_t *fill_report_cache(void)
+{
+    thingset_sdk_mark_dirty(NULL);
+    k_sem_reset(&report_sem);
+
+    /* the first report is encoded, the second one comes from the cache */
+    zassert_equal(k_sem_take(&report_sem, TEST_REPORT_TIMEOUT), 0, "no report received");
+    zassert_equal(k_sem_take(&report_sem, TEST_REPORT_TIMEOUT), 0, "no report received");
+
+    return report_ptr;
+}
+
+ZTEST(thingset_sdk, test_report_cache_unchanged)
+{
+    char encoded[sizeof(report_str)];
+
+    thingset_sdk_mark_dirty(NULL);
+    k_sem_reset(&report_sem);
+
+    zassert_equal(k_sem_take(&report_sem, TEST_REPORT_TIMEOUT), 0, "no report received");
+    const uint8_t *encoded_ptr = report_ptr;
+    strcpy(encoded, report_str);
+
+    zassert_equal(k_sem_take(&report_sem, TEST_REPORT_TIMEOUT), 0, "no report received");
+    zassert_not_equal(report_ptr, encoded_ptr, "unchanged report was encoded again");
+    zassert_str_equal(report_str, encoded);
+
+    /* still served from the cache */
+    const uint8_t *cached_ptr = report_ptr;
+    zassert_equal(k_sem_take(&report_sem, TEST_REPORT_TIMEOUT), 0, "no report received");
+    zassert_equal(report_ptr, cached_ptr, "unchanged report was encoded again");
+}
+
+ZTEST(thingset_sdk, test_report_cache_invalidated_by_update)
+{
+    float initial = test_float;
+    const uint8_t *cached_ptr = fill_report_cache();
+
+    update_float(2.5F);
+
+    zassert_equal(k_sem_take(&report_sem, TEST_REPORT_TIMEOUT), 0, "no report received");
+    zassert_not_equal(report_ptr, cached_ptr, "outdated report sent from cache");
+    zassert_not_null(strstr(report_str, "\"wFloat\":2.5"), "wrong report: %s", report_str);
+
+    update_float(initial);
+}
+
+ZTEST(thingset_sdk, test_report_cache_invalidated_by_object)
+{
+    const uint8_t *cached_ptr = fill_report_cache();
+
+    /* items outside the live subset keep the cached report */
+    thingset_sdk_mark_dirty(get_object("Test/sInt"));
+    zassert_equal(k_sem_take(&report_sem, TEST_REPORT_TIMEOUT), 0, "no report received");
+    zassert_equal(report_ptr, cached_ptr, "report encoded for item outside of subset");
+
+    thingset_sdk_mark_dirty(get_object("Test/wFloat"));
+    zassert_equal(k_sem_take(&report_sem, TEST_REPORT_TIMEOUT), 0, "no report received");
+    zassert_not_equal(report_ptr, cached_ptr, "outdated report sent from cache");
+}
+
+#else
+
+ZTEST(thingset_sdk, test_report_cache_keep_alive)
+{
+    const int max_suppressed = CONFIG_THINGSET_REPORT_CACHE_MAX_SUPPRESSED;
+    float initial = test_float;
+
+    /* a changed value is reported in the next period */
+    update_float(2.5F);
+    k_sem_reset(&report_sem);
+    zassert_equal(k_sem_take(&report_sem, TEST_REPORT_TIMEOUT), 0, "changed report suppressed");
+
+    /* unchanged reports are suppressed until the max. number of periods is reached */
+    zassert_not_equal(k_sem_take(&report_sem, K_MSEC(max_suppressed * 1000 + 500)), 0,
+                      "unchanged report not suppressed");
+    zassert_equal(k_sem_take(&report_sem, K_MSEC(1000)), 0, "keep-alive report not sent");
+
+    update_float(initial);
+}
+
+#endif /* CONFIG_THINGSET_REPORT_CACHE_SUPPRESS_UNCHANGED */
+
+#ifdef CONFIG_THINGSET_OBSERVE
+
+/* changes are detected at the next poll, so reports can be delayed by up to this time */
+#define TEST_OBSERVE_TIMEOUT K_MSEC(CONFIG_THINGSET_OBSERVE_POLL_INTERVAL * 2)
+
+static struct k_sem observe_sem;
+static char observe_str[200];
+
+static void observe_callback(const uint8_t *buf, size_t len, void *user_data)
+{
+    if (len < sizeof(observe_str)) {
+        memcpy(observe_str, buf, len);
+        observe_str[len] = '\0';
+        k_sem_give(&observe_sem);
+    }
+}
+
+static void observe_start(struct thingset_sdk_observer *obs)
+{
+    k_sem_reset(&observe_sem);
+
+    int err = thingset_sdk_observe(obs);
+    zassert_equal(err, 0, "observing %s failed: %d", obs->path, err);
+
+    /* the first report is sent immediately */
+    zassert_equal(k_sem_take(&observe_sem, TEST_OBSERVE_TIMEOUT), 0, "initial report missing");
+}
+
+ZTEST(thingset_sdk, test_observe_deadband)
+{
+    struct thingset_sdk_observer obs = {
+        .callback = observe_callback,
+        .format = THINGSET_TXT_NAMES_VALUES,
+        .path = "Test/wFloat",
+        .deadband = 1.0F,
+    };
+    float initial = test_float;
+
+    observe_start(&obs);
+
+    /* observing again must not reset the running observer, which would trigger a report */
+    zassert_equal(thingset_sdk_observe(&obs), -EALREADY);
+    zassert_not_equal(k_sem_take(&observe_sem, K_MSEC(500)), 0, "observer was reset");
+
+    test_float = initial + 0.5F;
+    zassert_not_equal(k_sem_take(&observe_sem, K_MSEC(500)), 0, "change within deadband reported");
+
+    test_float = initial + 2.0F;
+    zassert_equal(k_sem_take(&observe_sem, TEST_OBSERVE_TIMEOUT), 0, "change not reported");
+
+    zassert_equal(thingset_sdk_unobserve(&obs), 0);
+    test_float = initial;
+}
+
+ZTEST(thingset_sdk, test_observe_pmin)
+{
+    struct thingset_sdk_observer obs = {
+        .callback = observe_callback,
+        .format = THINGSET_TXT_NAMES_VALUES,
+        .path = "Test/wFloat",
+        .pmin = 500,
+    };
+    float initial = test_float;
+
+    observe_start(&obs);
+
+    /* a change right after a report is delayed until pmin elapsed */
+    test_float = initial + 5.0F;
+    zassert_not_equal(k_sem_take(&observe_sem, K_MSEC(obs.pmin - 100)), 0,
+                      "change reported before pmin");
+    zassert_equal(k_sem_take(&observe_sem, TEST_OBSERVE_TIMEOUT), 0, "change not reported");
+
+    zassert_equal(thingset_sdk_unobserve(&obs), 0);
+    test_float = initial;
+}
+
+ZTEST(thingset_sdk, test_observe_pmax)
+{
+    struct thingset_sdk_observer obs = {
+        .callback = observe_callback,
+        .format = THINGSET_TXT_NAMES_VALUES,
+        .path = "Test/wFloat",
+        .pmax = 500,
+    };
+
+    observe_start(&obs);
+
+    /* an unchanged value is reported again after pmax, but not earlier */
+    for (int i = 0; i < 2; i++) {
+        zassert_not_equal(k_sem_take(&observe_sem, K_MSEC(obs.pmax - 100)), 0,
+                          "unchanged value reported before pmax");
+        zassert_equal(k_sem_take(&observe_sem, TEST_OBSERVE_TIMEOUT), 0,
+                      "unchanged value not reported after pmax");
+    }
+
+    zassert_equal(thingset_sdk_unobserve(&obs), 0);
+}
+
+ZTEST(thingset_sdk, test_observe_group)
+{
+    struct thingset_sdk_observer obs = {
+        .callback = observe_callback,
+        .format = THINGSET_TXT_NAMES_VALUES,
+        .path = "Test",
+    };
+    int32_t initial = test_int;
+
+    observe_start(&obs);
+    zassert_not_null(strstr(observe_str, "\"sInt\":42"), "wrong report: %s", observe_str);
+
+    zassert_not_equal(k_sem_take(&observe_sem, K_MSEC(500)), 0, "unchanged group reported");
+
+    /* changes of any item change the CRC of the encoded group */
+    test_int = initial + 1;
+    zassert_equal(k_sem_take(&observe_sem, TEST_OBSERVE_TIMEOUT), 0, "change not reported");
+    zassert_not_null(strstr(observe_str, "\"sInt\":43"), "wrong report: %s", observe_str);
+
+    zassert_equal(thingset_sdk_unobserve(&obs), 0);
+    zassert_equal(thingset_sdk_unobserve(&obs), -ENOENT);
+    test_int = initial;
+}
+
+#endif /* CONFIG_THINGSET_OBSERVE */
+
+#ifdef CONFIG_THINGSET_SDK_STATS
+
+/* records a latency of the given duration as if the phase had started that long ago */
+static void stats_record_us(enum thingset_sdk_stats_phase phase, uint32_t us)
+{
+    uint32_t start = thingset_sdk_stats_timestamp() - k_us_to_cyc_ceil32(us);
+
+    thingset_sdk_stats_record(THINGSET_SDK_STATS_SHELL, phase, start);
+}
+
+ZTEST(thingset_sdk, test_stats_record)
+{
+    struct thingset_sdk_latency_stats stats;
+
+    thingset_sdk_reset_latency_stats();
+
+    /* durations well within buckets 1 (2-3 us), 6 (64-127 us) and 12 (4096-8191 us) */
+    stats_record_us(THINGSET_SDK_STATS_PROCESS, 3);
+    stats_record_us(THINGSET_SDK_STATS_PROCESS, 100);
+    stats_record_us(THINGSET_SDK_STATS_PROCESS, 110);
+    stats_record_us(THINGSET_SDK_STATS_PROCESS, 5000);
+
+    zassert_equal(thingset_sdk_get_latency_stats(THINGSET_SDK_STATS_SHELL,
+                                                 THINGSET_SDK_STATS_PROCESS, &stats),
+                  0);
+    zassert_equal(stats.count, 4);
+    zassert_within(stats.max_us, 5000, 10, "wrong max. latency %u", stats.max_us);
+    zassert_within(stats.total_us, 5213, 40, "wrong total latency %llu",
+                   (unsigned long long)stats.total_us);
+    zassert_equal(stats.hist[1], 1);
+    zassert_equal(stats.hist[6], 2);
+    zassert_equal(stats.hist[12], 1);
+
+    /* other phases and transports are not affected */
+    zassert_equal(thingset_sdk_get_latency_stats(THINGSET_SDK_STATS_SHELL,
+                                                 THINGSET_SDK_STATS_TOTAL, &stats),
+                  0);
+    zassert_equal(stats.count, 0);
+    zassert_equal(thingset_sdk_get_latency_stats(THINGSET_SDK_STATS_CAN,
+                                                 THINGSET_SDK_STATS_PROCESS, &stats),
+                  0);
+    zassert_equal(stats.count, 0);
+
+    /* latencies beyond the last bucket are counted in it */
+    stats_record_us(THINGSET_SDK_STATS_TOTAL, 10 * USEC_PER_SEC);
+    zassert_equal(thingset_sdk_get_latency_stats(THINGSET_SDK_STATS_SHELL,
+                                                 THINGSET_SDK_STATS_TOTAL, &stats),
+                  0);
+    zassert_equal(stats.hist[CONFIG_THINGSET_SDK_STATS_BUCKETS - 1], 1);
+
+    zassert_equal(thingset_sdk_get_latency_stats(THINGSET_SDK_STATS_TRANSPORT_COUNT,
+                                                 THINGSET_SDK_STATS_PROCESS, &stats),
+                  -EINVAL);
+}
+
+static void assert_summary_item(const char *rsp, const char *name, uint32_t value)
+{
+    char item[50];
+
+    snprintf(item, sizeof(item), "\"%s\":%u", name, value);
+    const char *pos = strstr(rsp, item);
+    zassert_true(pos != NULL && !isdigit((int)pos[strlen(item)]), "%s not in summary: %s", item,
+                 rsp);
+}
+
+ZTEST(thingset_sdk, test_stats_summary_and_reset)
+{
+    struct thingset_sdk_latency_stats stats;
+    char req[] = "?_Stats";
+    char reset_req[] = "!_Stats/xReset []";
+    char rsp[500];
+    int rsp_len;
+
+    thingset_sdk_reset_latency_stats();
+
+    stats_record_us(THINGSET_SDK_STATS_PROCESS, 100);
+    stats_record_us(THINGSET_SDK_STATS_PROCESS, 300);
+    stats_record_us(THINGSET_SDK_STATS_TOTAL, 1000);
+
+    /* the summary is updated when the group is read */
+    rsp_len = thingset_sdk_process_message((uint8_t *)req, strlen(req), (uint8_t *)rsp,
+                                           sizeof(rsp) - 1);
+    zassert_true(rsp_len > 0, "reading _Stats failed: %d", rsp_len);
+    rsp[rsp_len] = '\0';
+    zassert_mem_equal(rsp, ":85", 3, "reading _Stats failed: %s", rsp);
+
+    thingset_sdk_get_latency_stats(THINGSET_SDK_STATS_SHELL, THINGSET_SDK_STATS_PROCESS, &stats);
+    assert_summary_item(rsp, "rShellReqs", 2);
+    assert_summary_item(rsp, "rShellProcMax_us", stats.max_us);
+    thingset_sdk_get_latency_stats(THINGSET_SDK_STATS_SHELL, THINGSET_SDK_STATS_TOTAL, &stats);
+    assert_summary_item(rsp, "rShellTotalMax_us", stats.max_us);
+    assert_summary_item(rsp, "rCANReqs", 0);
+
+    rsp_len = thingset_sdk_process_message((uint8_t *)reset_req, strlen(reset_req), (uint8_t *)rsp,
+                                           sizeof(rsp) - 1);
+    zassert_true(rsp_len > 0 && rsp[1] == '8', "calling xReset failed: %d", rsp_len);
+
+    for (int phase = 0; phase < THINGSET_SDK_STATS_PHASE_COUNT; phase++) {
+        zassert_equal(thingset_sdk_get_latency_stats(THINGSET_SDK_STATS_SHELL, phase, &stats), 0);
+        zassert_equal(stats.count, 0, "%s not reset", thingset_sdk_stats_phase_name(phase));
+        zassert_equal(stats.max_us, 0, "%s not reset", thingset_sdk_stats_phase_name(phase));
+    }
+}
+
+#endif /* CONFIG_THINGSET_SDK_STATS */
+
+static void *thingset_sdk_setup(void)
+{
+    k_sem_init(&report_sem, 0, 1);
+#ifdef CONFIG_THINGSET_OBSERVE
+    k_sem_init(&observe_sem, 0, 1);
+#endif
+
+    thingset_sdk_add_live_report_sink(&report_sink);
+
+    return NULL;
+}
+
+static void thingset_sdk_before(void *fixture)
+{
+    live_reporting_enable = true;
+}
+
+static void thingset_sdk_after(void *fixture)
+{
+    live_reporting_enable = false;
+}
+
+ZTEST_SUITE(thingset_sdk, NULL, thingset_sdk_setup, thingset_sdk_before, thingset_sdk_after, NULL);